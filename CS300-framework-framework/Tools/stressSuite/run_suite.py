@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+########################################################################
+# Runs the headless benchmark over the object/light sweeps of a suite
+# definition and plots how frame time scales.
+#
+#   python3 Tools/stressSuite/run_suite.py [--suite suite.json]
+#                                          [--out stress_results] [--sweep NAME]
+#                                          [--plot-only]
+#
+# Run from the project directory after `make benchmark`.  Every run's
+# report is kept as <out>/<sweep>_<objects>_<lights>.json, the summary
+# goes to <out>/results.csv and one plot per sweep to <out>/<sweep>.png
+# (needs matplotlib; without it only the CSV is written).  Runs whose
+# report already exists are skipped, so an interrupted suite resumes.
+#
+# Only the first MAX_SHADER_LIGHTS (32) point lights are shaded; the
+# report's scene.shadedLights says how many were.  Past that count a
+# lights curve measures the CPU update and gizmo cost only, and the
+# plots mark where it starts.
+########################################################################
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+
+SERIES = ["cpuFrameMs", "gpuFrameMs", "wallFrameMs"]
+
+
+def report_path(out_dir, sweep, objects, lights):
+    return os.path.join(out_dir, "%s_%d_%d.json" % (sweep["name"], objects, lights))
+
+
+def run(suite, sweep, objects, lights, path):
+    command = [suite["benchmark"],
+               "--frames", str(suite["frames"]), "--warmup", str(suite["warmup"]),
+               "--width", str(suite["width"]), "--height", str(suite["height"]),
+               "--seed", str(suite["seed"]), "--moving", str(suite["moving"]),
+               "--objects", str(objects), "--lights", str(lights),
+               "--out", path]
+    print("%s: %d objects, %d lights" % (sweep["name"], objects, lights), flush=True)
+    if subprocess.call(command) != 0:
+        print("  failed", file=sys.stderr)
+
+
+def collect(suite, out_dir, names):
+    rows = []
+    for sweep in suite["sweeps"]:
+        if names and sweep["name"] not in names:
+            continue
+        for objects in sweep["objects"]:
+            for lights in sweep["lights"]:
+                path = report_path(out_dir, sweep, objects, lights)
+                if not os.path.exists(path):
+                    continue
+                with open(path) as f:
+                    report = json.load(f)
+                row = {"sweep": sweep["name"], "objects": objects, "lights": lights,
+                       "shadedLights": report["scene"]["shadedLights"],
+                       "drawCalls": report["drawCalls"]["mean"],
+                       "residentMB": report["memory"]["residentMB"]}
+                for series in SERIES:
+                    for stat in ("p50", "p95", "p99"):
+                        row["%s_%s" % (series, stat)] = report[series][stat]
+                rows.append(row)
+    return rows
+
+
+def write_csv(rows, path):
+    if not rows:
+        return
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+# "1000 lights (32 shaded)" when a line's lights are not all shaded
+def line_label(value, line_key, line):
+    label = "%d %s" % (value, line_key)
+    if line_key == "lights" and line[0]["shadedLights"] < value:
+        label += " (%d shaded)" % line[0]["shadedLights"]
+    return label
+
+
+# A dotted line at the shaded light count once the sweep goes past it
+def mark_shading_limit(axis, rows):
+    shaded = max(row["shadedLights"] for row in rows)
+    if any(row["lights"] > shaded for row in rows):
+        axis.axvline(shaded, color="gray", linestyle=":", label="%d shaded, CPU cost only past here" % shaded)
+
+
+# Frame time against the swept count on log-log axes, one line per
+# value of the other count; a slope of 1 is linear scaling.
+def plot(suite, rows, out_dir):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("matplotlib not found, skipping the plots")
+        return
+
+    for sweep in suite["sweeps"]:
+        sweep_rows = [row for row in rows if row["sweep"] == sweep["name"]]
+        if not sweep_rows:
+            continue
+        by_objects = len(sweep["objects"]) >= len(sweep["lights"])
+        x_key, line_key = ("objects", "lights") if by_objects else ("lights", "objects")
+        figure, axes = plt.subplots(1, 2, figsize=(12, 5))
+        for axis, series in zip(axes, ("cpuFrameMs", "gpuFrameMs")):
+            for value in sorted(set(row[line_key] for row in sweep_rows)):
+                line = sorted((row for row in sweep_rows if row[line_key] == value), key=lambda row: row[x_key])
+                xs = [row[x_key] for row in line]
+                name = line_label(value, line_key, line)
+                axis.plot(xs, [row[series + "_p50"] for row in line], marker="o", label="%s, p50" % name)
+                axis.plot(xs, [row[series + "_p95"] for row in line], linestyle="--", label="%s, p95" % name)
+            if x_key == "lights":
+                mark_shading_limit(axis, sweep_rows)
+            axis.set_xscale("log")
+            axis.set_yscale("log")
+            axis.set_xlabel(x_key)
+            axis.set_ylabel(series.replace("FrameMs", " frame (ms)"))
+            axis.grid(True, which="both", alpha=0.3)
+            axis.legend(fontsize="small")
+        figure.suptitle("%s, %dx%d, seed %d" % (sweep["name"], suite["width"], suite["height"], suite["seed"]))
+        figure.tight_layout()
+        figure.savefig(os.path.join(out_dir, sweep["name"] + ".png"))
+        plt.close(figure)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Frame time scaling over generated stress scenes")
+    parser.add_argument("--suite", default=os.path.join(here, "suite.json"))
+    parser.add_argument("--out", default="stress_results")
+    parser.add_argument("--sweep", action="append", help="only run the named sweep(s)")
+    parser.add_argument("--plot-only", action="store_true", help="summarize the reports already there")
+    args = parser.parse_args()
+
+    with open(args.suite) as f:
+        suite = json.load(f)
+    os.makedirs(args.out, exist_ok=True)
+
+    if not args.plot_only:
+        for sweep in suite["sweeps"]:
+            if args.sweep and sweep["name"] not in args.sweep:
+                continue
+            for objects in sweep["objects"]:
+                for lights in sweep["lights"]:
+                    path = report_path(args.out, sweep, objects, lights)
+                    if not os.path.exists(path):
+                        run(suite, sweep, objects, lights, path)
+
+    rows = collect(suite, args.out, args.sweep)
+    write_csv(rows, os.path.join(args.out, "results.csv"))
+    plot(suite, rows, args.out)
+    print("%d runs summarized in %s" % (len(rows), args.out))
+
+
+if __name__ == "__main__":
+    main()
@@ -4,9 +4,28 @@ in vec4 vertex;
 in vec3 vertexNormal;
 in vec3 vertexTexture;
 
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
-uniform mat4 ModelMatrix;
+// per-frame constants shared by every program, uniform block binding 0
+layout(std140) uniform FrameConstants
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+	mat4 ViewProjectionMatrix;
+	mat4 InverseViewMatrix;
+	mat4 InverseProjectionMatrix;
+	mat4 InverseViewProjectionMatrix;
+	vec3 cameraPos;
+	float time;
+	vec4 viewport;          // render width, height, 1 / width, 1 / height
+	int frameIndex;
+};
+
+// per-object constants, uniform block binding 2
+layout(std140) uniform ObjectConstants
+{
+	mat4 ModelMatrix;
+	mat4 NormalMatrix;      // inverse transpose of ModelMatrix
+	float materialShininess;
+};
 
 out vec3 worldVertex;
 out vec2 uv;
@@ -15,8 +34,8 @@ out vec3 normal;
 void main()
 {
     worldVertex = (ModelMatrix * vertex).xyz;
-    gl_Position = ProjectionMatrix*ViewMatrix*ModelMatrix*vertex;
+    gl_Position = ViewProjectionMatrix*ModelMatrix*vertex;
     uv = vertexTexture.xy;
     
-    normal = normalize(vec3(transpose(inverse(ModelMatrix)) * vec4(vertexNormal, 0.f))); 
+    normal = normalize(vec3(NormalMatrix * vec4(vertexNormal, 0.f))); 
 }
\ No newline at end of file
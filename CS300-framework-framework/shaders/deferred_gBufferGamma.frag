@@ -1,9 +1,16 @@
 #version 330
 
+#ifdef COMPACT_GBUFFER
+// Position is rebuilt from the depth buffer in the lighting pass.
+layout(location = 0) out vec2 gNormalTexture;
+layout(location = 1) out vec4 gAlbedoTexture;
+layout(location = 2) out vec4 gSpecularTexture;
+#else
 layout(location = 0) out vec3 gPositionTexture;
 layout(location = 1) out vec3 gNormalTexture;
 layout(location = 2) out vec3 gAlbedoTexture;
 layout(location = 3) out vec4 gSpecularTexture;
+#endif
 
 in vec3 worldVertex;
 in vec2 uv;
@@ -13,17 +20,46 @@ struct materialStruct
 {
 	sampler2D diffuseMap;
 	sampler2D specularMap;
-	float materialShininess;
 };
 
 uniform materialStruct material;
 
+// per-object constants, uniform block binding 2
+layout(std140) uniform ObjectConstants
+{
+	mat4 ModelMatrix;
+	mat4 NormalMatrix;      // inverse transpose of ModelMatrix
+	float materialShininess;
+};
+
+#ifdef COMPACT_GBUFFER
+// Octahedral encoding: project the unit normal onto the octahedron
+// |x|+|y|+|z| = 1 and fold the lower hemisphere over the upper one.
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeNormal(vec3 n)
+{
+	n /= (abs(n.x) + abs(n.y) + abs(n.z));
+	return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signNotZero(n.xy);
+}
+#endif
+
 void main()
 {
+#ifdef COMPACT_GBUFFER
+    gNormalTexture = encodeNormal(normalize(normal));
+    // albedo stays in its authored (sRGB) encoding so 8 bits are
+    // enough; the lighting pass linearizes it after the fetch
+    gAlbedoTexture = vec4(texture(material.diffuseMap, uv).rgb, 1.0);
+#else
     gPositionTexture = worldVertex;
     gNormalTexture = normal;
 	vec3 gamma = vec3(2.2f);
     gAlbedoTexture = pow(texture(material.diffuseMap, uv).rgb, gamma);
+#endif
     gSpecularTexture.rgb = vec3(texture(material.specularMap, uv).rgb);
-	gSpecularTexture.a = material.materialShininess;
+	gSpecularTexture.a = materialShininess;
 }
\ No newline at end of file
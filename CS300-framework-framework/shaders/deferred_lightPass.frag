@@ -13,44 +13,87 @@ struct directionLightStruct
 	vec3 direction;
 };
 
+// std140, laid out to match pointLightBlock on the CPU side
 struct pointLightStruct
 {
 	vec3 diffuse;
-	vec3 specular;
-	vec3 position;
-
 	float distance;
+	vec3 specular;
 	float constant;
+	vec3 position;
 	float linear;
 	float quadratic;
 };
 
 in vec2 uv;
+in vec2 screenUV;
 out vec3 finalRenderTexture;
 
+#ifdef COMPACT_GBUFFER
+uniform sampler2D gDepthTexture;
+#else
 uniform sampler2D gPositionTexture;
+#endif
 uniform sampler2D gNormalTexture;
 uniform sampler2D gAlbedoTexture;
 uniform sampler2D gSpecularTexture;
-uniform vec3 cameraPos;
+
+// per-frame constants shared by every program, uniform block binding 0
+layout(std140) uniform FrameConstants
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+	mat4 ViewProjectionMatrix;
+	mat4 InverseViewMatrix;
+	mat4 InverseProjectionMatrix;
+	mat4 InverseViewProjectionMatrix;
+	vec3 cameraPos;
+	float time;
+	vec4 viewport;          // render width, height, 1 / width, 1 / height
+	int frameIndex;
+};
+
+// cascaded shadow map of directionLight[0]
+const int max_cascades = 4;
+uniform sampler2DArrayShadow shadowMap;
+uniform bool shadowEnabled;
+uniform bool showCascades;
+uniform int cascadeCount;
+uniform mat4 cascadeMatrices[max_cascades];
+uniform float cascadeSplits[max_cascades];
+uniform float cascadeTexelSize[max_cascades];
 
 const int max_lights = 32;
 
-uniform ambientLightStruct ambientLight;
-uniform directionLightStruct directionLight[max_lights];
-uniform pointLightStruct pointLight[max_lights];
+// written into the frame's range of the ring buffer once per frame
+layout(std140) uniform lightBlock
+{
+	directionLightStruct directionLight[max_lights];
+	pointLightStruct pointLight[max_lights];
+	ambientLightStruct ambientLight;
+};
+
+// point light shadows: one 3 x 2 tile of faces per light in layer 1 of the atlas
+uniform sampler2DArrayShadow pointShadowAtlas;
+uniform bool pointShadowEnabled;
+uniform float pointShadowNear;
+uniform vec4 pointShadowTile[max_lights];   // xy = tile origin, z = face size (uv), w = has tile
+uniform float pointShadowFar[max_lights];
+// +X, -X, +Y, -Y, +Z, -Z, matching pointShadowAtlas.cpp
+const vec3 cubeFaceForward[6] = vec3[](vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1));
+const vec3 cubeFaceUp[6] = vec3[](vec3(0, -1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1), vec3(0, -1, 0), vec3(0, -1, 0));
 
-vec3 directionLightCalculation(directionLightStruct dirLight, vec3 normal, vec3 eye, vec3 materialColor, float materialShininess, vec3 materialSpecular, vec3 ambient)
+vec3 directionLightCalculation(directionLightStruct dirLight, vec3 normal, vec3 eye, vec3 materialColor, float materialShininess, vec3 materialSpecular, vec3 ambient, float shadow)
 {
 	vec3 lightVec = -dirLight.direction;
 	float dotLN = max(0.0, dot(lightVec, normal));
 	vec3 diffuse = dirLight.diffuse * dotLN * materialColor;	
 	vec3 halfwayVec = normalize(lightVec + eye);
 	float BlinnSpecular = pow(max(dot(normal, halfwayVec), 0.f), materialShininess);
-	return (ambient + diffuse + (dirLight.specular * BlinnSpecular * materialSpecular));
+	return (ambient + (diffuse + (dirLight.specular * BlinnSpecular * materialSpecular)) * shadow);
 }
 
-vec3 pointLightCalculation(pointLightStruct ptLight, vec3 position, vec3 normal, vec3 eye, vec3 materialColor, float materialShininess, vec3 materialSpecular, vec3 ambient)
+vec3 pointLightCalculation(pointLightStruct ptLight, vec3 position, vec3 normal, vec3 eye, vec3 materialColor, float materialShininess, vec3 materialSpecular, vec3 ambient, float shadow)
 {
 	vec3 lightVec = ptLight.position - position;
 	float distance = length(lightVec);
@@ -66,13 +109,102 @@ vec3 pointLightCalculation(pointLightStruct ptLight, vec3 position, vec3 normal,
 	}
 
 
-	return ((ambient * attenuation) + (diffuse * attenuation) + ((ptLight.specular * BlinnSpecular * materialSpecular) * attenuation));
+	return ((ambient * attenuation) + ((diffuse * attenuation) + ((ptLight.specular * BlinnSpecular * materialSpecular) * attenuation)) * shadow);
+}
+
+#ifdef COMPACT_GBUFFER
+vec3 decodeNormal(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+vec3 reconstructPosition(vec2 texCoord, vec2 screenCoord)
+{
+	float depth = texture(gDepthTexture, texCoord).r;
+	vec4 ndc = vec4(screenCoord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 world = InverseViewProjectionMatrix * ndc;
+	return world.xyz / world.w;
+}
+#endif
+
+int selectCascade(vec3 position)
+{
+	float viewDepth = -(ViewMatrix * vec4(position, 1.0)).z;
+	for(int i = 0; i < cascadeCount; ++i)
+	{
+		if(viewDepth < cascadeSplits[i])
+			return i;
+	}
+	return -1;
+}
+
+// 1 = lit, 0 = in shadow.  Four hardware PCF taps, offset along the
+// normal by about a texel to keep acne off surfaces facing away.
+float shadowCalculation(int cascade, vec3 position, vec3 normal)
+{
+	if(!shadowEnabled || cascade < 0)
+		return 1.0;
+
+	vec3 offsetPosition = position + normal * cascadeTexelSize[cascade] * 1.5;
+	vec4 lightSpace = cascadeMatrices[cascade] * vec4(offsetPosition, 1.0);
+	vec3 coord = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+	vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+	float lit = 0.0;
+	lit += texture(shadowMap, vec4(coord.xy + vec2(-0.5, -0.5) * texel, cascade, coord.z));
+	lit += texture(shadowMap, vec4(coord.xy + vec2( 0.5, -0.5) * texel, cascade, coord.z));
+	lit += texture(shadowMap, vec4(coord.xy + vec2(-0.5,  0.5) * texel, cascade, coord.z));
+	lit += texture(shadowMap, vec4(coord.xy + vec2( 0.5,  0.5) * texel, cascade, coord.z));
+	return lit * 0.25;
+}
+
+float pointShadowCalculation(int light, vec3 position, vec3 normal)
+{
+	vec4 tile = pointShadowTile[light];
+	if(!pointShadowEnabled || tile.w == 0.0)
+		return 1.0;
+
+	vec3 toPosition = position - pointLight[light].position;
+	vec3 axis = abs(toPosition);
+	int face;
+	if(axis.x >= axis.y && axis.x >= axis.z)
+		face = toPosition.x > 0.0 ? 0 : 1;
+	else if(axis.y >= axis.z)
+		face = toPosition.y > 0.0 ? 2 : 3;
+	else
+		face = toPosition.z > 0.0 ? 4 : 5;
+
+	// same view (lookAt) and 90 degree projection the face was drawn with
+	vec3 forward = cubeFaceForward[face];
+	float faceTexels = tile.z * float(textureSize(pointShadowAtlas, 0).x);
+	toPosition += normal * (2.0 * dot(toPosition, forward) / faceTexels) * 1.5;
+	float viewDepth = dot(toPosition, forward);
+	vec3 side = normalize(cross(forward, cubeFaceUp[face]));
+	vec3 up = cross(side, forward);
+	vec2 ndc = vec2(dot(toPosition, side), dot(toPosition, up)) / viewDepth;
+	float n = pointShadowNear;
+	float f = pointShadowFar[light];
+	float depth = ((f + n) / (f - n) - (2.0 * f * n) / ((f - n) * viewDepth)) * 0.5 + 0.5;
+
+	// stay half a texel inside the face so filtering never reads its neighbour
+	float halfTexel = 0.5 / faceTexels;
+	vec2 faceUV = clamp(ndc * 0.5 + 0.5, vec2(halfTexel), vec2(1.0 - halfTexel));
+	vec2 atlasUV = tile.xy + (vec2(face % 3, face / 3) + faceUV) * tile.z;
+	return texture(pointShadowAtlas, vec4(atlasUV, 1.0, depth));
 }
 
 void main()
 {
+#ifdef COMPACT_GBUFFER
+    vec3 position = reconstructPosition(uv, screenUV);
+    vec3 normal = decodeNormal(texture(gNormalTexture, uv).xy);
+#else
     vec3 position = texture(gPositionTexture, uv).xyz;
     vec3 normal = texture(gNormalTexture, uv).xyz;
+#endif
     vec3 textureDiffuseColor = texture(gAlbedoTexture, uv).rgb;
     vec3 textureSpecularColor = texture(gSpecularTexture, uv).rgb;
     float materialShininesss = texture(gSpecularTexture, uv).a * 255.f;
@@ -80,14 +212,22 @@ void main()
     vec3 eyeVec = normalize(cameraPos - position);
 	vec3 dirLightColor = vec3(0,0,0);
     vec3 ptLightColor = vec3(0,0,0);
+	int cascade = selectCascade(position);
+	float shadow = shadowCalculation(cascade, position, normal);
 	for(int i = 0; i < 1; ++i)
 	{
-		dirLightColor += directionLightCalculation(directionLight[i], normal, eyeVec, textureDiffuseColor, materialShininesss, textureSpecularColor, Ambient);
+		dirLightColor += directionLightCalculation(directionLight[i], normal, eyeVec, textureDiffuseColor, materialShininesss, textureSpecularColor, Ambient, shadow);
+	}
+	if(showCascades && cascade >= 0)
+	{
+		vec3 cascadeTint[max_cascades] = vec3[](vec3(1, 0.5, 0.5), vec3(0.5, 1, 0.5), vec3(0.5, 0.5, 1), vec3(1, 1, 0.5));
+		dirLightColor *= cascadeTint[cascade];
 	}
 	
 	for(int i = 0; i < max_lights; ++i)
 	{
-		ptLightColor += pointLightCalculation(pointLight[i], position, normal, eyeVec, textureDiffuseColor, materialShininesss, textureSpecularColor, Ambient);
+		float pointShadow = pointShadowCalculation(i, position, normal);
+		ptLightColor += pointLightCalculation(pointLight[i], position, normal, eyeVec, textureDiffuseColor, materialShininesss, textureSpecularColor, Ambient, pointShadow);
 	}
     
     
@@ -2,10 +2,14 @@
 
 in vec3 vertex;
 in vec2 vertexTexture;
+// fraction of the G buffer covered by the current render resolution
+uniform vec2 gBufferScale;
 out vec2 uv;
+out vec2 screenUV;
 
 void main()
 {
     gl_Position = vec4(vertex.x, vertex.y, 0.0f, 1.0f);
-    uv = vertexTexture;
+    uv = vertexTexture * gBufferScale;
+    screenUV = vertexTexture;
 }
\ No newline at end of file
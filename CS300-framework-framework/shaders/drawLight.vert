@@ -1,9 +1,24 @@
 #version 330
 
-uniform mat4 ProjectionMatrix, ViewMatrix, ModelMatrix;
+// per-frame constants shared by every program, uniform block binding 0
+layout(std140) uniform FrameConstants
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+	mat4 ViewProjectionMatrix;
+	mat4 InverseViewMatrix;
+	mat4 InverseProjectionMatrix;
+	mat4 InverseViewProjectionMatrix;
+	vec3 cameraPos;
+	float time;
+	vec4 viewport;          // render width, height, 1 / width, 1 / height
+	int frameIndex;
+};
+
+uniform mat4 ModelMatrix;
 in vec4 vertex;
 
 void main()
 {
-    gl_Position = ProjectionMatrix*ViewMatrix*ModelMatrix*vertex;
+    gl_Position = ViewProjectionMatrix*ModelMatrix*vertex;
 }
\ No newline at end of file
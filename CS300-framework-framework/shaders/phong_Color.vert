@@ -16,8 +16,20 @@ out vec3 normalVec, lightVec, eyeVec;
 
 // These are inputs from the application.
 uniform mat4 ModelMatrix;
-uniform mat4 ViewMatrix, ViewInverse;
-uniform mat4 ProjectionMatrix;
+// per-frame constants shared by every program, uniform block binding 0
+layout(std140) uniform FrameConstants
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+	mat4 ViewProjectionMatrix;
+	mat4 InverseViewMatrix;
+	mat4 InverseProjectionMatrix;
+	mat4 InverseViewProjectionMatrix;
+	vec3 cameraPos;
+	float time;
+	vec4 viewport;          // render width, height, 1 / width, 1 / height
+	int frameIndex;
+};
 
 // These are inputs directly from the model.
 in vec4 vertex;
@@ -34,7 +46,7 @@ void main()
     vec3 VertexWorldPosition = vec3(ModelMatrix * vertex);
 	lightVec = lightPos - VertexWorldPosition;
 	//getting the eye look at vector in world space
-	eyeVec = vec3(ViewInverse * vec4(0.f, 0.f, 0.f, 1.f)) - VertexWorldPosition;
+	eyeVec = vec3(InverseViewMatrix * vec4(0.f, 0.f, 0.f, 1.f)) - VertexWorldPosition;
 
 	gl_Position = ProjectionMatrix*ViewMatrix*ModelMatrix*vertex;
 	//gl_Position = vertex * ModelMatrix * ViewMatrix * ProjectionMatrix;
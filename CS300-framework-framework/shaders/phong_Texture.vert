@@ -1,10 +1,21 @@
 #version 330
 // These are inputs from the application.
 uniform vec3 lightPos;
-uniform vec3 cameraPos;
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
-uniform mat4 ViewInverse, ModelMatrix, NormalMatrix;
+uniform mat4 ModelMatrix, NormalMatrix;
+// per-frame constants shared by every program, uniform block binding 0
+layout(std140) uniform FrameConstants
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+	mat4 ViewProjectionMatrix;
+	mat4 InverseViewMatrix;
+	mat4 InverseProjectionMatrix;
+	mat4 InverseViewProjectionMatrix;
+	vec3 cameraPos;
+	float time;
+	vec4 viewport;          // render width, height, 1 / width, 1 / height
+	int frameIndex;
+};
 
 in vec4 vertex;
 in vec3 vertexNormal;
@@ -1,9 +1,6 @@
 #version 330
 
-in vec4 position;
-layout(location = 0) out vec3 color;
-
+// depth only; the shadow map has no color attachment
 void main()
 {
-	color = vec3(position.w);
-}
\ No newline at end of file
+}
@@ -1,14 +1,27 @@
 #version 330
 in vec4 vertex;
 
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
+// per-frame constants shared by every program, uniform block binding 0
+layout(std140) uniform FrameConstants
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+	mat4 ViewProjectionMatrix;
+	mat4 InverseViewMatrix;
+	mat4 InverseProjectionMatrix;
+	mat4 InverseViewProjectionMatrix;
+	vec3 cameraPos;
+	float time;
+	vec4 viewport;          // render width, height, 1 / width, 1 / height
+	int frameIndex;
+};
 
 out vec3 uv;
 
 void main()
 {
-	vec4 position = ProjectionMatrix * ViewMatrix * vertex; 
+	// rotation only, the sky stays centered on the camera
+	vec4 position = ProjectionMatrix * mat4(mat3(ViewMatrix)) * vertex;
     gl_Position = position.xyww;
     uv = vertex.xyz;
 }
\ No newline at end of file
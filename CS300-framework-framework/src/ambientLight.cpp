@@ -1,6 +1,6 @@
 #include "ambientLight.h"
-#include "GL\glew.h"
-#include "glm\ext.hpp"
+#include "GL/glew.h"
+#include "glm/ext.hpp"
 
 ambientLight::ambientLight()
 {
@@ -12,7 +12,7 @@ ambientLight::~ambientLight()
 
 }
 
-void ambientLight::setAmbientColor(glm::vec3 &color)
+void ambientLight::setAmbientColor(const glm::vec3 &color)
 {
 	lightColor = color;
 }
@@ -41,10 +41,10 @@ void ambientLight::update(void(*updateFN)())
 void ambientLight::updateLightParameter(unsigned int shader)
 {
 	int loc = glGetUniformLocation(shader, "ambientLight.diffuse");
-	glUniform3fv(loc, 1, glm::value_ptr(lightColor));
+	glProgramUniform3fv(shader, loc, 1, glm::value_ptr(lightColor));
 
 	loc = glGetUniformLocation(shader, "ambientLight.strength");
-	glUniform1f(loc, ambientStrength);
+	glProgramUniform1f(shader, loc, ambientStrength);
 }
 
 void ambientLight::draw(unsigned int shader)
@@ -12,7 +12,7 @@ public:
 	void draw(unsigned int shader);
 	void updateLightParameter(unsigned int shader);
 
-	void setAmbientColor(glm::vec3 &color);
+	void setAmbientColor(const glm::vec3 &color);
 	void setAmbientStrength(float strength);
 
 	const glm::vec3 getAmbientColor();
@@ -0,0 +1,334 @@
+///////////////////////////////////////////////////////////////////////
+// Headless benchmark: renders the regular scene without a window and
+// writes the frame statistics to a JSON file, so performance can be
+// tracked from a script or a CI machine without a GPU (Mesa's llvmpipe
+// runs OpenGL 4.5 on the CPU).
+//
+// The context comes from createHeadlessContext (EGL, or OSMesa when
+// built with BENCHMARK_OSMESA).  Every frame is followed by
+// glFinish, so GPU timer results arrive one frame late and are always
+// complete; the CPU stage split (frameTiming.h) counts the glFinish as
+// the swap.  Only built by the Makefile (make benchmark).
+//
+// Giving an object or light count swaps the default scene for a
+// generated stress scene (see stressScene.h), animated at a fixed
+// 60 Hz step so every run sees the same frames.  --replay drives the
+// camera and lights from a recording made in the framework (see
+// frameRecording.h), looping it over the warm-up and measured frames.
+// --sim-thread moves the animation to the simulation thread
+// (simulationThread.h), ticking at 60 Hz on the wall clock; each frame
+// then shows the latest tick, so runs are no longer frame-exact.
+// --workers sets the job system's thread count, main thread included
+// (0, the default: one per hardware thread).  --serial-recording
+// records the G buffer commands on the GL thread instead of in jobs.
+//
+//   benchmark [--frames N] [--warmup N] [--width W] [--height H]
+//             [--objects N] [--lights M] [--seed S] [--moving SHARE]
+//             [--replay recording.bin] [--dynamic-resolution] [--sim-thread]
+//             [--workers N] [--serial-recording]
+//             [--out benchmark.json] [--trace trace.json]
+////////////////////////////////////////////////////////////////////////
+
+#include "shader.h"
+#include "fbo.h"
+#include "scene.h"
+#include "profiler.h"
+
+#include "headlessContext.h"
+#include "benchmarkReport.h"
+
+#include "GL/glew.h"
+
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Scene scene;
+
+struct benchmarkOptions
+{
+	int frames = 300;
+	int warmup = 30;                // not measured: shader warm-up, shadow caches, ...
+	int width = 1280;
+	int height = 720;
+	bool dynamicResolution = false; // off so every run draws the same pixels
+	bool simulationThread = false;
+	int workers = 0;
+	bool serialRecording = false;
+	const char* out = "benchmark.json";
+	const char* trace = nullptr;
+	const char* replay = nullptr;
+	bool stress = false;
+	stressSceneDesc stressScene;
+};
+
+// One measured series per value, one sample per frame.
+struct benchmarkSamples
+{
+	std::vector<double> cpuMs;       // DrawScene, submission only
+	std::vector<double> wallMs;      // DrawScene + glFinish
+	std::vector<double> gpuMs;       // whole frame, from the frame timer
+	std::vector<double> drawCalls;
+	std::vector<double> callsIssued;
+	std::vector<double> callsAvoided;
+	std::vector<double> stageMs[frameTiming::STAGE_COUNT];  // from frameTiming
+	std::vector<std::vector<double>> passMs;
+};
+
+static bool parseOptions(int argc, char** argv, benchmarkOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--frames") && hasValue)
+			options.frames = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--warmup") && hasValue)
+			options.warmup = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--width") && hasValue)
+			options.width = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--height") && hasValue)
+			options.height = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--out") && hasValue)
+			options.out = argv[++i];
+		else if (!strcmp(argv[i], "--trace") && hasValue)
+			options.trace = argv[++i];
+		else if (!strcmp(argv[i], "--replay") && hasValue)
+			options.replay = argv[++i];
+		else if (!strcmp(argv[i], "--objects") && hasValue)
+		{
+			options.stressScene.objectCount = atoi(argv[++i]);
+			options.stress = true;
+		}
+		else if (!strcmp(argv[i], "--lights") && hasValue)
+		{
+			options.stressScene.pointLightCount = atoi(argv[++i]);
+			options.stress = true;
+		}
+		else if (!strcmp(argv[i], "--seed") && hasValue)
+			options.stressScene.seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--moving") && hasValue)
+			options.stressScene.movingShare = (float)atof(argv[++i]);
+		else if (!strcmp(argv[i], "--dynamic-resolution"))
+			options.dynamicResolution = true;
+		else if (!strcmp(argv[i], "--sim-thread"))
+			options.simulationThread = true;
+		else if (!strcmp(argv[i], "--workers") && hasValue)
+			options.workers = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--serial-recording"))
+			options.serialRecording = true;
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete option %s\n", argv[i]);
+			return false;
+		}
+	}
+	if (options.frames < 1 || options.warmup < 0 || options.width < 1 || options.height < 1)
+	{
+		fprintf(stderr, "Frames, width and height must be positive\n");
+		return false;
+	}
+	return true;
+}
+
+// Lights past MAX_SHADER_LIGHTS get no shader slot, so they add update
+// and gizmo cost but no shading or shadow cost.
+static int countShadedLights()
+{
+	int shaded = 0;
+	for (pointLight& light : scene.pointLightContainer)
+		if (light.getLightIndex() >= 0 && light.getLightIndex() < MAX_SHADER_LIGHTS)
+			++shaded;
+	return shaded;
+}
+
+static bool writeReport(const benchmarkOptions& options, const benchmarkSamples& samples)
+{
+	rapidjson::StringBuffer buffer;
+	jsonWriter writer(buffer);
+	writer.StartObject();
+	writer.Key("renderer"); writer.String((const char*)glGetString(GL_RENDERER));
+	writer.Key("version");  writer.String((const char*)glGetString(GL_VERSION));
+	writer.Key("width");    writer.Int(options.width);
+	writer.Key("height");   writer.Int(options.height);
+	writer.Key("frames");   writer.Int(options.frames);
+	writer.Key("warmup");   writer.Int(options.warmup);
+	writer.Key("dynamicResolution"); writer.Bool(options.dynamicResolution);
+	writer.Key("scene");
+	writer.StartObject();
+	writer.Key("generated");   writer.Bool(options.stress);
+	writer.Key("seed");        writer.Uint(options.stressScene.seed);
+	writer.Key("objects");     writer.Int((int)scene.graphicsObjectContainer.size());
+	writer.Key("pointLights"); writer.Int((int)scene.pointLightParameters.size());
+	writer.Key("shadedLights"); writer.Int(countShadedLights());
+	writer.Key("moving");      writer.Int((int)scene.stressScene.objectPaths.size());
+	writer.Key("replay");      writer.String(options.replay ? options.replay : "");
+	writer.Key("replayFrames"); writer.Int(scene.recording.frameCount);
+	writer.EndObject();
+
+	writeSeries(writer, "cpuFrameMs", samples.cpuMs);
+	writeSeries(writer, "wallFrameMs", samples.wallMs);
+	writeSeries(writer, "gpuFrameMs", samples.gpuMs);
+
+	writer.Key("cpuStagesMs");
+	writer.StartObject();
+	for (int i = 0; i < frameTiming::STAGE_COUNT; ++i)
+		writeSeries(writer, frameTiming::getStageName(i), samples.stageMs[i]);
+	writer.EndObject();
+	writer.Key("hitchBudgetMs"); writer.Double(scene.frameTimingParameters.hitchBudgetMs);
+	writer.Key("hitches");       writer.Int(scene.frameTimingParameters.hitches);
+
+	const simulationParam &simulation = scene.simulationParameters;
+	writer.Key("simulation");
+	writer.StartObject();
+	writer.Key("threaded");         writer.Bool(simulation.threaded);
+	writer.Key("ticks");            writer.Int(simulation.ticks);
+	writer.Key("snapshotsApplied"); writer.Int(simulation.snapshotsApplied);
+	writer.Key("snapshotsDropped"); writer.Int(simulation.snapshotsDropped);
+	writer.Key("tickMeanMs");       writer.Double(simulation.tick.meanMs);
+	writer.Key("tickP99Ms");        writer.Double(simulation.tick.p99Ms);
+	writer.EndObject();
+
+	const jobSystemParam &jobs = scene.jobSystemParameters;
+	writer.Key("jobSystem");
+	writer.StartObject();
+	writer.Key("threads");    writer.Int(jobs.threads);
+	writer.Key("jobsRun");    writer.Int(jobs.jobsRun);     // last frame
+	writer.Key("jobsStolen"); writer.Int(jobs.jobsStolen);
+	writer.EndObject();
+
+	const commandRecordingParam &recording = scene.commandRecordingParameters;
+	writer.Key("commandRecording");
+	writer.StartObject();
+	writer.Key("parallel"); writer.Bool(recording.parallel);
+	writer.Key("lists");    writer.Int(recording.lists);     // last frame
+	writer.Key("commands"); writer.Int(recording.commands);
+	writer.EndObject();
+
+	const frameArenaParam &arena = scene.frameArenaParameters;
+	writer.Key("frameArena");
+	writer.StartObject();
+	writer.Key("bytesUsed");       writer.Int(arena.bytesUsed);    // last frame
+	writer.Key("capacity");        writer.Int(arena.capacity);
+	writer.Key("overflows");       writer.Int(arena.overflows);
+	writer.Key("heapAllocations"); writer.Int(arena.heapAllocations);
+	writer.EndObject();
+
+	writer.Key("passes");
+	writer.StartObject();
+	for (int p = 0; p < scene.mRenderGraph.getPassCount(); ++p)
+		writeSeries(writer, scene.mRenderGraph.getPassName(p), samples.passMs[p]);
+	writer.EndObject();
+
+	writeSeries(writer, "drawCalls", samples.drawCalls);
+	writeSeries(writer, "stateChangesIssued", samples.callsIssued);
+	writeSeries(writer, "stateChangesAvoided", samples.callsAvoided);
+
+	float residentMB, peakMB;
+	readProcessMemory(residentMB, peakMB);
+	writer.Key("memory");
+	writer.StartObject();
+	writer.Key("residentMB");     writer.Double(residentMB);
+	writer.Key("peakResidentMB"); writer.Double(peakMB);
+	writer.Key("renderTargetMB"); writer.Double(scene.renderTargetPoolParameters.allocatedMB);
+	writer.Key("frameDataBytes"); writer.Int(scene.frameDataRingParameters.bytesUsed);
+	writer.EndObject();
+	writer.EndObject();
+
+	return writeJsonFile(options.out, buffer);
+}
+
+int main(int argc, char** argv)
+{
+	PROFILE_THREAD_NAME("Main");
+	benchmarkOptions options;
+	if (!parseOptions(argc, argv, options) || !createHeadlessContext(options.width, options.height))
+		return -1;
+	printf("Rendered by: %s, OpenGL %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	jobSystem::initialize(options.workers);
+	frameArena::initialize();
+	InitializeScene(scene);
+	scene.width = options.width;
+	scene.height = options.height;
+	scene.dynamicResolutionParameters.enabled = options.dynamicResolution;
+	scene.commandRecordingParameters.parallel = !options.serialRecording;
+	if (options.stress)
+		buildStressScene(scene, options.stressScene);
+	if (options.replay && !startReplay(scene, options.replay, true))
+		return -1;
+	if (options.simulationThread)
+		scene.simulation.start(scene);
+
+	benchmarkSamples samples;
+	samples.passMs.resize(scene.mRenderGraph.getPassCount());
+	int gpuResults = 0;
+	for (int frame = 0; frame < options.warmup + options.frames; ++frame)
+	{
+		// closes the previous frame's stage split
+		frameTiming::beginFrame(scene.frameTimingParameters);
+		if (frame == options.warmup)
+		{
+			scene.frameTimingParameters.hitches = 0;
+			scene.frameTimingParameters.worstHitchMs = 0.f;
+			scene.frameTimingParameters.hitchLog.clear();
+		}
+		else if (frame > options.warmup)
+		{
+			for (int i = 0; i < frameTiming::STAGE_COUNT; ++i)
+				samples.stageMs[i].push_back(scene.frameTimingParameters.stages[i].lastMs);
+		}
+
+		{
+			frameTiming::scope update(frameTiming::UPDATE);
+			if (scene.simulation.isRunning())
+				scene.simulation.sync(scene);
+			else
+				animateStressScene(scene, frame / 60.f);
+		}
+		// the moving objects' update above is in the UPDATE stage, not here
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		DrawScene(scene);
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		{
+			frameTiming::scope swap(frameTiming::SWAP);
+			glFinish();
+		}
+		std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+		// the results read back during this frame belong to the previous one
+		bool gpuResult = scene.frameTimer.getResultCount() != gpuResults;
+		gpuResults = scene.frameTimer.getResultCount();
+		if (frame < options.warmup)
+			continue;
+
+		samples.cpuMs.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+		samples.wallMs.push_back(std::chrono::duration<double, std::milli>(finished - start).count());
+		samples.drawCalls.push_back((double)scene.glStateParameters.drawCalls);
+		samples.callsIssued.push_back((double)scene.glStateParameters.callsIssued);
+		samples.callsAvoided.push_back((double)scene.glStateParameters.redundantCallsAvoided);
+		if (gpuResult)
+			samples.gpuMs.push_back(scene.frameTimer.getElapsedMs());
+		for (int p = 0; p < (int)samples.passMs.size(); ++p)
+		{
+			if (scene.renderGraphParameters.passTiming[p].lastMs > 0.f)
+				samples.passMs[p].push_back(scene.renderGraphParameters.passTiming[p].lastMs);
+		}
+	}
+
+	frameTiming::beginFrame(scene.frameTimingParameters);
+	for (int i = 0; i < frameTiming::STAGE_COUNT; ++i)
+		samples.stageMs[i].push_back(scene.frameTimingParameters.stages[i].lastMs);
+	scene.simulation.stop();
+	jobSystem::shutdown();
+	frameArena::release();
+
+	if (!writeReport(options, samples))
+		return -1;
+	printf("%d frames at %dx%d written to %s\n", options.frames, options.width, options.height, options.out);
+#ifdef PROFILER_ENABLED
+	if (options.trace)
+		profiler::exportChromeTrace(options.trace);
+#endif
+	return 0;
+}
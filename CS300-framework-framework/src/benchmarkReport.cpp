@@ -0,0 +1,90 @@
+#include "benchmarkReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Nearest-rank percentile of an already sorted series.
+static double percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+		return 0.0;
+	size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+	return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+sampleSummary summarizeSamples(std::vector<double> samples)
+{
+	sampleSummary summary;
+	if (samples.empty())
+		return summary;
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (double sample : samples)
+		sum += sample;
+	summary.samples = (int)samples.size();
+	summary.mean = sum / samples.size();
+	double squares = 0.0;
+	for (double sample : samples)
+		squares += (sample - summary.mean) * (sample - summary.mean);
+	summary.stddev = samples.size() > 1 ? sqrt(squares / (samples.size() - 1)) : 0.0;
+	summary.min = samples.front();
+	summary.p50 = percentile(samples, 50.0);
+	summary.p90 = percentile(samples, 90.0);
+	summary.p95 = percentile(samples, 95.0);
+	summary.p99 = percentile(samples, 99.0);
+	summary.max = samples.back();
+	return summary;
+}
+
+void writeSummary(jsonWriter& writer, const char* name, const sampleSummary& summary)
+{
+	writer.Key(name);
+	writer.StartObject();
+	writer.Key("samples"); writer.Int(summary.samples);
+	writer.Key("mean");    writer.Double(summary.mean);
+	writer.Key("stddev");  writer.Double(summary.stddev);
+	writer.Key("min");     writer.Double(summary.min);
+	writer.Key("p50");     writer.Double(summary.p50);
+	writer.Key("p90");     writer.Double(summary.p90);
+	writer.Key("p95");     writer.Double(summary.p95);
+	writer.Key("p99");     writer.Double(summary.p99);
+	writer.Key("max");     writer.Double(summary.max);
+	writer.EndObject();
+}
+
+void writeSeries(jsonWriter& writer, const char* name, const std::vector<double>& samples)
+{
+	writeSummary(writer, name, summarizeSamples(samples));
+}
+
+void readProcessMemory(float& residentMB, float& peakMB)
+{
+	residentMB = peakMB = 0.f;
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, 6, "VmRSS:") == 0)
+			residentMB = atof(line.c_str() + 6) / 1024.f;
+		else if (line.compare(0, 6, "VmHWM:") == 0)
+			peakMB = atof(line.c_str() + 6) / 1024.f;
+	}
+}
+
+bool writeJsonFile(const char* path, const rapidjson::StringBuffer& buffer)
+{
+	FILE* file = fopen(path, "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Could not write %s\n", path);
+		return false;
+	}
+	fwrite(buffer.GetString(), 1, buffer.GetSize(), file);
+	fputc('\n', file);
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////
+// Statistics and JSON output shared by the benchmark and the
+// microbenchmark.  Percentiles are nearest-rank, so every reported
+// value is one that was actually measured.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "prettywriter.h"
+#include "stringbuffer.h"
+#include <vector>
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> jsonWriter;
+
+struct sampleSummary
+{
+	int samples = 0;
+	double mean = 0.0;
+	double stddev = 0.0;
+	double min = 0.0;
+	double p50 = 0.0;
+	double p90 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+sampleSummary summarizeSamples(std::vector<double> samples);
+
+// Writes name: { samples, mean, stddev, min, p50, p90, p95, p99, max }.
+void writeSummary(jsonWriter& writer, const char* name, const sampleSummary& summary);
+void writeSeries(jsonWriter& writer, const char* name, const std::vector<double>& samples);
+
+// Resident and peak resident set size in MB from /proc; 0 elsewhere.
+void readProcessMemory(float& residentMB, float& peakMB);
+
+bool writeJsonFile(const char* path, const rapidjson::StringBuffer& buffer);
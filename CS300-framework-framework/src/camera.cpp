@@ -10,15 +10,18 @@ camera::~camera()
 
 }
 
-void camera::initialize(glm::vec3& pos, glm::vec3& lookat)
+void camera::initialize(const glm::vec3& pos, const glm::vec3& lookat)
 {
 	position = pos;
 	lookAtPt = lookat;
 	lookAtVec = glm::normalize(lookAtPt - position);
+	++version;
 }
 
 void camera::setLookAt(glm::vec3 pos)
 {
+	if (lookAtPt != pos)
+		++version;
 	lookAtPt = pos;
 }
 
@@ -27,17 +30,20 @@ void camera::zoom(float displacement)
 	glm::vec3 lookDir = position - lookAtPt;
 	float dist = glm::length(lookDir) - displacement * cameraSpeed;
 	position = lookAtPt + (glm::normalize(lookDir) * dist);
+	++version;
 }
 
 void camera::horizontalMove(float dx)
 {
 	position = glm::angleAxis(-dx * angleSpeed, glm::vec3(0, 1, 0)) * position;
+	++version;
 }
 
 void camera::verticalMove(float dy)
 {
 	glm::vec3 sideVec = glm::normalize(glm::cross(getLookAtDir(), glm::vec3(0, -1, 0)));
 	position = glm::angleAxis(dy * angleSpeed, sideVec) * position;
+	++version;
 }
 
 glm::mat4 camera::getViewMtx()
@@ -50,11 +56,21 @@ void camera::update()
 	viewMtx = glm::lookAt(position, lookAtPt, glm::vec3(0, 1, 0));
 }
 
+unsigned int camera::getVersion()
+{
+	return version;
+}
+
 glm::vec3 camera::getPosition()
 {
 	return position;
 }
 
+glm::vec3 camera::getLookAt()
+{
+	return lookAtPt;
+}
+
 void camera::setPanDir(glm::vec2 pan)
 {
 	float direction = 1.f;
@@ -71,6 +87,7 @@ void camera::setPanDir(glm::vec2 pan)
 
 	position += up * pan.y * panSpeed;
 	lookAtPt += up * pan.y * panSpeed;
+	++version;
 }
 
 glm::vec3 camera::getLookAtDir()
@@ -1,14 +1,14 @@
 #pragma once
 
-#include "glm\ext.hpp"
-#include "glm\glm.hpp"
+#include "glm/ext.hpp"
+#include "glm/glm.hpp"
 
 class camera
 {
 public:
 	camera();
 	~camera();
-	void initialize(glm::vec3& pos, glm::vec3& lookat);
+	void initialize(const glm::vec3& pos, const glm::vec3& lookat);
 	void update();
 	void zoom(float displacement);
 	void horizontalMove(float dx);
@@ -16,7 +16,9 @@ public:
 	void setLookAt(glm::vec3 pos);
 	void setPanDir(glm::vec2 pan);
 	glm::vec3 getPosition();
+	glm::vec3 getLookAt();
 	glm::mat4 getViewMtx();
+	unsigned int getVersion();
 private:
 	glm::vec3 getLookAtDir();
 	glm::vec3 getSideDir();
@@ -28,4 +30,6 @@ private:
 	glm::vec3 lookAtVec;
 	glm::vec3 lookAtPt;
 	glm::mat4 viewMtx;
+	// bumped by every move, like object::transformVersion
+	unsigned int version = 0;
 };
\ No newline at end of file
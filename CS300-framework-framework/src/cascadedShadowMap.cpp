@@ -0,0 +1,187 @@
+#include "cascadedShadowMap.h"
+#include "GL/glew.h"
+#include "glState.h"
+#include "glDebug.h"
+#include "glm/ext.hpp"
+
+cascadedShadowMap::cascadedShadowMap()
+{
+
+}
+
+cascadedShadowMap::~cascadedShadowMap()
+{
+
+}
+
+void cascadedShadowMap::initialize(renderTargetPool& pool, int cascades, int mapResolution)
+{
+	cascadeCount = glm::clamp(cascades, 1, (int)MAX_CASCADES);
+	resolution = mapResolution;
+
+	// depth only, one layer per cascade, sampled with hardware compare (PCF)
+	fboDesc desc;
+	desc.width = resolution;
+	desc.height = resolution;
+	desc.layers = cascadeCount;
+	desc.depthFormat = GL_DEPTH_COMPONENT24;
+	target = pool.acquire(desc);
+	GL_DEBUG_LABEL(GL_FRAMEBUFFER, target->getFBO(), "Shadow Cascades");
+
+	for (int i = 0; i < MAX_CASCADES; ++i)
+	{
+		lightViewProjection[i] = glm::mat4();
+		splitDistance[i] = 0.f;
+		texelWorldSize[i] = 0.f;
+		renderThisFrame[i] = false;
+	}
+	invalidate();
+}
+
+void cascadedShadowMap::release(renderTargetPool& pool)
+{
+	pool.release(target);
+	target = nullptr;
+}
+
+// Every cascade is redrawn on the next update.
+void cascadedShadowMap::invalidate()
+{
+	forceRender = true;
+}
+
+void cascadedShadowMap::update(const glm::mat4& viewMtx, float fovDeg, float aspect, float nearPlane,
+							   float shadowDistance, float splitLambda, const glm::vec3& lightDir,
+							   bool stagger)
+{
+	glm::vec3 dir = glm::normalize(lightDir);
+	if (dir != lastLightDir)
+	{
+		lastLightDir = dir;
+		forceRender = true;
+	}
+
+	// cascade 0 every frame, cascade 1 on odd frames, cascades 2 and 3
+	// on alternating even frames
+	const unsigned int interval[MAX_CASCADES] = { 1, 2, 4, 4 };
+	const unsigned int phase[MAX_CASCADES] = { 0, 1, 0, 2 };
+	for (int i = 0; i < cascadeCount; ++i)
+	{
+		renderThisFrame[i] = forceRender || !stagger || (frameIndex % interval[i]) == phase[i];
+	}
+	forceRender = false;
+	++frameIndex;
+
+	glm::vec3 up = glm::abs(dir.y) > 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+	lightView = glm::lookAt(glm::vec3(0.f), dir, up);
+	glm::mat4 inverseView = glm::inverse(viewMtx);
+	float tanHalfFovY = glm::tan(glm::radians(fovDeg) * 0.5f);
+	float tanHalfFovX = tanHalfFovY * aspect;
+
+	float splitNear = nearPlane;
+	for (int i = 0; i < cascadeCount; ++i)
+	{
+		// practical split scheme: blend of logarithmic and uniform splits
+		float t = (float)(i + 1) / cascadeCount;
+		float logSplit = nearPlane * glm::pow(shadowDistance / nearPlane, t);
+		float uniformSplit = nearPlane + (shadowDistance - nearPlane) * t;
+		float splitFar = glm::mix(uniformSplit, logSplit, splitLambda);
+
+		if (renderThisFrame[i])
+		{
+			// bounding sphere of the slice: its radius only depends on the
+			// split distances, so the cascade size stays fixed
+			glm::vec3 corners[8];
+			float depths[2] = { splitNear, splitFar };
+			int c = 0;
+			for (int d = 0; d < 2; ++d)
+				for (int y = -1; y <= 1; y += 2)
+					for (int x = -1; x <= 1; x += 2)
+					{
+						glm::vec4 viewCorner(x * tanHalfFovX * depths[d], y * tanHalfFovY * depths[d], -depths[d], 1.f);
+						corners[c++] = glm::vec3(inverseView * viewCorner);
+					}
+			glm::vec3 center(0.f);
+			for (int k = 0; k < 8; ++k)
+				center += corners[k];
+			center /= 8.f;
+			float radius = 0.f;
+			for (int k = 0; k < 8; ++k)
+				radius = glm::max(radius, glm::length(corners[k] - center));
+			radius = glm::ceil(radius * 16.f) / 16.f;
+
+			// snap the light space center to whole texels
+			float texelSize = 2.f * radius / resolution;
+			glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.f));
+			lightCenter.x = glm::floor(lightCenter.x / texelSize) * texelSize;
+			lightCenter.y = glm::floor(lightCenter.y / texelSize) * texelSize;
+
+			// casters in front of the near plane are clamped (GL_DEPTH_CLAMP)
+			boundsMin[i] = lightCenter - glm::vec3(radius);
+			boundsMax[i] = lightCenter + glm::vec3(radius);
+			glm::mat4 projection = glm::ortho(boundsMin[i].x, boundsMax[i].x, boundsMin[i].y, boundsMax[i].y,
+											  -boundsMax[i].z, -boundsMin[i].z);
+			lightViewProjection[i] = projection * lightView;
+			texelWorldSize[i] = texelSize;
+		}
+		splitDistance[i] = splitFar;
+		splitNear = splitFar;
+	}
+}
+
+bool cascadedShadowMap::needsRender(int cascade)
+{
+	return renderThisFrame[cascade];
+}
+
+// Casters outside the cascade's light space rectangle, or entirely
+// behind its far plane, cannot shadow anything in it.  Anything
+// between the light and the near plane still can.
+bool cascadedShadowMap::isCasterVisible(int cascade, const glm::vec3& center, float radius)
+{
+	glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.f));
+	if (lightCenter.x + radius < boundsMin[cascade].x || lightCenter.x - radius > boundsMax[cascade].x)
+		return false;
+	if (lightCenter.y + radius < boundsMin[cascade].y || lightCenter.y - radius > boundsMax[cascade].y)
+		return false;
+	if (lightCenter.z + radius < boundsMin[cascade].z)
+		return false;
+	return true;
+}
+
+void cascadedShadowMap::bindCascade(int cascade)
+{
+	target->Bind();
+	target->BindLayer(cascade);
+	glState::viewport(0, 0, resolution, resolution);
+}
+
+int cascadedShadowMap::getCascadeCount()
+{
+	return cascadeCount;
+}
+
+int cascadedShadowMap::getResolution()
+{
+	return resolution;
+}
+
+unsigned int cascadedShadowMap::getDepthTexture()
+{
+	return target->getDepthTexture();
+}
+
+const glm::mat4* cascadedShadowMap::getLightViewProjections()
+{
+	return lightViewProjection;
+}
+
+const float* cascadedShadowMap::getSplitDistances()
+{
+	return splitDistance;
+}
+
+const float* cascadedShadowMap::getTexelWorldSizes()
+{
+	return texelWorldSize;
+}
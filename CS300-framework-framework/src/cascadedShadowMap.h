@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////
+// Cascaded shadow map for a directional light.  The camera frustum,
+// out to the shadow distance, is cut into cascades and each one gets
+// its own layer of a depth texture array, fitted to a bounding sphere
+// of the slice so its size never changes as the camera turns.  The
+// light space origin is snapped to whole shadow map texels, which
+// keeps edges from crawling when the camera moves.
+//
+// Cascade 0 is rendered every frame; the farther ones are staggered
+// so only one of them is redrawn per frame.  A cascade that is skipped
+// keeps the matrix it was rendered with, so it stays correct (just a
+// little out of date) for the lighting pass.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "glm/glm.hpp"
+#include "renderTargetPool.h"
+
+class cascadedShadowMap
+{
+public:
+	static const int MAX_CASCADES = 4;
+
+	cascadedShadowMap();
+	~cascadedShadowMap();
+	void initialize(renderTargetPool& pool, int cascades, int mapResolution);
+	void release(renderTargetPool& pool);
+	void update(const glm::mat4& viewMtx, float fovDeg, float aspect, float nearPlane,
+				float shadowDistance, float splitLambda, const glm::vec3& lightDir,
+				bool stagger);
+	bool needsRender(int cascade);
+	bool isCasterVisible(int cascade, const glm::vec3& center, float radius);
+	void bindCascade(int cascade);
+	void invalidate();
+
+	int getCascadeCount();
+	int getResolution();
+	unsigned int getDepthTexture();
+	const glm::mat4* getLightViewProjections();
+	const float* getSplitDistances();
+	const float* getTexelWorldSizes();
+private:
+	FBO* target = nullptr;  // held across frames, the cascades are cached
+	int cascadeCount = 0;
+	int resolution = 0;
+	unsigned int frameIndex = 0;
+	bool forceRender = true;
+	glm::vec3 lastLightDir;
+	bool renderThisFrame[MAX_CASCADES];
+	// what the lighting pass samples with; only replaced when a cascade is redrawn
+	glm::mat4 lightViewProjection[MAX_CASCADES];
+	float splitDistance[MAX_CASCADES];
+	float texelWorldSize[MAX_CASCADES];
+	// light space bounds of the cascade being fitted this frame
+	glm::mat4 lightView;
+	glm::vec3 boundsMin[MAX_CASCADES];
+	glm::vec3 boundsMax[MAX_CASCADES];
+};
@@ -0,0 +1,135 @@
+#include "commandList.h"
+#include "frameArena.h"
+#include "glState.h"
+#include "GL/glew.h"
+
+commandList::commandList()
+{
+	clear();
+}
+
+commandList::~commandList()
+{
+
+}
+
+void commandList::clear()
+{
+	commands = nullptr;
+	count = 0;
+	capacity = 0;
+	program = ~0u;
+	vertexArray = ~0u;
+	for (int i = 0; i < MAX_TRACKED_UNITS; ++i)
+	{
+		textures[i] = ~0u;
+		samplers[i] = ~0u;
+	}
+}
+
+void commandList::reserve(size_t newCapacity)
+{
+	if (newCapacity <= capacity)
+		return;
+	renderCommand* grown = frameArena::allocateArray<renderCommand>(newCapacity);
+	for (size_t i = 0; i < count; ++i)
+		grown[i] = commands[i];
+	commands = grown;
+	capacity = newCapacity;
+}
+
+void commandList::add(renderCommand::eType type, unsigned int slot, unsigned int object, size_t offset, size_t size)
+{
+	renderCommand command;
+	command.type = type;
+	command.slot = (unsigned char)slot;
+	command.padding = 0;
+	command.object = object;
+	command.offset = (unsigned int)offset;
+	command.size = (unsigned int)size;
+	if (count == capacity)
+		reserve(capacity ? capacity * 2 : 64);
+	commands[count++] = command;
+}
+
+void commandList::bindProgram(unsigned int newProgram)
+{
+	if (newProgram == program)
+		return;
+	add(renderCommand::BIND_PROGRAM, 0, newProgram, 0, 0);
+	program = newProgram;
+}
+
+void commandList::bindVertexArray(unsigned int vao)
+{
+	if (vao == vertexArray)
+		return;
+	add(renderCommand::BIND_VERTEX_ARRAY, 0, vao, 0, 0);
+	vertexArray = vao;
+}
+
+void commandList::bindTexture2D(unsigned int unit, unsigned int texture)
+{
+	if (unit < MAX_TRACKED_UNITS)
+	{
+		if (textures[unit] == texture)
+			return;
+		textures[unit] = texture;
+	}
+	add(renderCommand::BIND_TEXTURE_2D, unit, texture, 0, 0);
+}
+
+void commandList::bindSampler(unsigned int unit, unsigned int sampler)
+{
+	if (unit < MAX_TRACKED_UNITS)
+	{
+		if (samplers[unit] == sampler)
+			return;
+		samplers[unit] = sampler;
+	}
+	add(renderCommand::BIND_SAMPLER, unit, sampler, 0, 0);
+}
+
+void commandList::bindUniformRange(unsigned int binding, unsigned int buffer, size_t offset, size_t size)
+{
+	add(renderCommand::BIND_UNIFORM_RANGE, binding, buffer, offset, size);
+}
+
+void commandList::drawElements(int count)
+{
+	add(renderCommand::DRAW_ELEMENTS, 0, 0, 0, (size_t)count);
+}
+
+size_t commandList::size()
+{
+	return count;
+}
+
+void commandList::replay()
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const renderCommand& command = commands[i];
+		switch (command.type)
+		{
+		case renderCommand::BIND_PROGRAM:
+			glState::useProgram(command.object);
+			break;
+		case renderCommand::BIND_VERTEX_ARRAY:
+			glState::bindVertexArray(command.object);
+			break;
+		case renderCommand::BIND_TEXTURE_2D:
+			glState::bindTexture(command.slot, GL_TEXTURE_2D, command.object);
+			break;
+		case renderCommand::BIND_SAMPLER:
+			glState::bindSampler(command.slot, command.object);
+			break;
+		case renderCommand::BIND_UNIFORM_RANGE:
+			glState::bindBufferRange(GL_UNIFORM_BUFFER, command.slot, command.object, command.offset, command.size);
+			break;
+		case renderCommand::DRAW_ELEMENTS:
+			glState::drawElements(GL_TRIANGLES, (int)command.size, GL_UNSIGNED_INT);
+			break;
+		}
+	}
+}
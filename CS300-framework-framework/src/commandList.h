@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////
+// Render command lists: what a pass would have called on OpenGL,
+// recorded as small POD commands instead, so any thread can record
+// and only the thread holding the context replays them.  Recording
+// touches no GL state, it only appends to the list it was given.
+//
+// A command is 16 bytes: a type, a unit or binding point, the GL name
+// it binds and, for uniform ranges, the range in the buffer.  Binds
+// repeating the previous one in the same list are not recorded, and
+// replay goes through glState, which drops what is still bound from
+// the list before.
+//
+// Commands live in the frame arena: clear drops them with the rest of
+// the frame, so a list is only good until the frame after it was
+// recorded.  Reserve before recording; growing copies into a new
+// block and leaves the old one behind.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>
+
+struct commandRecordingParam
+{
+	bool parallel = true;           // off: one list, recorded on the GL thread
+	int lists = 0;                  // last frame
+	int commands = 0;
+};
+
+struct renderCommand
+{
+	enum eType : unsigned char
+	{
+		BIND_PROGRAM,               // object: program
+		BIND_VERTEX_ARRAY,          // object: vertex array
+		BIND_TEXTURE_2D,            // slot: unit, object: texture
+		BIND_SAMPLER,               // slot: unit, object: sampler
+		BIND_UNIFORM_RANGE,         // slot: binding, object: buffer, offset, size
+		DRAW_ELEMENTS,              // size: index count, triangles, unsigned int indices
+	};
+	eType type;
+	unsigned char slot;
+	unsigned short padding;
+	unsigned int object;
+	unsigned int offset;
+	unsigned int size;
+};
+
+class commandList
+{
+public:
+	static const int MAX_TRACKED_UNITS = 4;
+
+	commandList();
+	~commandList();
+	void clear();
+	void reserve(size_t count);
+	void bindProgram(unsigned int program);
+	void bindVertexArray(unsigned int vao);
+	void bindTexture2D(unsigned int unit, unsigned int texture);
+	void bindSampler(unsigned int unit, unsigned int sampler);
+	void bindUniformRange(unsigned int binding, unsigned int buffer, size_t offset, size_t size);
+	void drawElements(int count);
+	size_t size();
+	// GL thread only
+	void replay();
+private:
+	void add(renderCommand::eType type, unsigned int slot, unsigned int object, size_t offset, size_t size);
+	// in the frame arena, null after clear
+	renderCommand* commands;
+	size_t count;
+	size_t capacity;
+	// the last binds recorded, ~0u when nothing was
+	unsigned int program;
+	unsigned int vertexArray;
+	unsigned int textures[MAX_TRACKED_UNITS];
+	unsigned int samplers[MAX_TRACKED_UNITS];
+};
@@ -1,7 +1,7 @@
 #include "directionalLight.h"
-#include "GL\glew.h"
-#include "glm\ext.hpp"
-#include <sstream>
+#include "GL/glew.h"
+#include "frameArena.h"
+#include "glm/ext.hpp"
 
 directionalLight::directionalLight()
 {
@@ -13,9 +13,9 @@ directionalLight::~directionalLight()
 
 }
 
-directionalLight::directionalLight(glm::vec3 &dir,
-								   glm::vec3 &diffuseColor,
-								   glm::vec3 &hilightColor)
+directionalLight::directionalLight(const glm::vec3 &dir,
+								   const glm::vec3 &diffuseColor,
+								   const glm::vec3 &hilightColor)
 {
 	lightDir = dir;
 	lightColor = diffuseColor;
@@ -30,17 +30,14 @@ void directionalLight::update(void(*updateFN)())
 
 void directionalLight::updateLightParameter(unsigned int shader)
 {
-	std::stringstream ss;
-	ss << "directionLight[" << lightIndex << "].";
+	int loc = glGetUniformLocation(shader, frameArena::format("directionLight[%d].diffuse", lightIndex));
+	glProgramUniform3fv(shader, loc, 1, glm::value_ptr(lightColor));
 
-	int loc = glGetUniformLocation(shader, (ss.str() + "diffuse").c_str());
-	glUniform3fv(loc, 1, glm::value_ptr(lightColor));
+	loc = glGetUniformLocation(shader, frameArena::format("directionLight[%d].direction", lightIndex));
+	glProgramUniform3fv(shader, loc, 1, glm::value_ptr(lightDir));
 
-	loc = glGetUniformLocation(shader, (ss.str() + "direction").c_str());
-	glUniform3fv(loc, 1, glm::value_ptr(lightDir));
-
-	loc = glGetUniformLocation(shader, (ss.str() + "specular").c_str());
-	glUniform3fv(loc, 1, glm::value_ptr(specularColor));
+	loc = glGetUniformLocation(shader, frameArena::format("directionLight[%d].specular", lightIndex));
+	glProgramUniform3fv(shader, loc, 1, glm::value_ptr(specularColor));
 }
 
 void directionalLight::draw(unsigned int shader)
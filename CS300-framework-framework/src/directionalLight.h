@@ -7,9 +7,9 @@ class directionalLight : public light
 public:
 	directionalLight();
 	~directionalLight();
-	directionalLight(glm::vec3 &dir,
-					 glm::vec3 &diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f),
-					 glm::vec3 &hilightColor = glm::vec3(0.5f, 0.5f, 0.5f));
+	directionalLight(const glm::vec3 &dir,
+					 const glm::vec3 &diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f),
+					 const glm::vec3 &hilightColor = glm::vec3(0.5f, 0.5f, 0.5f));
 	void update(void(*updateFN)());
 	void draw(unsigned int shader);
 	void updateLightParameter(unsigned int shader);
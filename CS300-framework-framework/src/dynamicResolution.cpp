@@ -0,0 +1,46 @@
+#include "dynamicResolution.h"
+#include "glm/glm.hpp"
+
+dynamicResolution::dynamicResolution()
+{
+
+}
+
+dynamicResolution::~dynamicResolution()
+{
+
+}
+
+// Returns true when the render scale changed this frame.
+bool dynamicResolution::update(dynamicResolutionParam& param, float gpuFrameMs)
+{
+	param.gpuFrameMs = gpuFrameMs;
+	averageMs = (averageMs == 0.f) ? gpuFrameMs : glm::mix(averageMs, gpuFrameMs, smoothing);
+	++framesSinceChange;
+
+	float targetScale = param.renderScale;
+	if (!param.enabled)
+	{
+		targetScale = 1.f;
+	}
+	else if (framesSinceChange >= cooldownFrames && averageMs > 0.f)
+	{
+		// only react outside a dead band so the scale does not oscillate
+		float target = param.gpuBudgetMs * 0.9f;
+		if (averageMs > param.gpuBudgetMs * 0.95f || averageMs < param.gpuBudgetMs * 0.8f)
+		{
+			// pixel cost grows with the square of the scale
+			float ideal = param.renderScale * glm::sqrt(target / averageMs);
+			targetScale = glm::clamp(ideal, param.renderScale - maxScaleChange, param.renderScale + maxScaleChange);
+		}
+	}
+
+	targetScale = glm::round(targetScale / scaleStep) * scaleStep;
+	targetScale = glm::clamp(targetScale, glm::min(param.minScale, 1.f), 1.f);
+	if (targetScale == param.renderScale)
+		return false;
+
+	param.renderScale = targetScale;
+	framesSinceChange = 0;
+	return true;
+}
@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////
+// Scales the internal render resolution so the measured GPU frame
+// time stays inside a budget.  The scene is drawn into the top-left
+// part of the full-size render targets and upscaled to the back
+// buffer, so changing the scale never reallocates anything.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+struct dynamicResolutionParam
+{
+	bool enabled = true;
+	float gpuBudgetMs = 15.f;   // leaves some headroom below 60 Hz
+	float minScale = 0.5f;
+	float renderScale = 1.f;
+	float gpuFrameMs = 0.f;
+};
+
+class dynamicResolution
+{
+public:
+	dynamicResolution();
+	~dynamicResolution();
+	bool update(dynamicResolutionParam& param, float gpuFrameMs);
+private:
+	float averageMs = 0.f;
+	int framesSinceChange = 0;
+	const float smoothing = 0.1f;
+	const float scaleStep = 0.05f;
+	const float maxScaleChange = 0.1f;
+	const int cooldownFrames = 15;
+};
@@ -1,8 +1,8 @@
 ///////////////////////////////////////////////////////////////////////
 // A slight encapsulation of a Frame Buffer Object (i'e' Render
-// Target) and its associated texture.  When the FBO is "Bound", the
-// output of the graphics pipeline is captured into the texture.  When
-// it is "Unbound", the texture is available for use as any normal
+// Target) and its associated textures.  When the FBO is "Bound", the
+// output of the graphics pipeline is captured into the textures.  When
+// it is "Unbound", the textures are available for use as any normal
 // texture.
 //
 // Copyright 2013 DigiPen Institute of Technology
@@ -12,50 +12,151 @@
 
 #include "shader.h"
 #include "fbo.h"
-#include "scene.h"
-#include "GL\glew.h"
+#include "GL/glew.h"
+#include "glState.h"
 #include <GL/freeglut.h>
 
+// Storage cost of the sized formats used for render targets.
+static int formatBytesPerPixel(unsigned int internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_R8:                 return 1;
+	case GL_R16F:
+	case GL_RG8:
+	case GL_DEPTH_COMPONENT16:  return 2;
+	case GL_RGB16F:             return 6;
+	case GL_RGBA16F:
+	case GL_RG32F:              return 8;
+	case GL_RGB32F:             return 12;
+	case GL_RGBA32F:            return 16;
+	default:                    return 4;  // RGBA8, RG16, R32F, depth 24/32F, ...
+	}
+}
+
+// Legacy target: one RGBA32F color texture and a depth renderbuffer.
 void FBO::CreateFBO(const int w, const int h)
 {
-	width = w;
-	height = h;
-
-    glGenFramebuffersEXT(1, &fbo);  
-    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo);
-        
-    // Create a render buffer, and attach it to FBO's depth attachment
-    unsigned int depthBuffer;
-    glGenRenderbuffersEXT(1, &depthBuffer);
-    glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, depthBuffer);
-    glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT,
-							 width, height);
-    glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT,
-                                 GL_RENDERBUFFER_EXT, depthBuffer);
-
-    // Create texture and attach FBO's color 0 attachment
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_ARB, width, height,
-                 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);        
-
-    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT,
-                              GL_COLOR_ATTACHMENT0_EXT,
-                              GL_TEXTURE_2D, texture, 0);
+	fboDesc legacy;
+	legacy.width = w;
+	legacy.height = h;
+	legacy.colorFormats.push_back(GL_RGBA32F);
+	legacy.depthFormat = GL_DEPTH_COMPONENT24;
+	legacy.sampleDepth = false;
+	Create(legacy);
+}
+
+bool fboDesc::operator==(const fboDesc& other) const
+{
+	return width == other.width && height == other.height && layers == other.layers &&
+		   samples == other.samples && colorFormats == other.colorFormats &&
+		   depthFormat == other.depthFormat && sampleDepth == other.sampleDepth;
+}
+
+static int textureTarget(const fboDesc& desc)
+{
+	if (desc.samples > 0)
+		return GL_TEXTURE_2D_MULTISAMPLE;
+	return desc.layers > 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+}
+
+void FBO::Create(const fboDesc& description)
+{
+	desc = description;
+	width = desc.width;
+	height = desc.height;
+	int target = textureTarget(desc);
+
+	// created and filled through direct state access, so nothing bound
+	// is disturbed.  Filtering, wrapping and compare modes come from the
+	// shared sampler objects (see samplerLibrary) at the point of use.
+	glCreateFramebuffers(1, &fbo);
+
+	// immutable storage; every format in the descriptor must be sized
+	std::vector<unsigned int> textures(desc.colorFormats.size() + (desc.depthFormat && desc.sampleDepth ? 1 : 0));
+	if (!textures.empty())
+		glCreateTextures(target, (int)textures.size(), &textures.front());
+	for (unsigned int i = 0; i < textures.size(); ++i)
+	{
+		bool isDepth = i == desc.colorFormats.size();
+		unsigned int format = isDepth ? desc.depthFormat : desc.colorFormats[i];
+		if (isDepth)
+			depthTexture = textures[i];
+		else
+			colorTextures.push_back(textures[i]);
+
+		if (desc.samples > 0)
+			glTextureStorage2DMultisample(textures[i], desc.samples, format, width, height, GL_TRUE);
+		else if (desc.layers > 0)
+			glTextureStorage3D(textures[i], 1, format, width, height, desc.layers);
+		else
+			glTextureStorage2D(textures[i], 1, format, width, height);
+	}
+
+	if (desc.depthFormat && !desc.sampleDepth)
+	{
+		glCreateRenderbuffers(1, &depthRenderbuffer);
+		glNamedRenderbufferStorageMultisample(depthRenderbuffer, desc.samples, desc.depthFormat, width, height);
+		glNamedFramebufferRenderbuffer(fbo, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+	}
+	BindLayer(0);
+
+	if (colorTextures.empty())
+	{
+		// depth only
+		glNamedFramebufferDrawBuffer(fbo, GL_NONE);
+		glNamedFramebufferReadBuffer(fbo, GL_NONE);
+	}
+	else
+	{
+		std::vector<unsigned int> drawBuffers;
+		for (unsigned int i = 0; i < colorTextures.size(); ++i)
+			drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+		glNamedFramebufferDrawBuffers(fbo, (int)drawBuffers.size(), &drawBuffers.front());
+	}
 
     // Check for completeness/correctness
-    int status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
-    if (status != GL_FRAMEBUFFER_COMPLETE_EXT)
+    int status = glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
         printf("FBO Error: %d\n", status);
+}
+
+void FBO::Release()
+{
+	for (unsigned int texture : colorTextures)
+		glState::onDeleteTexture(texture);
+	glState::onDeleteTexture(depthTexture);
+	glState::onDeleteFramebuffer(fbo);
+	if (!colorTextures.empty())
+		glDeleteTextures((int)colorTextures.size(), &colorTextures.front());
+	colorTextures.clear();
+	glDeleteTextures(1, &depthTexture);
+	glDeleteRenderbuffers(1, &depthRenderbuffer);
+	glDeleteFramebuffers(1, &fbo);
+	depthTexture = 0;
+	depthRenderbuffer = 0;
+	fbo = 0;
+}
 
-    // Unbind the fbo.  
-    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+// Attaches the given layer of every array attachment to the FBO.
+// For plain 2D targets this (re)attaches the textures.
+void FBO::BindLayer(const int layer)
+{
+	bool layered = desc.layers > 0 && desc.samples == 0;
+	for (unsigned int i = 0; i < colorTextures.size(); ++i)
+	{
+		if (layered)
+			glNamedFramebufferTextureLayer(fbo, GL_COLOR_ATTACHMENT0 + i, colorTextures[i], 0, layer);
+		else
+			glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0 + i, colorTextures[i], 0);
+	}
+	if (depthTexture)
+	{
+		if (layered)
+			glNamedFramebufferTextureLayer(fbo, GL_DEPTH_ATTACHMENT, depthTexture, 0, layer);
+		else
+			glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+	}
 }
 
 unsigned int FBO::getFBO()
@@ -65,7 +166,47 @@ unsigned int FBO::getFBO()
 
 unsigned int FBO::getFBOTexture()
 {
-	return texture;
+	return getColorTexture(0);
+}
+
+unsigned int FBO::getColorTexture(const int index)
+{
+	return index < (int)colorTextures.size() ? colorTextures[index] : 0;
+}
+
+unsigned int FBO::getDepthTexture()
+{
+	return depthTexture;
+}
+
+const fboDesc& FBO::getDesc()
+{
+	return desc;
+}
+
+int FBO::getColorBytesPerPixel()
+{
+	int bytes = 0;
+	for (unsigned int i = 0; i < desc.colorFormats.size(); ++i)
+		bytes += formatBytesPerPixel(desc.colorFormats[i]);
+	return bytes;
+}
+
+int FBO::getDepthBytesPerPixel()
+{
+	return desc.depthFormat ? formatBytesPerPixel(desc.depthFormat) : 0;
+}
+
+int FBO::getBytesPerPixel()
+{
+	return getColorBytesPerPixel() + getDepthBytesPerPixel();
+}
+
+// Video memory held by the attachments.
+size_t FBO::getSizeInBytes()
+{
+	size_t pixels = (size_t)width * height * (desc.layers > 0 ? desc.layers : 1) * (desc.samples > 0 ? desc.samples : 1);
+	return pixels * getBytesPerPixel();
 }
 
 void FBO::getWidthAndHeight(int& FBOWidth, int& FBOHeight)
@@ -74,16 +215,19 @@ void FBO::getWidthAndHeight(int& FBOWidth, int& FBOHeight)
 	FBOHeight = height;
 }
 
+// Reallocates every attachment at the new size, keeping the rest of
+// the descriptor.
 void FBO::setWidthAndHeight(const int &FBOWidth, const int &FBOHeight)
 {
 	if (width != FBOWidth || height != FBOHeight)
 	{
-		glDeleteFramebuffers(1, &fbo);
-		glDeleteTextures(1, &texture);
-
-		CreateFBO(FBOWidth, FBOHeight);
+		fboDesc resized = desc;
+		resized.width = FBOWidth;
+		resized.height = FBOHeight;
+		Release();
+		Create(resized);
 	}
 }
 
-void FBO::Bind() { glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo); }
-void FBO::Unbind() { glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0); }
+void FBO::Bind() { glState::bindFramebuffer(GL_FRAMEBUFFER, fbo); }
+void FBO::Unbind() { glState::bindFramebuffer(GL_FRAMEBUFFER, 0); }
@@ -1,26 +1,61 @@
 ///////////////////////////////////////////////////////////////////////
 // A slight encapsulation of a Frame Buffer Object (i'e' Render
-// Target) and its associated texture.  When the FBO is "Bound", the
-// output of the graphics pipeline is captured into the texture.  When
-// it is "Unbound", the texture is available for use as any normal
+// Target) and its associated textures.  When the FBO is "Bound", the
+// output of the graphics pipeline is captured into the textures.  When
+// it is "Unbound", the textures are available for use as any normal
 // texture.
 //
+// What gets allocated is described by an fboDesc: any number of color
+// attachments (MRT) in any sized format, and an optional depth
+// attachment that is either a renderbuffer or a texture.  How the
+// textures are sampled is up to the sampler bound with them.  A target with no color
+// attachments is depth only.  With layers > 0 every attachment is a
+// 2D array texture and BindLayer picks the layer rendered to.  With
+// samples > 0 the attachments are multisampled instead.
+//
 // Copyright 2013 DigiPen Institute of Technology
 ////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
+struct fboDesc
+{
+	int width = 0, height = 0;
+	int layers = 0;
+	int samples = 0;
+	std::vector<unsigned int> colorFormats;  // sized internal formats, one per draw buffer
+	unsigned int depthFormat = 0;            // GL_DEPTH_COMPONENT16/24/32F, 0 for none
+	bool sampleDepth = true;                 // depth texture; false uses a renderbuffer
+
+	bool operator==(const fboDesc& other) const;
+};
+
 class FBO {
 public:
 	void CreateFBO(const int w, const int h);
+	void Create(const fboDesc& desc);
+	void Release();
 	void Bind();
 	void Unbind();
+	void BindLayer(const int layer);
 	void getWidthAndHeight(int& FBOWidth, int& FBOHeight);
 	void setWidthAndHeight(const int &FBOWidth, const int &FBOHeight);
 	unsigned int getFBO();
 	unsigned int getFBOTexture();
+	unsigned int getColorTexture(const int index);
+	unsigned int getDepthTexture();
+	const fboDesc& getDesc();
+	int getColorBytesPerPixel();
+	int getDepthBytesPerPixel();
+	int getBytesPerPixel();
+	size_t getSizeInBytes();
 private:
-	unsigned int fbo;
-	unsigned int texture;
-	int width, height;  // Size of the texture.
-	
+	fboDesc desc;
+	unsigned int fbo = 0;
+	std::vector<unsigned int> colorTextures;
+	unsigned int depthTexture = 0;
+	unsigned int depthRenderbuffer = 0;
+	int width = 0, height = 0;  // Size of the textures.
 };
@@ -0,0 +1,183 @@
+#include "frameArena.h"
+#include <assert.h>
+#include <mutex>
+#include <new>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+frameArena::half frameArena::halves[2];
+std::atomic<unsigned int> frameArena::frameIndex(0);
+int frameArena::warmFrames = 0;
+
+// overflowing is the exception, a lock keeps its block list simple
+static std::mutex overflowLock;
+
+////////////////////////////////////////////////////////////////////////
+// The global operator new and delete are replaced to count the heap
+// allocations of watched threads while a check is running.
+#ifdef FRAME_HEAP_CHECK
+static std::atomic<bool> heapCheckRunning(false);
+static std::atomic<int> heapAllocations(0);
+static thread_local bool watchedThread = false;
+
+static void* countedAllocation(size_t size)
+{
+	if (watchedThread && heapCheckRunning.load(std::memory_order_relaxed))
+		heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size)
+{
+	return countedAllocation(size);
+}
+
+void* operator new[](size_t size)
+{
+	return countedAllocation(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+#endif
+
+void frameArena::initialize(size_t bytesPerFrame)
+{
+	release();
+	for (half& h : halves)
+	{
+		h.capacity = bytesPerFrame;
+		h.memory = (unsigned char*)::operator new(bytesPerFrame);
+	}
+}
+
+void frameArena::release()
+{
+	for (half& h : halves)
+	{
+		h.head.store(0);
+		reset(h);
+		::operator delete(h.memory);
+		h.memory = nullptr;
+		h.capacity = 0;
+	}
+}
+
+void frameArena::beginFrame(frameArenaParam& param)
+{
+	half& previous = halves[frameIndex.load() & 1];
+	param.bytesUsed = (int)previous.head.load();
+	param.overflows = previous.overflows.load();
+	half& current = halves[(frameIndex.load() + 1) & 1];
+	reset(current);
+	param.capacity = (int)current.capacity;
+	frameIndex.fetch_add(1);
+}
+
+// head has kept counting past the end, so it says what the frame
+// asked for in all
+void frameArena::reset(half& current)
+{
+	size_t needed = current.head.load();
+	for (void* block : current.overflowBlocks)
+		::operator delete(block);
+	current.overflowBlocks.clear();
+	if (needed > current.capacity)
+	{
+		::operator delete(current.memory);
+		current.capacity = needed > current.capacity * 2 ? needed : current.capacity * 2;
+		current.memory = (unsigned char*)::operator new(current.capacity);
+	}
+	current.head.store(0);
+	current.overflows.store(0);
+}
+
+// Offsets are aligned from the start of the block, which operator new
+// aligns for any fundamental type.
+void* frameArena::allocate(size_t size, size_t alignment)
+{
+	half& current = halves[frameIndex.load(std::memory_order_relaxed) & 1];
+	size_t start = current.head.fetch_add(size + alignment - 1, std::memory_order_relaxed);
+	size_t aligned = (start + alignment - 1) & ~(alignment - 1);
+	if (aligned + size > current.capacity)
+		return overflow(current, size);
+	return current.memory + aligned;
+}
+
+void* frameArena::overflow(half& current, size_t size)
+{
+	current.overflows.fetch_add(1, std::memory_order_relaxed);
+	void* block = ::operator new(size ? size : 1);
+	std::lock_guard<std::mutex> lock(overflowLock);
+	current.overflowBlocks.push_back(block);
+	return block;
+}
+
+char* frameArena::format(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	va_list measure;
+	va_copy(measure, args);
+	int length = vsnprintf(nullptr, 0, format, measure);
+	va_end(measure);
+	char* text = (char*)allocate(length > 0 ? length + 1 : 1, 1);
+	if (length > 0)
+		vsnprintf(text, length + 1, format, args);
+	else
+		text[0] = '\0';
+	va_end(args);
+	return text;
+}
+
+unsigned int frameArena::getFrameIndex()
+{
+	return frameIndex.load(std::memory_order_relaxed);
+}
+
+void frameArena::watchThread()
+{
+#ifdef FRAME_HEAP_CHECK
+	watchedThread = true;
+#endif
+}
+
+void frameArena::beginHeapCheck()
+{
+#ifdef FRAME_HEAP_CHECK
+	watchedThread = true;
+	heapAllocations.store(0, std::memory_order_relaxed);
+	heapCheckRunning.store(true, std::memory_order_seq_cst);
+#endif
+}
+
+void frameArena::endHeapCheck(frameArenaParam& param)
+{
+#ifdef FRAME_HEAP_CHECK
+	heapCheckRunning.store(false, std::memory_order_seq_cst);
+	param.heapAllocations = heapAllocations.load(std::memory_order_relaxed);
+	if (warmFrames >= WARM_UP_FRAMES && param.heapAllocations > 0)
+	{
+		fprintf(stderr, "DrawScene made %d heap allocations in a warm frame\n", param.heapAllocations);
+		assert(!"heap allocation in a warm frame");
+	}
+	if (warmFrames < WARM_UP_FRAMES)
+		++warmFrames;
+#endif
+}
+
+void frameArena::resetWarmUp()
+{
+	warmFrames = 0;
+}
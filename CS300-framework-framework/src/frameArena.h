@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////
+// Per-frame linear allocator for data that only lives for a frame or
+// two: visible lists, command lists, sort keys, temporary strings.
+// Allocating bumps an offset, atomically so jobs can allocate too;
+// nothing is freed on its own.  There are two halves, and beginFrame
+// resets the older one and switches to it, so whatever the previous
+// frame allocated is still valid during this one (to compare against,
+// say) and gone the frame after.
+//
+// A frame that needs more than a half holds falls back to the heap
+// for the rest, and the half grows to fit the next time it is reset.
+// frameAllocator plugs the arena into STL containers (frameVector),
+// and format prints temporary strings into it.  A container must not
+// be kept past the next frame; growing one leaves its old block
+// behind, so reserve first.
+//
+// FRAME_HEAP_CHECK builds (debug builds by default) also count heap
+// allocations made by the main thread and the job workers between
+// beginHeapCheck and endHeapCheck, i.e. inside DrawScene, and assert
+// that there are none once WARM_UP_FRAMES frames went by since the
+// scene last changed shape (see resetWarmUp).
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#if defined(_DEBUG)
+#define FRAME_HEAP_CHECK
+#endif
+
+struct frameArenaParam
+{
+	int bytesUsed = 0;              // last frame
+	int capacity = 0;               // per half
+	int overflows = 0;              // last frame, allocations that went to the heap
+	int heapAllocations = -1;       // last DrawScene, -1 without FRAME_HEAP_CHECK
+};
+
+class frameArena
+{
+public:
+	static const size_t DEFAULT_CAPACITY = 1 << 20;
+	static const int WARM_UP_FRAMES = 16;
+
+	static void initialize(size_t bytesPerFrame = DEFAULT_CAPACITY);
+	static void release();
+	static void beginFrame(frameArenaParam& param);
+	// Valid until the frame after this one.  Never null.
+	static void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	template <class T>
+	static T* allocateArray(size_t count)
+	{
+		return (T*)allocate(count * sizeof(T), alignof(T));
+	}
+	// printf into arena memory
+	static char* format(const char* format, ...);
+	static unsigned int getFrameIndex();
+
+	// heap allocation check, does nothing without FRAME_HEAP_CHECK
+	static void watchThread();
+	static void beginHeapCheck();
+	static void endHeapCheck(frameArenaParam& param);
+	static void resetWarmUp();
+private:
+	struct half
+	{
+		unsigned char* memory = nullptr;
+		size_t capacity = 0;
+		std::atomic<size_t> head;
+		std::atomic<int> overflows;
+		std::vector<void*> overflowBlocks;
+		half() : head(0), overflows(0)
+		{
+
+		}
+	};
+	static void* overflow(half& current, size_t size);
+	static void reset(half& current);
+
+	static half halves[2];
+	static std::atomic<unsigned int> frameIndex;
+	static int warmFrames;
+
+	frameArena();
+	~frameArena();
+};
+
+// Stateless, so any two compare equal and containers can swap and
+// move their storage freely.  deallocate does nothing: the arena takes
+// everything back at once.
+template <class T>
+struct frameAllocator
+{
+	typedef T value_type;
+
+	frameAllocator()
+	{
+
+	}
+
+	template <class U>
+	frameAllocator(const frameAllocator<U>&)
+	{
+
+	}
+
+	T* allocate(size_t count)
+	{
+		return frameArena::allocateArray<T>(count);
+	}
+
+	void deallocate(T*, size_t)
+	{
+
+	}
+};
+
+template <class T, class U>
+bool operator==(const frameAllocator<T>&, const frameAllocator<U>&)
+{
+	return true;
+}
+
+template <class T, class U>
+bool operator!=(const frameAllocator<T>&, const frameAllocator<U>&)
+{
+	return false;
+}
+
+template <class T>
+using frameVector = std::vector<T, frameAllocator<T>>;
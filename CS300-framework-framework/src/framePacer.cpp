@@ -0,0 +1,140 @@
+#include "framePacer.h"
+#include "profiler.h"
+#include <algorithm>
+#include <thread>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+static double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+framePacer::framePacer()
+{
+
+}
+
+framePacer::~framePacer()
+{
+
+}
+
+void framePacer::initialize()
+{
+#ifdef _WIN32
+	// the default 15.6 ms timer resolution would make every sleep a hitch
+	timeBeginPeriod(1);
+#endif
+	intervals.initialize(HISTORY_SIZE);
+	jitters.initialize(HISTORY_SIZE);
+	latencies.initialize(HISTORY_SIZE);
+	deadline = clock::now();
+}
+
+void framePacer::waitForNextFrame(framePacingParam& param, void (*pumpEvents)())
+{
+	PROFILE_ZONE("framePacer::wait");
+	pumpEvents();
+	clock::time_point now = clock::now();
+	if (param.mode != FIXED_RATE)
+	{
+		lastMode = param.mode;
+		deadline = now;
+		return;
+	}
+
+	std::chrono::duration<double, std::milli> period(1000.0 / std::max(param.targetRate, 1.f));
+	if (lastMode != FIXED_RATE || resync)
+	{
+		lastMode = param.mode;
+		resync = false;
+		deadline = now;
+		return;
+	}
+	deadline += std::chrono::duration_cast<clock::duration>(period);
+	if (now > deadline + std::chrono::duration_cast<clock::duration>(period))
+	{
+		++param.missedDeadlines;
+		deadline = now;
+		return;
+	}
+
+	// sleep in short steps so the events keep flowing
+	std::chrono::duration<double, std::milli> spin(std::max(param.spinMs, 0.f));
+	clock::time_point spinFrom = deadline - std::chrono::duration_cast<clock::duration>(spin);
+	while ((now = clock::now()) < spinFrom)
+	{
+		std::chrono::duration<double, std::milli> left = spinFrom - now;
+		std::this_thread::sleep_for(std::min(left, std::chrono::duration<double, std::milli>(1.0)));
+		pumpEvents();
+	}
+	while (clock::now() < deadline)
+		;
+}
+
+void framePacer::onInput()
+{
+	if (!hasPendingInput)
+	{
+		pendingInput = clock::now();
+		hasPendingInput = true;
+	}
+}
+
+void framePacer::sampleInput()
+{
+	hasFrameInput = hasPendingInput;
+	frameInput = pendingInput;
+	hasPendingInput = false;
+}
+
+void framePacer::onPresent(framePacingParam& param)
+{
+	clock::time_point now = clock::now();
+	if (hasPresent)
+	{
+		float intervalMs = (float)millisecondsBetween(lastPresent, now);
+		intervals.add(intervalMs);
+		if (hasInterval)
+			jitters.add(fabsf(intervalMs - lastIntervalMs));
+		lastIntervalMs = intervalMs;
+		hasInterval = true;
+	}
+	if (hasFrameInput)
+	{
+		latencies.add((float)millisecondsBetween(frameInput, now));
+		hasFrameInput = false;
+	}
+	lastPresent = now;
+	hasPresent = true;
+	++presents;
+
+	if (presents % 8 == 0)
+	{
+		intervals.summarize(param.interval);
+		jitters.summarize(param.jitter);
+		latencies.summarize(param.inputLatency);
+	}
+}
+
+void framePacer::idle(framePacingParam& param, void (*pumpEvents)())
+{
+	PROFILE_ZONE("framePacer::idle");
+	std::chrono::duration<double, std::milli> period(1000.0 / std::max(param.targetRate, 1.f));
+	clock::time_point until = clock::now() + std::chrono::duration_cast<clock::duration>(period);
+	clock::time_point now;
+	while (!hasPendingInput && (now = clock::now()) < until)
+	{
+		std::chrono::duration<double, std::milli> left = until - now;
+		std::this_thread::sleep_for(std::min(left, std::chrono::duration<double, std::milli>(1.0)));
+		pumpEvents();
+	}
+	hasPresent = false;
+	hasInterval = false;
+	resync = true;
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////
+// Decides when the next frame starts.  Three modes:
+//   VSYNC       draw right away, the buffer swap waits for the display
+//   FIXED_RATE  start frames on a fixed grid of deadlines: sleep until
+//               shortly before the deadline, then spin, since sleeps
+//               overshoot by up to a scheduler tick
+//   UNCAPPED    draw right away, no swap interval
+// Deadlines advance by whole periods from the previous deadline, not
+// from when the frame happened to start, so the rate does not drift.
+// A frame late by more than a period resynchronizes instead of
+// rushing out the missed ones back to back.
+//
+// While waiting, the window system's events keep being pumped, and
+// input is only applied once the wait is over, just before the frame
+// is submitted.  onInput stamps the first input event not yet
+// applied, sampleInput hands it to the frame about to be drawn and
+// onPresent (right after the swap) measures from there: input to
+// present latency, plus the present to present interval and its
+// jitter (the change from one interval to the next).
+//
+// A frame that is not drawn at all (on-demand rendering, see
+// onDemandRendering.h) calls idle instead of presenting: it sleeps for
+// up to a period of the target rate, waking up on input, and the
+// interval after it is not measured.  Pacing starts over from the
+// next frame, so the first frame after an idle spell is not late.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "rollingStats.h"
+#include <chrono>
+
+struct framePacingParam;
+
+class framePacer
+{
+public:
+	enum eMode
+	{
+		VSYNC = 0,
+		FIXED_RATE,
+		UNCAPPED,
+		MODE_COUNT,
+	};
+	static const int HISTORY_SIZE = 240;
+
+	framePacer();
+	~framePacer();
+	void initialize();
+	// Returns when the next frame should start, calling pumpEvents
+	// meanwhile (at least once).
+	void waitForNextFrame(framePacingParam& param, void (*pumpEvents)());
+	void onInput();
+	void sampleInput();
+	void onPresent(framePacingParam& param);
+	void idle(framePacingParam& param, void (*pumpEvents)());
+private:
+	typedef std::chrono::steady_clock clock;
+	clock::time_point deadline;
+	clock::time_point lastPresent;
+	clock::time_point pendingInput;     // first input since the last sample
+	clock::time_point frameInput;       // first input the current frame applies
+	bool hasPresent = false;
+	bool hasInterval = false;
+	bool resync = true;
+	bool hasPendingInput = false;
+	bool hasFrameInput = false;
+	float lastIntervalMs = 0.f;
+	int lastMode = -1;
+	int presents = 0;
+	rollingStats intervals;
+	rollingStats jitters;
+	rollingStats latencies;
+};
+
+struct framePacingParam
+{
+	int mode = framePacer::FIXED_RATE;
+	float targetRate = 60.f;        // frames per second, FIXED_RATE and idle
+	float spinMs = 2.f;             // the end of the wait that is spun
+	int missedDeadlines = 0;        // FIXED_RATE frames later than a period
+	timingSummary interval;         // present to present
+	timingSummary jitter;           // |interval - previous interval|
+	timingSummary inputLatency;     // first applied input to present
+};
@@ -0,0 +1,291 @@
+#include "shader.h"
+#include "fbo.h"
+#include "scene.h"
+#include "frameRecording.h"
+#include "profiler.h"
+#include "frameArena.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string.h>
+#include <stdio.h>
+
+static const char RECORDING_MAGIC[4] = { 'W', 'I', 'P', 'R' };
+static const unsigned int RECORDING_VERSION = 1;
+// what a recording reserves when it starts
+static const size_t RECORDING_RESERVE = 64 * 1024;
+
+struct recordingHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int frameCount;
+	unsigned int pointLightCount;
+	unsigned int directionalLightCount;
+};
+
+// Followed by pointLightChanges x (index, pointLightParam), then
+// directionalLightChanges x (index, directionalLightParam), then an
+// ambientLightParam when ambientChanged is set.
+struct frameRecord
+{
+	float time;                     // wall clock seconds into the recording
+	glm::vec3 cameraPosition;
+	glm::vec3 cameraLookAt;
+	unsigned int pointLightChanges;
+	unsigned short directionalLightChanges;
+	unsigned short ambientChanged;
+};
+
+// the parameters are copied and compared as bytes, so they must be
+// nothing but floats
+static_assert(sizeof(frameRecord) == 36, "frameRecord is not packed");
+static_assert(sizeof(pointLightParam) == 13 * sizeof(float), "pointLightParam has padding");
+static_assert(sizeof(directionalLightParam) == 9 * sizeof(float), "directionalLightParam has padding");
+static_assert(sizeof(ambientLightParam) == 4 * sizeof(float), "ambientLightParam has padding");
+
+static void append(std::vector<unsigned char> &data, const void *bytes, size_t size)
+{
+	const unsigned char *first = (const unsigned char*)bytes;
+	data.insert(data.end(), first, first + size);
+}
+
+static bool read(frameRecordingState &state, void *bytes, size_t size)
+{
+	if (state.readOffset + size > state.data.size())
+		return false;
+	memcpy(bytes, state.data.data() + state.readOffset, size);
+	state.readOffset += size;
+	return true;
+}
+
+bool startRecording(Scene &scene, const char *path)
+{
+	stopReplay(scene);
+	stopRecording(scene);
+	frameRecordingState &state = scene.recording;
+	state.path = path;
+	state.data.clear();
+	state.data.reserve(RECORDING_RESERVE);
+	recordingHeader header;
+	memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+	header.version = RECORDING_VERSION;
+	header.frameCount = 0;
+	header.pointLightCount = (unsigned int)scene.pointLightParameters.size();
+	header.directionalLightCount = (unsigned int)scene.directionalLightParameters.size();
+	append(state.data, &header, sizeof(header));
+	state.frame = 0;
+	state.bytes = (int)state.data.size();
+	state.start = std::chrono::steady_clock::now();
+	state.mode = frameRecordingState::RECORDING;
+	return true;
+}
+
+bool stopRecording(Scene &scene)
+{
+	frameRecordingState &state = scene.recording;
+	if (state.mode != frameRecordingState::RECORDING)
+		return false;
+	state.mode = frameRecordingState::OFF;
+	((recordingHeader*)state.data.data())->frameCount = (unsigned int)state.frame;
+
+	std::ofstream file(state.path, std::ofstream::binary);
+	file.write((const char*)state.data.data(), state.data.size());
+	if (!file)
+	{
+		printf("Recording: could not write %s\n", state.path.c_str());
+		return false;
+	}
+	printf("Recording: %d frames, %d bytes written to %s\n", state.frame, (int)state.data.size(), state.path.c_str());
+	state.data.clear();
+	state.data.shrink_to_fit();
+	return true;
+}
+
+bool startReplay(Scene &scene, const char *path, bool loop)
+{
+	stopRecording(scene);
+	frameRecordingState &state = scene.recording;
+	state.mode = frameRecordingState::OFF;
+	std::ifstream file(path, std::ifstream::binary);
+	if (!file)
+	{
+		printf("Replay: could not open %s\n", path);
+		return false;
+	}
+	state.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	state.readOffset = 0;
+
+	recordingHeader header;
+	if (!read(state, &header, sizeof(header)) || memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != RECORDING_VERSION)
+	{
+		printf("Replay: %s is not a version %u recording\n", path, RECORDING_VERSION);
+		return false;
+	}
+	if (header.pointLightCount != scene.pointLightParameters.size() ||
+		header.directionalLightCount != scene.directionalLightParameters.size())
+	{
+		printf("Replay: %s was recorded with %u point and %u directional lights, the scene has %d and %d\n",
+			   path, header.pointLightCount, header.directionalLightCount,
+			   (int)scene.pointLightParameters.size(), (int)scene.directionalLightParameters.size());
+		return false;
+	}
+	state.path = path;
+	state.loop = loop;
+	state.frame = 0;
+	state.frameCount = (int)header.frameCount;
+	state.bytes = (int)state.data.size();
+	state.time = 0.f;
+	state.mode = frameRecordingState::REPLAYING;
+	printf("Replay: %d frames from %s\n", state.frameCount, path);
+	return true;
+}
+
+void stopReplay(Scene &scene)
+{
+	frameRecordingState &state = scene.recording;
+	if (state.mode != frameRecordingState::REPLAYING)
+		return;
+	state.mode = frameRecordingState::OFF;
+	state.data.clear();
+	state.data.shrink_to_fit();
+}
+
+// Everything on the first frame, only the changes after that.
+static void recordFrame(Scene &scene)
+{
+	frameRecordingState &state = scene.recording;
+	const recordingHeader &header = *(const recordingHeader*)state.data.data();
+	if (scene.pointLightParameters.size() != header.pointLightCount ||
+		scene.directionalLightParameters.size() != header.directionalLightCount)
+	{
+		printf("Recording: the number of lights changed, stopping\n");
+		stopRecording(scene);
+		frameArena::resetWarmUp();
+		return;
+	}
+	bool everything = state.frame == 0;
+
+	unsigned int* changedPoints = frameArena::allocateArray<unsigned int>(header.pointLightCount);
+	unsigned int* changedDirectionals = frameArena::allocateArray<unsigned int>(header.directionalLightCount);
+	unsigned int pointChanges = 0, directionalChanges = 0;
+	for (unsigned int i = 0; i < header.pointLightCount; ++i)
+	{
+		if (everything || memcmp(&scene.pointLightParameters[i], &state.pointLights[i], sizeof(pointLightParam)) != 0)
+			changedPoints[pointChanges++] = i;
+	}
+	for (unsigned int i = 0; i < header.directionalLightCount; ++i)
+	{
+		if (everything || memcmp(&scene.directionalLightParameters[i], &state.directionalLights[i], sizeof(directionalLightParam)) != 0)
+			changedDirectionals[directionalChanges++] = i;
+	}
+	bool ambientChanged = everything || memcmp(&scene.ambientLightParameters, &state.ambient, sizeof(ambientLightParam)) != 0;
+
+	frameRecord record;
+	record.time = std::chrono::duration<float>(std::chrono::steady_clock::now() - state.start).count();
+	record.cameraPosition = scene.gEditorCamera.getPosition();
+	record.cameraLookAt = scene.gEditorCamera.getLookAt();
+	record.pointLightChanges = pointChanges;
+	record.directionalLightChanges = (unsigned short)directionalChanges;
+	record.ambientChanged = ambientChanged ? 1 : 0;
+	append(state.data, &record, sizeof(record));
+	for (unsigned int change = 0; change < pointChanges; ++change)
+	{
+		unsigned int i = changedPoints[change];
+		append(state.data, &i, sizeof(i));
+		append(state.data, &scene.pointLightParameters[i], sizeof(pointLightParam));
+	}
+	for (unsigned int change = 0; change < directionalChanges; ++change)
+	{
+		unsigned int i = changedDirectionals[change];
+		append(state.data, &i, sizeof(i));
+		append(state.data, &scene.directionalLightParameters[i], sizeof(directionalLightParam));
+	}
+	if (ambientChanged)
+		append(state.data, &scene.ambientLightParameters, sizeof(ambientLightParam));
+
+	state.pointLights = scene.pointLightParameters;
+	state.directionalLights = scene.directionalLightParameters;
+	state.ambient = scene.ambientLightParameters;
+	++state.frame;
+	state.bytes = (int)state.data.size();
+}
+
+static bool replayFrame(Scene &scene)
+{
+	frameRecordingState &state = scene.recording;
+	frameRecord record;
+	if (!read(state, &record, sizeof(record)))
+		return false;
+	scene.gEditorCamera.initialize(record.cameraPosition, record.cameraLookAt);
+
+	for (unsigned int change = 0; change < record.pointLightChanges; ++change)
+	{
+		unsigned int i;
+		pointLightParam param;
+		if (!read(state, &i, sizeof(i)) || !read(state, &param, sizeof(param)) || i >= scene.pointLightParameters.size())
+			return false;
+		scene.pointLightParameters[i] = param;
+	}
+	for (unsigned int change = 0; change < record.directionalLightChanges; ++change)
+	{
+		unsigned int i;
+		directionalLightParam param;
+		if (!read(state, &i, sizeof(i)) || !read(state, &param, sizeof(param)) || i >= scene.directionalLightParameters.size())
+			return false;
+		scene.directionalLightParameters[i] = param;
+	}
+	if (record.ambientChanged && !read(state, &scene.ambientLightParameters, sizeof(ambientLightParam)))
+		return false;
+
+	state.time = state.frame * state.step;
+	++state.frame;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Makes room for a record with every light in it, doubling the buffer
+// when it runs short, so recordFrame never has to grow it.
+void reserveFrameRecording(Scene &scene)
+{
+	frameRecordingState &state = scene.recording;
+	if (state.mode != frameRecordingState::RECORDING)
+		return;
+	size_t largest = sizeof(frameRecord) + sizeof(ambientLightParam) +
+					 scene.pointLightParameters.size() * (sizeof(unsigned int) + sizeof(pointLightParam)) +
+					 scene.directionalLightParameters.size() * (sizeof(unsigned int) + sizeof(directionalLightParam));
+	if (state.data.capacity() - state.data.size() < largest)
+		state.data.reserve(std::max(state.data.capacity() * 2, state.data.size() + largest));
+}
+
+void updateFrameRecording(Scene &scene)
+{
+	frameRecordingState &state = scene.recording;
+	if (state.mode == frameRecordingState::RECORDING)
+	{
+		PROFILE_ZONE("recordFrame");
+		recordFrame(scene);
+	}
+	else if (state.mode == frameRecordingState::REPLAYING)
+	{
+		PROFILE_ZONE("replayFrame");
+		if (state.frame == state.frameCount)
+		{
+			if (!state.loop)
+			{
+				printf("Replay: done after %d frames\n", state.frame);
+				stopReplay(scene);
+				return;
+			}
+			// the first record holds every parameter, so this restores them all
+			state.readOffset = sizeof(recordingHeader);
+			state.frame = 0;
+		}
+		if (!replayFrame(scene))
+		{
+			printf("Replay: %s is cut short at frame %d\n", state.path.c_str(), state.frame);
+			stopReplay(scene);
+		}
+	}
+}
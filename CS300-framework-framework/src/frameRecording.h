@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////
+// Records what the user changes from frame to frame (the camera and
+// every light parameter) into a compact binary file, and plays such a
+// file back in place of the mouse and the tweak bars, so performance
+// runs before and after a change render the very same frames.
+//
+// A recording is a header followed by one record per frame: the
+// camera position and look-at point, then only the point lights,
+// directional lights and ambient light whose parameters differ from
+// the previous record (the first record has them all).  A still camera
+// costs 36 bytes per frame.
+//
+// On replay the scene time advances by a fixed step per frame instead
+// of the wall clock, so the time the shaders see is the same on every
+// run.  The scene must have as many lights as when it was recorded.
+// Dynamic resolution reacts to the GPU time and should be off for
+// comparisons.
+//
+// updateFrameRecording runs in DrawScene before the camera update, so
+// the framework and the benchmark both record and replay.  The record
+// buffer only grows in reserveFrameRecording, which DrawScene calls
+// before its heap allocation check starts (see frameArena.h).
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "lightManager.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+class Scene;
+
+struct frameRecordingState
+{
+	enum eMode
+	{
+		OFF = 0,
+		RECORDING,
+		REPLAYING,
+	};
+	eMode mode = OFF;
+	std::string path;
+	float step = 1.f / 60.f;        // replay seconds per frame
+	bool loop = false;              // replay from the start again at the end
+	float time = 0.f;               // replay scene time
+	int frame = 0;                  // recorded or replayed so far
+	int frameCount = 0;             // of the replay
+	int bytes = 0;                  // recorded so far, or size of the replay
+	// recording: the records so far, written out when it stops
+	// replay: the whole file
+	std::vector<unsigned char> data;
+	size_t readOffset = 0;
+	std::chrono::steady_clock::time_point start;
+	// what the last record left the lights at, to find the changes
+	pointLightParamContainter pointLights;
+	directionLightParamContainter directionalLights;
+	ambientLightParam ambient;
+};
+
+bool startRecording(Scene &scene, const char *path);
+bool stopRecording(Scene &scene);
+bool startReplay(Scene &scene, const char *path, bool loop);
+void stopReplay(Scene &scene);
+void reserveFrameRecording(Scene &scene);
+void updateFrameRecording(Scene &scene);
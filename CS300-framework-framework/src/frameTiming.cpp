@@ -0,0 +1,190 @@
+#include "frameTiming.h"
+
+#include "prettywriter.h"
+#include "stringbuffer.h"
+#include <fstream>
+#include <stdio.h>
+
+bool frameTiming::started = false;
+std::chrono::steady_clock::time_point frameTiming::frameStart;
+std::chrono::steady_clock::time_point frameTiming::sliceStart;
+frameTiming::eStage frameTiming::activeStages[MAX_DEPTH];
+int frameTiming::depth = 0;
+double frameTiming::stageMs[STAGE_COUNT];
+rollingStats frameTiming::frameStats;
+rollingStats frameTiming::stageStats[STAGE_COUNT];
+
+static double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+frameTiming::frameTiming()
+{
+
+}
+
+frameTiming::~frameTiming()
+{
+
+}
+
+// The running stage is charged up to now and paused; leave resumes it.
+void frameTiming::enter(eStage stage)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (depth > 0)
+		stageMs[activeStages[depth - 1]] += millisecondsBetween(sliceStart, now);
+	if (depth < MAX_DEPTH)
+		activeStages[depth] = stage;
+	++depth;
+	sliceStart = now;
+}
+
+void frameTiming::leave()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	--depth;
+	if (depth < MAX_DEPTH)
+		stageMs[activeStages[depth]] += millisecondsBetween(sliceStart, now);
+	sliceStart = now;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Closes the frame begun by the previous call: its time and stage
+// split go into the windows, the latest values into param right away
+// and the rest of the summary every SUMMARY_INTERVAL frames.
+void frameTiming::beginFrame(frameTimingParam& param)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (!started)
+	{
+		frameStats.initialize(HISTORY_SIZE);
+		for (int i = 0; i < STAGE_COUNT; ++i)
+		{
+			stageStats[i].initialize(HISTORY_SIZE);
+			stageMs[i] = 0.0;
+		}
+		started = true;
+		frameStart = now;
+		return;
+	}
+
+	float frameMs = (float)millisecondsBetween(frameStart, now);
+	frameStart = now;
+	frameStats.add(frameMs);
+	param.frame.lastMs = frameMs;
+	for (int i = 0; i < STAGE_COUNT; ++i)
+	{
+		stageStats[i].add((float)stageMs[i]);
+		param.stages[i].lastMs = (float)stageMs[i];
+	}
+
+	if (frameMs > param.hitchBudgetMs)
+	{
+		frameTimingHitch hitch;
+		hitch.frame = param.frames;
+		hitch.frameMs = frameMs;
+		for (int i = 0; i < STAGE_COUNT; ++i)
+			hitch.stageMs[i] = (float)stageMs[i];
+		if ((int)param.hitchLog.size() >= MAX_HITCH_LOG)
+			param.hitchLog.erase(param.hitchLog.begin());
+		param.hitchLog.push_back(hitch);
+		++param.hitches;
+		param.lastHitchFrame = param.frames;
+		if (frameMs > param.worstHitchMs)
+			param.worstHitchMs = frameMs;
+	}
+	for (int i = 0; i < STAGE_COUNT; ++i)
+		stageMs[i] = 0.0;
+	++param.frames;
+
+	if (param.frames % SUMMARY_INTERVAL == 0)
+		summarize(param);
+}
+
+void frameTiming::summarize(frameTimingParam& param)
+{
+	frameStats.summarize(param.frame);
+	for (int i = 0; i < STAGE_COUNT; ++i)
+		stageStats[i].summarize(param.stages[i]);
+	param.fps = param.frame.meanMs > 0.f ? 1000.f / param.frame.meanMs : 0.f;
+}
+
+const char* frameTiming::getStageName(int stage)
+{
+	static const char* names[STAGE_COUNT] = { "update", "culling", "submission", "swap" };
+	return stage >= 0 && stage < STAGE_COUNT ? names[stage] : "";
+}
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> jsonWriter;
+
+static void writeTiming(jsonWriter& writer, const char* name, const timingSummary& summary, rollingStats& stats)
+{
+	std::vector<float> samples;
+	stats.getSamples(samples);
+	writer.Key(name);
+	writer.StartObject();
+	writer.Key("mean"); writer.Double(summary.meanMs);
+	writer.Key("min");  writer.Double(summary.minMs);
+	writer.Key("p50");  writer.Double(summary.p50Ms);
+	writer.Key("p95");  writer.Double(summary.p95Ms);
+	writer.Key("p99");  writer.Double(summary.p99Ms);
+	writer.Key("max");  writer.Double(summary.maxMs);
+	writer.Key("samples");
+	writer.StartArray();
+	for (float sample : samples)
+		writer.Double(sample);
+	writer.EndArray();
+	writer.EndObject();
+}
+
+////////////////////////////////////////////////////////////////////////
+// Run totals, the summaries and samples of the window (oldest first,
+// in ms) and the hitch log.
+bool frameTiming::writeReport(const char* path, frameTimingParam& param)
+{
+	summarize(param);
+	rapidjson::StringBuffer buffer;
+	jsonWriter writer(buffer);
+	writer.StartObject();
+	writer.Key("frames");        writer.Int(param.frames);
+	writer.Key("window");        writer.Int(frameStats.getCount());
+	writer.Key("hitchBudgetMs"); writer.Double(param.hitchBudgetMs);
+	writer.Key("hitches");       writer.Int(param.hitches);
+	writer.Key("worstHitchMs");  writer.Double(param.worstHitchMs);
+	writer.Key("fps");           writer.Double(param.fps);
+	writeTiming(writer, "frameMs", param.frame, frameStats);
+	writer.Key("stagesMs");
+	writer.StartObject();
+	for (int i = 0; i < STAGE_COUNT; ++i)
+		writeTiming(writer, getStageName(i), param.stages[i], stageStats[i]);
+	writer.EndObject();
+	writer.Key("hitchLog");
+	writer.StartArray();
+	for (const frameTimingHitch& hitch : param.hitchLog)
+	{
+		writer.StartObject();
+		writer.Key("frame");   writer.Int(hitch.frame);
+		writer.Key("frameMs"); writer.Double(hitch.frameMs);
+		for (int i = 0; i < STAGE_COUNT; ++i)
+		{
+			writer.Key(getStageName(i));
+			writer.Double(hitch.stageMs[i]);
+		}
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+
+	std::ofstream file(path, std::ofstream::binary);
+	file.write(buffer.GetString(), buffer.GetSize());
+	file << "\n";
+	if (!file)
+	{
+		printf("Frame timing: could not write %s\n", path);
+		return false;
+	}
+	printf("Frame timing: %d frames written to %s\n", param.frames, path);
+	return true;
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////
+// CPU frame timing on std::chrono::steady_clock.  beginFrame marks
+// the frame boundary: the time between two calls is the frame time,
+// whatever the loop spent it on (drawing, waiting for the next timer
+// tick, ...).  Inside a frame the work is split into stages with
+// frameTiming::scope; scopes nest and are exclusive, so culling inside
+// the submission scope is not counted as submission too.
+//
+// The last HISTORY_SIZE frames of every series are kept in rolling
+// windows and summarized (p50, p95, p99, max, ...) into a
+// frameTimingParam for the tweak bar.  A frame longer than the hitch
+// budget counts as a hitch and is logged with its stage split.
+// writeReport dumps the run so far, window samples included, as JSON.
+//
+// Only for the thread that draws; the stages are plain statics like
+// glState's counters.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "rollingStats.h"
+#include <chrono>
+#include <vector>
+
+struct frameTimingParam;
+
+class frameTiming
+{
+public:
+	enum eStage
+	{
+		UPDATE = 0,                 // camera, lights, animation, frame constants
+		CULLING,                    // visibility tests and shadow tile allocation
+		SUBMISSION,                 // GL calls of the passes and the UI
+		SWAP,                       // buffer swap, or glFinish without a window
+		STAGE_COUNT,
+	};
+	static const int HISTORY_SIZE = 600;
+	static const int SUMMARY_INTERVAL = 8;  // frames between two summaries
+	static const int MAX_HITCH_LOG = 100;
+
+	// Times everything until the end of the block under one stage.
+	class scope
+	{
+	public:
+		scope(eStage stage) { frameTiming::enter(stage); }
+		~scope() { frameTiming::leave(); }
+	};
+
+	static void beginFrame(frameTimingParam& param);
+	static void summarize(frameTimingParam& param);
+	static const char* getStageName(int stage);
+	static bool writeReport(const char* path, frameTimingParam& param);
+private:
+	frameTiming();
+	~frameTiming();
+	static void enter(eStage stage);
+	static void leave();
+
+	static const int MAX_DEPTH = 8;
+	static bool started;
+	static std::chrono::steady_clock::time_point frameStart;
+	static std::chrono::steady_clock::time_point sliceStart;
+	static eStage activeStages[MAX_DEPTH];
+	static int depth;
+	static double stageMs[STAGE_COUNT];  // of the frame in progress
+	static rollingStats frameStats;
+	static rollingStats stageStats[STAGE_COUNT];
+};
+
+struct frameTimingHitch
+{
+	int frame;
+	float frameMs;
+	float stageMs[frameTiming::STAGE_COUNT];
+};
+
+struct frameTimingParam
+{
+	float hitchBudgetMs = 25.f;     // one and a half 60 Hz frames
+	float fps = 0.f;                // from the mean frame time of the window
+	int frames = 0;                 // since the start
+	int hitches = 0;                // since the start
+	float worstHitchMs = 0.f;
+	int lastHitchFrame = -1;
+	timingSummary frame;
+	timingSummary stages[frameTiming::STAGE_COUNT];
+	std::vector<frameTimingHitch> hitchLog;  // the latest frameTiming::MAX_HITCH_LOG
+};
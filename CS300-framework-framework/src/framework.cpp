@@ -2,7 +2,7 @@
 // Provides the framework for graphics projects.  Most of this small
 // file contains the GLUT calls needed to open a window and hook up
 // various callbacks for mouse/keyboard interaction and screen resizes
-// and redisplays.
+// and redisplays.  The frames are paced by RunFrameLoop (framePacer.h).
 //
 // Copyright 2013 DigiPen Institute of Technology
 ////////////////////////////////////////////////////////////////////////
@@ -26,16 +26,28 @@
     #include <fstream>
 #endif
 
-#include "GL\glew.h"
+#include "GL/glew.h"
+#ifdef _WIN32
+#include "GL/wglew.h"
+#else
+#include "GL/glxew.h"
+#endif
 #include <GL/glut.h>
 #include <GL/freeglut.h>
 #include "AntTweakBar.h"
 #include <sstream>
+#include <string.h>
 #include "math.h"
 
 #include "timer.h"
 #include "globals.h"
+#include "glDebug.h"
+#include "profiler.h"
+#include "framePacer.h"
+#include "onDemandRendering.h"
 Scene scene;
+framePacer pacer;
+bool running = true;
 
 // Some globals used for mouse handling.
 int mouseX, mouseY;
@@ -44,21 +56,135 @@ bool middleDown = false;
 bool rightDown = false;
 bool shifted;
 
+// Camera moves collected by the mouse callbacks and applied together
+// by ApplyInput, as late as possible before the frame is submitted.
+struct pendingInput
+{
+	float orbitX = 0.f, orbitY = 0.f;   // left drag, pixels
+	float panX = 0.f, panY = 0.f;       // right drag, pixels
+	int wheel = 0;
+};
+pendingInput input;
+
 ////////////////////////////////////////////////////////////////////////
-// Called by GLUT when the scene needs to be redrawn.
+// Draws and presents one frame; called by RunFrameLoop.
 void ReDraw()
 {
+	frameTiming::beginFrame(scene.frameTimingParameters);
     DrawScene(scene);
-	TwDraw();
+	// a sampler left on unit 0 would override AntTweakBar's font texture
+	glState::bindSampler(0, 0);
+	{
+		PROFILE_ZONE("TwDraw");
+		frameTiming::scope submission(frameTiming::SUBMISSION);
+		GL_DEBUG_PUSH_GROUP("UI");
+		scene.uiTimer.begin();
+		TwDraw();
+		scene.uiTimer.end();
+		GL_DEBUG_POP_GROUP();
+	}
+	// AntTweakBar sets its own program, textures, blend state, ...
+	glState::invalidate();
+	PROFILE_ZONE("glutSwapBuffers");
+	frameTiming::scope swap(frameTiming::SWAP);
     glutSwapBuffers();
 	
 }
 
-void TimerUpdate(int time)
+////////////////////////////////////////////////////////////////////////
+// Called by GLUT when the window needs to be redrawn; the frame loop
+// draws it, even when rendering on demand.
+void ExposeWindow()
 {
-	global::timer::updateTimer(glutGet(GLUT_ELAPSED_TIME) / 1000.f);
-	glutPostRedisplay();
-	glutTimerFunc(1000.f / 60.f, TimerUpdate, 0);
+	requestRedraw(scene);
+}
+
+// Every input event may change what is shown, directly or through
+// the tweak bars, so it is always worth a frame.
+void OnInput()
+{
+	pacer.onInput();
+	requestRedraw(scene);
+}
+
+// The mouse moves scale with the frame time, like they did when they
+// were applied event by event.  The simulation thread, when running,
+// owns the camera and gets them posted.
+void ApplyInput()
+{
+	float dt = global::timer::mDt;
+	if (scene.simulation.isRunning())
+	{
+		if (input.orbitX != 0.f || input.orbitY != 0.f || input.panX != 0.f || input.panY != 0.f || input.wheel != 0)
+			scene.simulation.postCameraInput(input.orbitX * dt, input.orbitY * dt,
+											 glm::vec2(input.panX * dt, input.panY * dt), input.wheel * dt);
+	}
+	else
+	{
+		if (input.orbitX != 0.f || input.orbitY != 0.f)
+		{
+			scene.gEditorCamera.horizontalMove(input.orbitX * dt);
+			scene.gEditorCamera.verticalMove(input.orbitY * dt);
+		}
+		if (input.panX != 0.f || input.panY != 0.f)
+			scene.gEditorCamera.setPanDir(glm::vec2(input.panX * dt, input.panY * dt));
+		if (input.wheel != 0)
+			scene.gEditorCamera.zoom(input.wheel * dt);
+	}
+	input = pendingInput();
+	pacer.sampleInput();
+}
+
+void SetSwapInterval(int interval)
+{
+#ifdef _WIN32
+	if (WGLEW_EXT_swap_control)
+		wglSwapIntervalEXT(interval);
+#else
+	if (GLXEW_EXT_swap_control)
+		glXSwapIntervalEXT(glXGetCurrentDisplay(), glXGetCurrentDrawable(), interval);
+	else if (GLXEW_MESA_swap_control)
+		glXSwapIntervalMESA(interval);
+#endif
+}
+
+void PumpEvents()
+{
+	glutMainLoopEvent();
+}
+
+////////////////////////////////////////////////////////////////////////
+// Replaces glutMainLoop: the frame pacer decides when each frame
+// starts and pumps GLUT's events until then, so input is applied at
+// the last moment.  See framePacer.h for the modes.  Frames with
+// nothing new to show are neither drawn nor swapped when rendering on
+// demand (onDemandRendering.h); the window keeps the last one.
+void RunFrameLoop()
+{
+	int swapInterval = -1;
+	while (running)
+	{
+		pacer.waitForNextFrame(scene.framePacingParameters, PumpEvents);
+		if (!running)
+			break;
+		int interval = scene.framePacingParameters.mode == framePacer::VSYNC ? 1 : 0;
+		if (interval != swapInterval)
+		{
+			SetSwapInterval(interval);
+			swapInterval = interval;
+		}
+		global::timer::updateTimer();
+		ApplyInput();
+		if (scene.simulation.isRunning())
+			scene.simulation.sync(scene);
+		if (!beginOnDemandFrame(scene))
+		{
+			pacer.idle(scene.framePacingParameters, PumpEvents);
+			continue;
+		}
+		ReDraw();
+		pacer.onPresent(scene.framePacingParameters);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -66,16 +192,20 @@ void TimerUpdate(int time)
 void ReshapeWindow(int w, int h)
 {
     if (w && h) {
-        glViewport(0, 0, w, h); }
+        glState::viewport(0, 0, w, h); }
     scene.width = w;
     scene.height = h;
-    glutPostRedisplay();
+    // render targets are reallocated by the next DrawScene
+    frameArena::resetWarmUp();
+    TwWindowSize(w, h);
+    requestRedraw(scene);
 }
 
 ////////////////////////////////////////////////////////////////////////
 // Called by GLut for keyboard actions.
 void KeyboardInput(unsigned char key, int x, int y)
 {
+	OnInput();
 	if (!TwEventKeyboardGLUT(key, x, y))
 	{
 		switch (key) {
@@ -97,6 +227,11 @@ void KeyboardInput(unsigned char key, int x, int y)
 			exit(0);
 		}
 	}
+	else
+	{
+		// a tweak bar edit may change what a frame allocates
+		frameArena::resetWarmUp();
+	}
     
 }
 
@@ -104,6 +239,7 @@ void KeyboardInput(unsigned char key, int x, int y)
 // Called by GLut when a mouse button changes state.
 void MouseButton(int button, int state, int x, int y)
 {
+	OnInput();
 	if (!TwEventMouseButtonGLUT(button, state, x, y))
 	{
 		shifted = glutGetModifiers() && GLUT_ACTIVE_SHIFT;
@@ -134,12 +270,17 @@ void MouseButton(int button, int state, int x, int y)
 
 		//glutPostRedisplay();
 	}
+	else
+	{
+		frameArena::resetWarmUp();
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////
 // Called by GLut when a mouse moves (while a button is down)
 void MouseMotion(int x, int y)
 {
+	OnInput();
 	if (!TwEventMouseMotionGLUT(x, y))
 	{
 		int dx = x - mouseX;
@@ -152,8 +293,8 @@ void MouseMotion(int x, int y)
 
 		else if (leftDown)
 		{
-			scene.gEditorCamera.horizontalMove((dx * global::timer::mDt));
-			scene.gEditorCamera.verticalMove((dy * global::timer::mDt));
+			input.orbitX += dx;
+			input.orbitY += dy;
 		}
 
 
@@ -173,8 +314,8 @@ void MouseMotion(int x, int y)
 		else if (rightDown) {
 			scene.translatex += dx / 20.0f;
 			scene.translatey -= dy / 20.0f;
-			scene.gEditorCamera.setPanDir(glm::vec2(-dx * global::timer::mDt,
-				                                    -dy * global::timer::mDt));
+			input.panX -= dx;
+			input.panY -= dy;
 		}
 
 		// Record this position 
@@ -184,19 +325,16 @@ void MouseMotion(int x, int y)
 		// Draw the scene, transformed by the new values.
 		//glutPostRedisplay();
 	}
+	else
+	{
+		frameArena::resetWarmUp();
+	}
 }
 
 void MouseWheel(int wheel, int direction, int x, int y)
 {
-	float cameraSpeed = 50.f;
-	if (direction > 0)
-	{
-		scene.gEditorCamera.zoom(direction * global::timer::mDt);
-	}
-	else
-	{
-		scene.gEditorCamera.zoom(direction * global::timer::mDt);
-	}
+	OnInput();
+	input.wheel += direction;
 	glutPostRedisplay();
 }
 
@@ -204,55 +342,251 @@ void MouseWheel(int wheel, int direction, int x, int y)
 // on exit callback function to clean up any resources allocated
 void cleanUp()
 {
+	running = false;
+	scene.simulation.stop();
+	jobSystem::shutdown();
+	frameArena::release();
+	stopRecording(scene);
+	frameTiming::writeReport("frame_timing.json", scene.frameTimingParameters);
 	TwTerminate();
 }
 
+////////////////////////////////////////////////////////////////////////
+// AntTweakBar button: dumps the profiler's zones, GPU passes included.
+void TW_CALL ExportTrace(void* clientData)
+{
+	profiler::exportChromeTrace("trace.json");
+}
+
+////////////////////////////////////////////////////////////////////////
+// AntTweakBar buttons: camera and light recording, see frameRecording.h.
+void TW_CALL StartRecording(void* clientData)
+{
+	startRecording(scene, "recording.bin");
+}
+
+void TW_CALL StopRecording(void* clientData)
+{
+	stopRecording(scene);
+}
+
+void TW_CALL StartReplay(void* clientData)
+{
+	startReplay(scene, "recording.bin", scene.recording.loop);
+}
+
+void TW_CALL StopReplay(void* clientData)
+{
+	stopReplay(scene);
+}
+
+////////////////////////////////////////////////////////////////////////
+// AntTweakBar button: the CPU frame timing of the run so far.
+void TW_CALL DumpFrameTiming(void* clientData)
+{
+	frameTiming::writeReport("frame_timing.json", scene.frameTimingParameters);
+}
+
+////////////////////////////////////////////////////////////////////////
+// One collapsed subgroup of the parent group (GPUTiming, FrameTiming)
+// per timed pass or stage.
+void addTimingVars(TwBar* bar, const char* label, const char* group, const char* parent, timingSummary& timing)
+{
+	const char* statNames[] = { "Mean", "P50", "P95", "P99", "Min", "Max" };
+	float* statValues[] = { &timing.meanMs, &timing.p50Ms, &timing.p95Ms, &timing.p99Ms, &timing.minMs, &timing.maxMs };
+	std::stringstream groupDef;
+	groupDef << "group=" << group;
+	for (int i = 0; i < 6; ++i)
+	{
+		std::stringstream name;
+		name << label << " " << statNames[i] << " (ms)";
+		TwAddVarRO(bar, name.str().c_str(), TW_TYPE_FLOAT, statValues[i], groupDef.str().c_str());
+	}
+	std::stringstream define;
+	define << " '" << TwGetBarName(bar) << "'/" << group << " group=" << parent << " label='" << label << "' opened=false ";
+	TwDefine(define.str().c_str());
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Do the OpenGL/GLut setup and then enter the interactive loop.
 int main(int argc, char** argv)
 {
+    PROFILE_THREAD_NAME("Main");
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
-	glutInitContextVersion (4, 4);
+	glutInitContextVersion (4, 5);
 	glutInitContextProfile(GLUT_COMPATIBILITY_PROFILE);
+#ifdef GL_DEBUG_LAYER
+	glutInitContextFlags(GLUT_DEBUG);
+#endif
 
 
 	glutInitWindowSize(global::gWidth, global::gHeight);
     glutCreateWindow("WIP Graphics");
 	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
 
-	glewExperimental = TRUE;
+	glewExperimental = GL_TRUE;
 	GLenum err = glewInit();
 	if (GLEW_OK != err)
 	{
 		fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
 		return -1;
 	}
+	GL_DEBUG_INITIALIZE();
 
 	printf("OpenGL Version: %s\n", glGetString(GL_VERSION));
 	printf("GLSL Version: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
 	printf("Rendered by: %s\n", glGetString(GL_RENDERER));
 
-    glutDisplayFunc(&ReDraw);
+    glutDisplayFunc(&ExposeWindow);
     glutReshapeFunc(&ReshapeWindow);
     glutKeyboardFunc(&KeyboardInput);
     glutMouseFunc(&MouseButton);
 	glutMouseWheelFunc(&MouseWheel);
     glutMotionFunc(&MouseMotion);
-	glutTimerFunc(1000.f/ 60.f, &TimerUpdate, 0);
 	glutCloseFunc(cleanUp);
 
+	// a worker per hardware thread, the asset loading already uses them
+	jobSystem::initialize();
+	frameArena::initialize();
     InitializeScene(scene);
 
-	global::timer::initializeTimer(0.0);
+	// framework [--record file] [--replay file] [--on-demand] [--sim-thread],
+	// after GLUT took its options
+	bool startSimulation = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--on-demand"))
+			scene.onDemandParameters.enabled = true;
+		else if (!strcmp(argv[i], "--sim-thread"))
+			startSimulation = true;
+		else if (i + 1 == argc)
+			break;
+		else if (!strcmp(argv[i], "--record"))
+			startRecording(scene, argv[++i]);
+		else if (!strcmp(argv[i], "--replay"))
+			startReplay(scene, argv[++i], true);
+	}
+	if (startSimulation)
+		scene.simulation.start(scene);
+
+	global::timer::initializeTimer();
+	pacer.initialize();
 	TwInit(TW_OPENGL_CORE, NULL);
 	TwWindowSize((int)global::gWidth, (int)global::gHeight);
 
 	TwBar* atSceneControl = TwNewBar("Scene Control");
 	TwBar* atLightControl = TwNewBar("Lighting Control");
-	TwAddVarRO(atSceneControl, "FPS", TW_TYPE_FLOAT, &global::timer::mFPS, "");
+	TwAddVarRO(atSceneControl, "FPS", TW_TYPE_FLOAT, &scene.frameTimingParameters.fps, "");
+	TwAddVarRW(atSceneControl, "Hitch Budget (ms)", TW_TYPE_FLOAT, &scene.frameTimingParameters.hitchBudgetMs, "group=FrameTiming min=1 max=1000 step=0.5");
+	TwAddVarRO(atSceneControl, "Hitches", TW_TYPE_INT32, &scene.frameTimingParameters.hitches, "group=FrameTiming");
+	TwAddVarRO(atSceneControl, "Last Hitch Frame", TW_TYPE_INT32, &scene.frameTimingParameters.lastHitchFrame, "group=FrameTiming");
+	TwAddVarRO(atSceneControl, "Worst Hitch (ms)", TW_TYPE_FLOAT, &scene.frameTimingParameters.worstHitchMs, "group=FrameTiming");
+	addTimingVars(atSceneControl, "CPU Frame", "CPUFrame", "FrameTiming", scene.frameTimingParameters.frame);
+	const char* stageLabels[frameTiming::STAGE_COUNT] = { "CPU Update", "CPU Culling", "CPU Submission", "CPU Swap" };
+	for (int i = 0; i < frameTiming::STAGE_COUNT; ++i)
+	{
+		std::stringstream group;
+		group << "CPUStage" << i;
+		addTimingVars(atSceneControl, stageLabels[i], group.str().c_str(), "FrameTiming", scene.frameTimingParameters.stages[i]);
+	}
+	TwAddButton(atSceneControl, "Dump Frame Timing", DumpFrameTiming, nullptr, "group=FrameTiming label='Write frame_timing.json'");
+	TwType pacingMode = TwDefineEnumFromString("PacingMode", "VSync,Fixed Rate,Uncapped");
+	TwAddVarRW(atSceneControl, "Pacing Mode", pacingMode, &scene.framePacingParameters.mode, "group=FramePacing");
+	TwAddVarRW(atSceneControl, "Target Rate (Hz)", TW_TYPE_FLOAT, &scene.framePacingParameters.targetRate, "group=FramePacing min=10 max=1000 step=1");
+	TwAddVarRW(atSceneControl, "Spin (ms)", TW_TYPE_FLOAT, &scene.framePacingParameters.spinMs, "group=FramePacing min=0 max=10 step=0.25");
+	TwAddVarRO(atSceneControl, "Missed Deadlines", TW_TYPE_INT32, &scene.framePacingParameters.missedDeadlines, "group=FramePacing");
+	addTimingVars(atSceneControl, "Present Interval", "PresentInterval", "FramePacing", scene.framePacingParameters.interval);
+	addTimingVars(atSceneControl, "Interval Jitter", "IntervalJitter", "FramePacing", scene.framePacingParameters.jitter);
+	addTimingVars(atSceneControl, "Input Latency", "InputLatency", "FramePacing", scene.framePacingParameters.inputLatency);
+	TwAddVarRW(atSceneControl, "Render On Demand", TW_TYPE_BOOL8, &scene.onDemandParameters.enabled, "group=OnDemand");
+	TwAddVarRW(atSceneControl, "Settle Frames", TW_TYPE_INT32, &scene.onDemandParameters.settleFrames, "group=OnDemand min=0 max=60");
+	TwAddVarRO(atSceneControl, "Frames Drawn", TW_TYPE_INT32, &scene.onDemandParameters.framesDrawn, "group=OnDemand");
+	TwAddVarRO(atSceneControl, "Frames Skipped", TW_TYPE_INT32, &scene.onDemandParameters.framesSkipped, "group=OnDemand");
+	TwAddVarRO(atSceneControl, "Skipped (%)", TW_TYPE_FLOAT, &scene.onDemandParameters.skippedPercent, "group=OnDemand");
+	TwAddVarRO(atSceneControl, "Simulation Thread", TW_TYPE_BOOL8, &scene.simulationParameters.threaded, "group=Simulation");
+	TwAddVarRO(atSceneControl, "Tick Rate (Hz)", TW_TYPE_FLOAT, &scene.simulationParameters.tickRate, "group=Simulation");
+	TwAddVarRO(atSceneControl, "Ticks", TW_TYPE_INT32, &scene.simulationParameters.ticks, "group=Simulation");
+	TwAddVarRO(atSceneControl, "Snapshots Applied", TW_TYPE_INT32, &scene.simulationParameters.snapshotsApplied, "group=Simulation");
+	TwAddVarRO(atSceneControl, "Snapshots Dropped", TW_TYPE_INT32, &scene.simulationParameters.snapshotsDropped, "group=Simulation");
+	addTimingVars(atSceneControl, "Simulation Tick", "SimulationTick", "Simulation", scene.simulationParameters.tick);
+
+	TwAddVarRO(atSceneControl, "Job Threads", TW_TYPE_INT32, &scene.jobSystemParameters.threads, "group=JobSystem");
+	TwAddVarRO(atSceneControl, "Jobs Run", TW_TYPE_INT32, &scene.jobSystemParameters.jobsRun, "group=JobSystem");
+	TwAddVarRO(atSceneControl, "Jobs Stolen", TW_TYPE_INT32, &scene.jobSystemParameters.jobsStolen, "group=JobSystem");
+
+	TwAddVarRW(atSceneControl, "Parallel Recording", TW_TYPE_BOOL8, &scene.commandRecordingParameters.parallel, "group=CommandLists");
+	TwAddVarRO(atSceneControl, "Command Lists", TW_TYPE_INT32, &scene.commandRecordingParameters.lists, "group=CommandLists");
+	TwAddVarRO(atSceneControl, "Commands", TW_TYPE_INT32, &scene.commandRecordingParameters.commands, "group=CommandLists");
+	TwAddVarRO(atSceneControl, "Arena Bytes Used", TW_TYPE_INT32, &scene.frameArenaParameters.bytesUsed, "group=FrameArena");
+	TwAddVarRO(atSceneControl, "Arena Capacity", TW_TYPE_INT32, &scene.frameArenaParameters.capacity, "group=FrameArena");
+	TwAddVarRO(atSceneControl, "Arena Overflows", TW_TYPE_INT32, &scene.frameArenaParameters.overflows, "group=FrameArena");
+	TwAddVarRO(atSceneControl, "Heap Allocations", TW_TYPE_INT32, &scene.frameArenaParameters.heapAllocations, "group=FrameArena");
 	TwAddVarRW(atSceneControl, "Show G Buffer", TW_TYPE_BOOL8, &scene.showGBuffer, "");
 	TwAddVarRW(atSceneControl, "Enable Gamma Correction", TW_TYPE_BOOL8, &scene.enableGammaCorrection, "");
+	TwAddVarRW(atSceneControl, "Compact G Buffer", TW_TYPE_BOOL8, &scene.compactGBuffer, "group=GBuffer");
+	TwAddVarRO(atSceneControl, "G Buffer Bytes Per Pixel", TW_TYPE_INT32, &scene.gBufferData.bytesPerPixel, "group=GBuffer");
+	TwAddVarRO(atSceneControl, "Lighting Pass (ms)", TW_TYPE_FLOAT, &scene.gBufferData.lightingPassMs, "group=GBuffer");
+	TwAddVarRO(atSceneControl, "Lighting Pass (GB/s)", TW_TYPE_FLOAT, &scene.gBufferData.lightingPassBandwidth, "group=GBuffer");
+	TwAddVarRO(atSceneControl, "Render Targets", TW_TYPE_INT32, &scene.renderTargetPoolParameters.targetsAllocated, "group=RenderTargets");
+	TwAddVarRO(atSceneControl, "Target Allocations", TW_TYPE_INT32, &scene.renderTargetPoolParameters.allocationsLastFrame, "group=RenderTargets");
+	TwAddVarRO(atSceneControl, "Target Memory (MB)", TW_TYPE_FLOAT, &scene.renderTargetPoolParameters.allocatedMB, "group=RenderTargets");
+	TwAddVarRO(atSceneControl, "Peak In Use (MB)", TW_TYPE_FLOAT, &scene.renderTargetPoolParameters.peakInUseMB, "group=RenderTargets");
+	TwAddVarRW(atSceneControl, "Dynamic Resolution", TW_TYPE_BOOL8, &scene.dynamicResolutionParameters.enabled, "group=DynamicResolution");
+	TwAddVarRW(atSceneControl, "GPU Budget (ms)", TW_TYPE_FLOAT, &scene.dynamicResolutionParameters.gpuBudgetMs, "group=DynamicResolution min=1 max=100 step=0.5");
+	TwAddVarRW(atSceneControl, "Min Render Scale", TW_TYPE_FLOAT, &scene.dynamicResolutionParameters.minScale, "group=DynamicResolution min=0.25 max=1 step=0.05");
+	TwAddVarRO(atSceneControl, "Render Scale", TW_TYPE_FLOAT, &scene.dynamicResolutionParameters.renderScale, "group=DynamicResolution");
+	TwAddVarRO(atSceneControl, "GPU Frame (ms)", TW_TYPE_FLOAT, &scene.dynamicResolutionParameters.gpuFrameMs, "group=DynamicResolution");
+	TwAddVarRW(atSceneControl, "Frames In Flight", TW_TYPE_INT32, &scene.frameDataRingParameters.framesInFlight, "group=FrameData min=1 max=3");
+	TwAddVarRO(atSceneControl, "Frame Data Bytes", TW_TYPE_INT32, &scene.frameDataRingParameters.bytesUsed, "group=FrameData");
+	TwAddVarRO(atSceneControl, "Fence Waits", TW_TYPE_INT32, &scene.frameDataRingParameters.fenceWaits, "group=FrameData");
+	TwAddVarRO(atSceneControl, "Fence Wait (ms)", TW_TYPE_FLOAT, &scene.frameDataRingParameters.fenceWaitMs, "group=FrameData");
+	TwAddVarRO(atSceneControl, "Total Fence Wait (ms)", TW_TYPE_FLOAT, &scene.frameDataRingParameters.totalFenceWaitMs, "group=FrameData");
+	TwAddVarRO(atSceneControl, "GL Calls Issued", TW_TYPE_INT32, &scene.glStateParameters.callsIssued, "group=GLState");
+	TwAddVarRO(atSceneControl, "Redundant Calls Avoided", TW_TYPE_INT32, &scene.glStateParameters.redundantCallsAvoided, "group=GLState");
+	TwAddVarRO(atSceneControl, "Draw Calls", TW_TYPE_INT32, &scene.glStateParameters.drawCalls, "group=GLState");
+	TwAddVarRO(atSceneControl, "Passes Executed", TW_TYPE_INT32, &scene.renderGraphParameters.passesExecuted, "group=RenderGraph");
+	TwAddVarRO(atSceneControl, "Passes Culled", TW_TYPE_INT32, &scene.renderGraphParameters.passesCulled, "group=RenderGraph");
+	TwAddVarRO(atSceneControl, "Clears Merged", TW_TYPE_INT32, &scene.renderGraphParameters.clearsMerged, "group=RenderGraph");
+	TwAddVarRO(atSceneControl, "Barriers", TW_TYPE_INT32, &scene.renderGraphParameters.barriers, "group=RenderGraph");
+	TwAddVarRW(atSceneControl, "Record GPU Timing CSV", TW_TYPE_BOOL8, &scene.gpuTimingParameters.recordCsv, "group=GPUTiming");
+	TwAddVarRO(atSceneControl, "CSV Rows", TW_TYPE_INT32, &scene.gpuTimingParameters.rowsWritten, "group=GPUTiming");
+	for (int i = 0; i < scene.mRenderGraph.getPassCount(); ++i)
+	{
+		std::stringstream group;
+		group << "GPUPass" << i;
+		addTimingVars(atSceneControl, scene.mRenderGraph.getPassName(i), group.str().c_str(), "GPUTiming", scene.renderGraphParameters.passTiming[i]);
+	}
+	addTimingVars(atSceneControl, "UI", "GPUUI", "GPUTiming", scene.gpuTimingParameters.ui);
+	addTimingVars(atSceneControl, "Frame", "GPUFrame", "GPUTiming", scene.gpuTimingParameters.frame);
+#ifdef PROFILER_ENABLED
+	TwAddButton(atSceneControl, "Export Trace", ExportTrace, nullptr, "group=Profiler label='Export trace.json'");
+#endif
+	TwAddButton(atSceneControl, "Start Recording", StartRecording, nullptr, "group=Recording label='Record to recording.bin'");
+	TwAddButton(atSceneControl, "Stop Recording", StopRecording, nullptr, "group=Recording");
+	TwAddButton(atSceneControl, "Start Replay", StartReplay, nullptr, "group=Recording label='Replay recording.bin'");
+	TwAddButton(atSceneControl, "Stop Replay", StopReplay, nullptr, "group=Recording");
+	TwAddVarRW(atSceneControl, "Loop Replay", TW_TYPE_BOOL8, &scene.recording.loop, "group=Recording");
+	TwAddVarRW(atSceneControl, "Replay Step (s)", TW_TYPE_FLOAT, &scene.recording.step, "group=Recording min=0.001 max=1 step=0.001");
+	TwAddVarRO(atSceneControl, "Recording Frame", TW_TYPE_INT32, &scene.recording.frame, "group=Recording");
+	TwAddVarRO(atSceneControl, "Replay Frames", TW_TYPE_INT32, &scene.recording.frameCount, "group=Recording");
+	TwAddVarRO(atSceneControl, "Recording Bytes", TW_TYPE_INT32, &scene.recording.bytes, "group=Recording");
+	TwAddVarRW(atLightControl, "Shadows", TW_TYPE_BOOL8, &scene.dirShadowMap.enabled, "group=Shadows");
+	TwAddVarRW(atLightControl, "Cascades", TW_TYPE_INT32, &scene.dirShadowMap.cascadeCount, "group=Shadows min=3 max=4");
+	TwAddVarRW(atLightControl, "Shadow Map Size", TW_TYPE_INT32, &scene.dirShadowMap.resolution, "group=Shadows min=512 max=4096 step=512");
+	TwAddVarRW(atLightControl, "Shadow Distance", TW_TYPE_FLOAT, &scene.dirShadowMap.shadowDistance, "group=Shadows min=50 max=5000 step=10");
+	TwAddVarRW(atLightControl, "Split Lambda", TW_TYPE_FLOAT, &scene.dirShadowMap.splitLambda, "group=Shadows min=0 max=1 step=0.05");
+	TwAddVarRW(atLightControl, "Stagger Far Cascades", TW_TYPE_BOOL8, &scene.dirShadowMap.staggerUpdates, "group=Shadows");
+	TwAddVarRW(atLightControl, "Show Cascades", TW_TYPE_BOOL8, &scene.dirShadowMap.showCascades, "group=Shadows");
+	TwAddVarRO(atLightControl, "Cascades Rendered", TW_TYPE_INT32, &scene.dirShadowMap.cascadesRendered, "group=Shadows");
+	TwAddVarRO(atLightControl, "Shadow Casters Drawn", TW_TYPE_INT32, &scene.dirShadowMap.castersRendered, "group=Shadows");
+	TwAddVarRW(atLightControl, "Point Shadows", TW_TYPE_BOOL8, &scene.pointShadowMap.enabled, "group=PointShadows");
+	TwAddVarRW(atLightControl, "Point Shadow Atlas Size", TW_TYPE_INT32, &scene.pointShadowMap.atlasSize, "group=PointShadows min=1024 max=8192 step=1024");
+	TwAddVarRW(atLightControl, "Min Face Size", TW_TYPE_INT32, &scene.pointShadowMap.minFaceSize, "group=PointShadows min=16 max=512");
+	TwAddVarRW(atLightControl, "Max Face Size", TW_TYPE_INT32, &scene.pointShadowMap.maxFaceSize, "group=PointShadows min=64 max=2048");
+	TwAddVarRO(atLightControl, "Static Tiles Redrawn", TW_TYPE_INT32, &scene.pointShadowMap.staticTilesRedrawn, "group=PointShadows");
+	TwAddVarRO(atLightControl, "Shadow Tiles Redrawn", TW_TYPE_INT32, &scene.pointShadowMap.shadowTilesRedrawn, "group=PointShadows");
+	TwAddVarRO(atLightControl, "Point Shadow Faces Drawn", TW_TYPE_INT32, &scene.pointShadowMap.facesRendered, "group=PointShadows");
 	TwAddVarRW(atLightControl, "Ambient Light Color", TW_TYPE_COLOR3F, &scene.ambientLightParameters.ambientLightColor, "group=AmbientLight");
 	TwAddVarRW(atLightControl, "Ambient Light Strength", TW_TYPE_FLOAT, &scene.ambientLightParameters.ambientLightStrength, "group=AmbientLight");
 	for (unsigned int i = 0; i < scene.directionalLightParameters.size(); ++i)
@@ -311,5 +645,5 @@ int main(int argc, char** argv)
 	}
 
     // This function enters an event loop.
-    glutMainLoop();
+    RunFrameLoop();
 }
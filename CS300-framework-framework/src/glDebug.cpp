@@ -0,0 +1,124 @@
+#include "glDebug.h"
+#include "GL/glew.h"
+#include <stdio.h>
+#include <string.h>
+
+const char* glDebug::groups[MAX_GROUP_DEPTH];
+int glDebug::depth;
+
+glDebug::glDebug()
+{
+
+}
+
+glDebug::~glDebug()
+{
+
+}
+
+static const char* sourceName(GLenum source)
+{
+	switch (source)
+	{
+	case GL_DEBUG_SOURCE_API:             return "API";
+	case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "window system";
+	case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+	case GL_DEBUG_SOURCE_THIRD_PARTY:     return "third party";
+	case GL_DEBUG_SOURCE_APPLICATION:     return "application";
+	default:                              return "other";
+	}
+}
+
+static const char* typeName(GLenum type)
+{
+	switch (type)
+	{
+	case GL_DEBUG_TYPE_ERROR:               return "error";
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "undefined behavior";
+	case GL_DEBUG_TYPE_PORTABILITY:         return "portability";
+	case GL_DEBUG_TYPE_PERFORMANCE:         return "performance";
+	default:                                return "other";
+	}
+}
+
+static const char* severityName(GLenum severity)
+{
+	switch (severity)
+	{
+	case GL_DEBUG_SEVERITY_HIGH:   return "high";
+	case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+	case GL_DEBUG_SEVERITY_LOW:    return "low";
+	default:                       return "notification";
+	}
+}
+
+// Without GL_DEBUG_OUTPUT_SYNCHRONOUS the driver may call this late or
+// from its own thread, so the group printed is where the CPU was when
+// the message arrived; a frame capture has the exact call.
+static void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+								   GLsizei length, const GLchar* message, const void* userParam)
+{
+	char where[256];
+	glDebug::printGroups(where, sizeof(where));
+	fprintf(stderr, "OpenGL %s %s (%s, id %u) in %s: %s\n", sourceName(source), typeName(type),
+			severityName(severity), id, where, message);
+}
+
+void glDebug::initialize()
+{
+	if (!GLEW_KHR_debug && !GLEW_VERSION_4_3)
+	{
+		printf("Debug output: KHR_debug not available\n");
+		return;
+	}
+	glEnable(GL_DEBUG_OUTPUT);
+	glDebugMessageCallback(debugCallback, nullptr);
+	// everything but chatter and our own group markers
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+	glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	int flags = 0;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+	if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+		printf("Debug output: not a debug context, the driver may report less\n");
+}
+
+void glDebug::label(unsigned int identifier, unsigned int name, const char* text)
+{
+	if (name != 0)
+		glObjectLabel(identifier, name, -1, text);
+}
+
+void glDebug::pushGroup(const char* name)
+{
+	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	if (depth < MAX_GROUP_DEPTH)
+		groups[depth] = name;
+	++depth;
+}
+
+void glDebug::popGroup()
+{
+	if (depth == 0)
+		return;
+	glPopDebugGroup();
+	--depth;
+}
+
+// "Frame/Lighting", or "no group" outside of any
+void glDebug::printGroups(char* buffer, int size)
+{
+	buffer[0] = 0;
+	if (depth == 0)
+	{
+		strncat(buffer, "no group", size - 1);
+		return;
+	}
+	for (int i = 0; i < depth && i < MAX_GROUP_DEPTH; ++i)
+	{
+		if (i > 0)
+			strncat(buffer, "/", size - strlen(buffer) - 1);
+		strncat(buffer, groups[i], size - strlen(buffer) - 1);
+	}
+}
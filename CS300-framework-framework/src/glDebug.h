@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////
+// OpenGL debug output (KHR_debug) for debug builds.  The driver
+// reports errors, performance and portability warnings to a callback
+// as they happen instead of the renderer polling glGetError, which
+// stalls the pipeline.  Objects get readable labels and every render
+// pass runs inside a debug group, so a message (and a frame capture)
+// says what was being drawn.
+//
+// Use the GL_DEBUG_* macros: in release builds they compile to
+// nothing, as does the context flag that turns debug output on.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#if defined(_DEBUG)
+#define GL_DEBUG_LAYER
+#endif
+
+class glDebug
+{
+public:
+	static const int MAX_GROUP_DEPTH = 16;
+	static void initialize();
+	static void label(unsigned int identifier, unsigned int name, const char* text);
+	static void pushGroup(const char* name);
+	static void popGroup();
+	static void printGroups(char* buffer, int size);
+private:
+	glDebug();
+	~glDebug();
+	static const char* groups[MAX_GROUP_DEPTH];
+	static int depth;
+};
+
+#ifdef GL_DEBUG_LAYER
+#define GL_DEBUG_INITIALIZE() glDebug::initialize()
+#define GL_DEBUG_LABEL(identifier, name, text) glDebug::label(identifier, name, text)
+#define GL_DEBUG_PUSH_GROUP(name) glDebug::pushGroup(name)
+#define GL_DEBUG_POP_GROUP() glDebug::popGroup()
+#else
+#define GL_DEBUG_INITIALIZE() ((void)0)
+#define GL_DEBUG_LABEL(identifier, name, text) ((void)0)
+#define GL_DEBUG_PUSH_GROUP(name) ((void)0)
+#define GL_DEBUG_POP_GROUP() ((void)0)
+#endif
@@ -0,0 +1,238 @@
+#include "glState.h"
+#include "GL/glew.h"
+
+// any value GL would never hand out, so the first call always goes through
+static const unsigned int UNKNOWN = 0xFFFFFFFF;
+
+unsigned int glState::program;
+unsigned int glState::vertexArray;
+unsigned int glState::textures[MAX_TEXTURE_UNITS][TARGET_COUNT];
+unsigned int glState::samplers[MAX_TEXTURE_UNITS];
+unsigned int glState::readFramebuffer;
+unsigned int glState::drawFramebuffer;
+int glState::viewportRect[4];
+int glState::capabilities[CAPABILITY_COUNT];
+unsigned int glState::depthFunction;
+int glState::depthWrite;
+unsigned int glState::blendSource;
+unsigned int glState::blendDestination;
+int glState::callsIssued;
+int glState::callsAvoided;
+int glState::draws;
+
+static const unsigned int trackedCapabilities[] = { GL_BLEND, GL_DEPTH_TEST, GL_DEPTH_CLAMP,
+													GL_POLYGON_OFFSET_FILL, GL_SCISSOR_TEST, GL_CULL_FACE };
+
+glState::glState()
+{
+
+}
+
+glState::~glState()
+{
+
+}
+
+bool glState::skip(bool unchanged)
+{
+	if (unchanged)
+		++callsAvoided;
+	else
+		++callsIssued;
+	return unchanged;
+}
+
+int glState::capabilityIndex(unsigned int capability)
+{
+	for (int i = 0; i < CAPABILITY_COUNT; ++i)
+	{
+		if (trackedCapabilities[i] == capability)
+			return i;
+	}
+	return -1;
+}
+
+int glState::targetIndex(unsigned int target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_2D:             return 0;
+	case GL_TEXTURE_2D_ARRAY:       return 1;
+	case GL_TEXTURE_CUBE_MAP:       return 2;
+	case GL_TEXTURE_2D_MULTISAMPLE: return 3;
+	default:                        return -1;
+	}
+}
+
+void glState::useProgram(unsigned int newProgram)
+{
+	if (skip(program == newProgram))
+		return;
+	glUseProgram(newProgram);
+	program = newProgram;
+}
+
+void glState::bindVertexArray(unsigned int vao)
+{
+	if (skip(vertexArray == vao))
+		return;
+	glBindVertexArray(vao);
+	vertexArray = vao;
+}
+
+void glState::bindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+	int index = targetIndex(target);
+	if (unit < MAX_TEXTURE_UNITS && index >= 0 && skip(textures[unit][index] == texture))
+		return;
+	// binds by unit, so there is no active texture unit to keep track of
+	glBindTextureUnit(unit, texture);
+	if (unit < MAX_TEXTURE_UNITS && index >= 0)
+		textures[unit][index] = texture;
+}
+
+void glState::bindSampler(unsigned int unit, unsigned int sampler)
+{
+	if (unit < MAX_TEXTURE_UNITS && skip(samplers[unit] == sampler))
+		return;
+	glBindSampler(unit, sampler);
+	if (unit < MAX_TEXTURE_UNITS)
+		samplers[unit] = sampler;
+}
+
+void glState::bindFramebuffer(unsigned int target, unsigned int fbo)
+{
+	bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+	bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+	if (skip((!read || readFramebuffer == fbo) && (!draw || drawFramebuffer == fbo)))
+		return;
+	// only rebind the half that actually changes
+	if (read && draw && readFramebuffer == fbo)
+		target = GL_DRAW_FRAMEBUFFER;
+	else if (read && draw && drawFramebuffer == fbo)
+		target = GL_READ_FRAMEBUFFER;
+	glBindFramebuffer(target, fbo);
+	if (read)
+		readFramebuffer = fbo;
+	if (draw)
+		drawFramebuffer = fbo;
+}
+
+void glState::viewport(int x, int y, int width, int height)
+{
+	if (skip(viewportRect[0] == x && viewportRect[1] == y && viewportRect[2] == width && viewportRect[3] == height))
+		return;
+	glViewport(x, y, width, height);
+	viewportRect[0] = x;
+	viewportRect[1] = y;
+	viewportRect[2] = width;
+	viewportRect[3] = height;
+}
+
+void glState::setEnabled(unsigned int capability, bool enabled)
+{
+	int index = capabilityIndex(capability);
+	if (index >= 0 && skip(capabilities[index] == (enabled ? 1 : 0)))
+		return;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	if (index >= 0)
+		capabilities[index] = enabled ? 1 : 0;
+}
+
+void glState::depthFunc(unsigned int func)
+{
+	if (skip(depthFunction == func))
+		return;
+	glDepthFunc(func);
+	depthFunction = func;
+}
+
+void glState::depthMask(bool write)
+{
+	if (skip(depthWrite == (write ? 1 : 0)))
+		return;
+	glDepthMask(write ? GL_TRUE : GL_FALSE);
+	depthWrite = write ? 1 : 0;
+}
+
+void glState::blendFunc(unsigned int source, unsigned int destination)
+{
+	if (skip(blendSource == source && blendDestination == destination))
+		return;
+	glBlendFunc(source, destination);
+	blendSource = source;
+	blendDestination = destination;
+}
+
+void glState::bindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset, size_t size)
+{
+	glBindBufferRange(target, index, buffer, offset, size);
+	++callsIssued;
+}
+
+void glState::drawElements(unsigned int mode, int count, unsigned int type)
+{
+	glDrawElements(mode, count, type, 0);
+	++draws;
+}
+
+// GL unbinds a deleted object from every binding point of the context
+void glState::onDeleteTexture(unsigned int texture)
+{
+	for (int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+	{
+		for (int target = 0; target < TARGET_COUNT; ++target)
+		{
+			if (textures[unit][target] == texture)
+				textures[unit][target] = 0;
+		}
+	}
+}
+
+void glState::onDeleteFramebuffer(unsigned int fbo)
+{
+	if (readFramebuffer == fbo)
+		readFramebuffer = 0;
+	if (drawFramebuffer == fbo)
+		drawFramebuffer = 0;
+}
+
+void glState::onDeleteVertexArray(unsigned int vao)
+{
+	if (vertexArray == vao)
+		vertexArray = 0;
+}
+
+void glState::invalidate()
+{
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	for (int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+	{
+		for (int target = 0; target < TARGET_COUNT; ++target)
+			textures[unit][target] = UNKNOWN;
+		samplers[unit] = UNKNOWN;
+	}
+	readFramebuffer = UNKNOWN;
+	drawFramebuffer = UNKNOWN;
+	viewportRect[0] = viewportRect[1] = viewportRect[2] = viewportRect[3] = -1;
+	for (int i = 0; i < CAPABILITY_COUNT; ++i)
+		capabilities[i] = -1;
+	depthFunction = UNKNOWN;
+	depthWrite = -1;
+	blendSource = UNKNOWN;
+	blendDestination = UNKNOWN;
+}
+
+void glState::endFrame(glStateParam& stats)
+{
+	stats.callsIssued = callsIssued;
+	stats.redundantCallsAvoided = callsAvoided;
+	stats.drawCalls = draws;
+	callsIssued = 0;
+	callsAvoided = 0;
+	draws = 0;
+}
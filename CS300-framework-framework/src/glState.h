@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////
+// Shadow copy of the OpenGL binding state the renderer touches every
+// frame: program, vertex array, textures and samplers per unit,
+// read/draw framebuffers, viewport, depth and blend state and a few
+// enable flags.  A call that would not change anything is dropped,
+// and nothing is ever unbound "to be safe": the next user binds what
+// it needs.
+//
+// Code that changes this state behind the cache's back (AntTweakBar,
+// one-off setup code) must call invalidate() afterwards, and deleting
+// a bound object must be reported so its name is not assumed to still
+// be bound when GL reuses it.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>
+
+struct glStateParam
+{
+	int callsIssued = 0;            // last frame
+	int redundantCallsAvoided = 0;
+	int drawCalls = 0;
+};
+
+class glState
+{
+public:
+	static const int MAX_TEXTURE_UNITS = 16;
+	static void useProgram(unsigned int program);
+	static void bindVertexArray(unsigned int vao);
+	static void bindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+	static void bindSampler(unsigned int unit, unsigned int sampler);
+	static void bindFramebuffer(unsigned int target, unsigned int fbo);
+	static void viewport(int x, int y, int width, int height);
+	static void setEnabled(unsigned int capability, bool enabled);
+	static void depthFunc(unsigned int func);
+	static void depthMask(bool write);
+	static void blendFunc(unsigned int source, unsigned int destination);
+	// not cached, only counted
+	static void bindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset, size_t size);
+	static void drawElements(unsigned int mode, int count, unsigned int type);
+	static void onDeleteTexture(unsigned int texture);
+	static void onDeleteFramebuffer(unsigned int fbo);
+	static void onDeleteVertexArray(unsigned int vao);
+	static void invalidate();
+	static void endFrame(glStateParam& stats);
+private:
+	glState();
+	~glState();
+	static bool skip(bool unchanged);
+	static int capabilityIndex(unsigned int capability);
+	static int targetIndex(unsigned int target);
+
+	static const int TARGET_COUNT = 4;  // 2D, 2D array, cube map, 2D multisample
+	static const int CAPABILITY_COUNT = 6;
+	static unsigned int program;
+	static unsigned int vertexArray;
+	static unsigned int textures[MAX_TEXTURE_UNITS][TARGET_COUNT];
+	static unsigned int samplers[MAX_TEXTURE_UNITS];
+	static unsigned int readFramebuffer;
+	static unsigned int drawFramebuffer;
+	static int viewportRect[4];
+	static int capabilities[CAPABILITY_COUNT]; // -1 unknown
+	static unsigned int depthFunction;
+	static int depthWrite;
+	static unsigned int blendSource;
+	static unsigned int blendDestination;
+	static int callsIssued;
+	static int callsAvoided;
+	static int draws;
+};
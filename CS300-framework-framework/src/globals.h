@@ -39,6 +39,10 @@ namespace global
 		DEFERRED_GBUFFER_GAMMA,
 		DEFERRED_LIGHTING_PASS,
 		DEFERRED_LIGHTING_PASS_GAMMA,
+		DEFERRED_GBUFFER_COMPACT,
+		DEFERRED_GBUFFER_COMPACT_GAMMA,
+		DEFERRED_LIGHTING_PASS_COMPACT,
+		DEFERRED_LIGHTING_PASS_COMPACT_GAMMA,
 		MAX_MATERIAL_COUNT,
 	};
 
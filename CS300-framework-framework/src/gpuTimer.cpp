@@ -0,0 +1,99 @@
+#include "gpuTimer.h"
+#include "GL/glew.h"
+#include "profiler.h"
+
+gpuTimer::gpuTimer()
+{
+
+}
+
+gpuTimer::~gpuTimer()
+{
+
+}
+
+void gpuTimer::initialize(int latency, int historyLength)
+{
+	history.initialize(historyLength);
+	startQueries.resize(latency);
+	endQueries.resize(latency);
+	pending.assign(latency, false);
+	glGenQueries(latency, &startQueries.front());
+	glGenQueries(latency, &endQueries.front());
+	current = 0;
+	resultReady = false;
+}
+
+void gpuTimer::begin()
+{
+	collectResults();
+
+	// every slot still in flight, drop this sample rather than wait on the GPU
+	if (pending[current])
+		return;
+
+	glQueryCounter(startQueries[current], GL_TIMESTAMP);
+}
+
+void gpuTimer::end()
+{
+	if (pending[current])
+		return;
+
+	glQueryCounter(endQueries[current], GL_TIMESTAMP);
+	pending[current] = true;
+	current = (current + 1) % (int)pending.size();
+}
+
+void gpuTimer::collectResults()
+{
+	// read back the oldest slots first; stop at the first one not yet finished
+	int slotCount = (int)pending.size();
+	for (int i = 0; i < slotCount; ++i)
+	{
+		int slot = (current + i) % slotCount;
+		if (!pending[slot])
+			continue;
+
+		int available = 0;
+		glGetQueryObjectiv(endQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 startTime, endTime;
+		glGetQueryObjectui64v(startQueries[slot], GL_QUERY_RESULT, &startTime);
+		glGetQueryObjectui64v(endQueries[slot], GL_QUERY_RESULT, &endTime);
+		elapsedMs = (endTime - startTime) / 1000000.f;
+		history.add(elapsedMs);
+		if (name)
+			PROFILE_GPU_ZONE(name, (long long)startTime, (long long)endTime);
+		resultReady = true;
+		++resultCount;
+		pending[slot] = false;
+	}
+}
+
+int gpuTimer::getResultCount()
+{
+	return resultCount;
+}
+
+bool gpuTimer::hasResult()
+{
+	return resultReady;
+}
+
+float gpuTimer::getElapsedMs()
+{
+	return elapsedMs;
+}
+
+void gpuTimer::summarize(timingSummary& summary)
+{
+	history.summarize(summary);
+}
+
+void gpuTimer::setName(const char* timerName)
+{
+	name = timerName;
+}
@@ -0,0 +1,40 @@
+///////////////////////////////////////////////////////////////////////
+// Measures how long the GPU spends on a block of commands.  A pair of
+// GL_TIMESTAMP queries is written around the block, and the result is
+// only read back once the GPU has finished with it, several frames
+// later, so timing never stalls the pipeline.  Timestamp queries (as
+// opposed to GL_TIME_ELAPSED) can be nested inside each other.
+// Every result also goes into a rolling window for mean/min/max/p95,
+// and into the profiler's GPU track when the timer has a name.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <vector>
+#include "rollingStats.h"
+
+class gpuTimer
+{
+public:
+	gpuTimer();
+	~gpuTimer();
+	static const int HISTORY_LENGTH = 120;
+	void initialize(int latency = 4, int historyLength = HISTORY_LENGTH);
+	void begin();
+	void end();
+	bool hasResult();
+	float getElapsedMs();
+	void summarize(timingSummary& summary);
+	void setName(const char* timerName);
+	int getResultCount();           // results read back so far
+private:
+	void collectResults();
+	std::vector<unsigned int> startQueries;
+	std::vector<unsigned int> endQueries;
+	std::vector<bool> pending;
+	int current = 0;
+	bool resultReady = false;
+	int resultCount = 0;
+	float elapsedMs = 0.f;
+	rollingStats history;
+	const char* name = nullptr;
+};
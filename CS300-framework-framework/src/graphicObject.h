@@ -3,6 +3,18 @@
 #include "object.h"
 #include "models.h"
 #include "globals.h"
+#include "commandList.h"
+
+// std140 mirror of the ObjectConstants uniform block of the G buffer
+// shaders, one range of the frame's ring buffer per object drawn.
+static const unsigned int OBJECT_CONSTANTS_BINDING = 2;
+struct objectConstants
+{
+	glm::mat4 model;
+	glm::mat4 normal;               // inverse transpose of model
+	float shininess;                // 0 to 1
+	float padding[3];
+};
 
 class graphicObject : public object
 {
@@ -18,22 +30,43 @@ public:
 	graphicObject(glm::vec3 pos, glm::vec3 rot, glm::vec3 sca, unsigned int meshType, unsigned int indexCount);
 	~graphicObject();
 	void update(void(*updateFN)());
+	// forward programs, through uniforms; G buffer draws use recordDraw
 	void draw(unsigned int shader);
+	// modelLoc: the shader's ModelMatrix, looked up once per pass
+	void drawDepth(unsigned int shader, int modelLoc);
+	glm::mat4 getModelMtx();
+	void getDrawMatrices(glm::mat4& modelMtx, glm::mat4& normalMtx);
+	// Recomputes the cached draw matrices if the transform changed since.
+	// Touches only this object, so jobs can update objects side by side.
+	void updateDrawMatrices();
+	// Draw order key: material, textures and mesh in the high 40 bits,
+	// the low 24 left for the caller (an index, to keep sorts stable).
+	unsigned long long getSortKey();
+	// Writes this object's constants and records its draw, reading
+	// them at offset in buffer.  Any thread, once the draw matrices
+	// are up to date.
+	void recordDraw(commandList& list, objectConstants& constants, unsigned int buffer, size_t offset);
 	void setColor(glm::vec3 col);
 	void setTextureMap(unsigned int tex);
 	void setSpecularMap(unsigned int spec);
 	void setNormalMap(unsigned int norm);
 	void setMaterialShininess(float shininess);
 	void setObjectType(global::eObjectType type);
+	void setBoundingRadius(float radius);
+	float getWorldBoundingRadius();
 	global::eObjectMaterialType getMaterialType();
 private:
 	unsigned int mesh;
 	int meshIndexCount;
 	float materialShininess = 120.f;
+	float boundingRadius = 1.f;  // model space, around the origin
 	global::eObjectMaterialType material;
 	global::eObjectType objType;
 	int textures[3] = { -1, -1, -1 };
 	glm::vec3 color;
 	global::eObjectType objectType = global::eObjectType::GAMEOBJECT;
+	glm::mat4 drawModelMtx;
+	glm::mat4 drawNormalMtx;
+	unsigned int drawMatricesVersion = ~0u;
 	global::eObjectMaterialType currentMaterial();
 };
\ No newline at end of file
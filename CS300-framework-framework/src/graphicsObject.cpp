@@ -1,8 +1,9 @@
 #include "graphicObject.h"
-#include "GL\glew.h"
-#include "glm\ext.hpp"
-
-#define CHECKERROR {int err = glGetError(); if (err) { fprintf(stderr, "OpenGL error (at line %d): %s\n", __LINE__, gluErrorString(err)); exit(-1);} }
+#include "GL/glew.h"
+#include "glState.h"
+#include "samplerLibrary.h"
+#include "glm/ext.hpp"
+#include <assert.h>
 
 graphicObject::graphicObject()
 {
@@ -30,53 +31,117 @@ void graphicObject::update(void(*updateFN)())
 		updateFN();
 }
 
-void graphicObject::draw(unsigned int shader)
+glm::mat4 graphicObject::getModelMtx()
 {
 	glm::mat4 translateMtx = glm::translate(translate);
 	glm::mat4 rotateMtx = glm::gtc::quaternion::mat4_cast(glm::quat(rotate));
 	glm::mat4 scaleMtx = glm::scale(scale);
 
-	glm::mat4 modelToWorldMtx = translateMtx * rotateMtx * scaleMtx;
+	return translateMtx * rotateMtx * scaleMtx;
+}
+
+// The CPU side of draw, kept apart so the microbenchmark times it.
+void graphicObject::getDrawMatrices(glm::mat4& modelMtx, glm::mat4& normalMtx)
+{
+	modelMtx = getModelMtx();
+	normalMtx = glm::inverse(modelMtx);
+}
+
+void graphicObject::updateDrawMatrices()
+{
+	if (drawMatricesVersion == transformVersion)
+		return;
+	getDrawMatrices(drawModelMtx, drawNormalMtx);
+	drawMatricesVersion = transformVersion;
+}
+
+unsigned long long graphicObject::getSortKey()
+{
+	unsigned long long key = (unsigned long long)(material & 0xf) << 60;
+	key |= (unsigned long long)(textures[eTextureType::DIFFUSE] & 0xfff) << 48;
+	key |= (unsigned long long)(textures[eTextureType::SPECULAR] & 0xfff) << 36;
+	key |= (unsigned long long)(mesh & 0xfff) << 24;
+	return key;
+}
+
+// The texture units match the material samplers the G buffer programs
+// are set up with; a color material leaves whatever is bound.
+void graphicObject::recordDraw(commandList& list, objectConstants& constants, unsigned int buffer, size_t offset)
+{
+	constants.model = drawModelMtx;
+	constants.normal = glm::transpose(drawNormalMtx);
+	constants.shininess = materialShininess / 255.f;
+	list.bindUniformRange(OBJECT_CONSTANTS_BINDING, buffer, offset, sizeof(objectConstants));
+
+	if (material == global::eObjectMaterialType::TEXTURE || material == global::eObjectMaterialType::TEXTURE_SPECULAR)
+	{
+		list.bindTexture2D(0, textures[eTextureType::DIFFUSE]);
+		list.bindSampler(0, samplerLibrary::get(samplerLibrary::MATERIAL));
+	}
+	if (material == global::eObjectMaterialType::TEXTURE_SPECULAR)
+	{
+		list.bindTexture2D(1, textures[eTextureType::SPECULAR]);
+		list.bindSampler(1, samplerLibrary::get(samplerLibrary::MATERIAL));
+	}
+
+	list.bindVertexArray(mesh);
+	list.drawElements(meshIndexCount);
+}
+
+// The forward programs' path: ModelMatrix, NormalMatrix (the inverse
+// model matrix these shaders expect) and the material go in as plain
+// uniforms.  Programs with an ObjectConstants block are drawn through
+// recordDraw instead.
+void graphicObject::draw(unsigned int shader)
+{
+	assert(glGetUniformBlockIndex(shader, "ObjectConstants") == GL_INVALID_INDEX);
+	updateDrawMatrices();
 	int loc = glGetUniformLocation(shader, "ModelMatrix");
-	glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(modelToWorldMtx));
+	glProgramUniformMatrix4fv(shader, loc, 1, GL_FALSE, glm::value_ptr(drawModelMtx));
 
 	loc = glGetUniformLocation(shader, "NormalMatrix");
-	glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(glm::inverse(modelToWorldMtx)));
+	glProgramUniformMatrix4fv(shader, loc, 1, GL_FALSE, glm::value_ptr(drawNormalMtx));
 
 	if (material == global::eObjectMaterialType::COLOR)
 	{
 		int dloc = glGetUniformLocation(shader, "phongDiffuse");
-		glUniform3fv(dloc, 1, glm::value_ptr(color));
+		glProgramUniform3fv(shader, dloc, 1, glm::value_ptr(color));
 	}
 	else if (material == global::eObjectMaterialType::TEXTURE)
 	{
-		glActiveTexture(GL_TEXTURE0);    
-		glBindTexture(GL_TEXTURE_2D, textures[eTextureType::DIFFUSE]);
+		glState::bindTexture(0, GL_TEXTURE_2D, textures[eTextureType::DIFFUSE]);
+		samplerLibrary::bind(0, samplerLibrary::MATERIAL);
 		int loc = glGetUniformLocation(shader, "material.diffuseMap");
-		glUniform1i(loc, 0);
+		glProgramUniform1i(shader, loc, 0);
 	}
 	else if (material == global::eObjectMaterialType::TEXTURE_SPECULAR)
 	{
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, textures[eTextureType::DIFFUSE]);
+		glState::bindTexture(0, GL_TEXTURE_2D, textures[eTextureType::DIFFUSE]);
+		samplerLibrary::bind(0, samplerLibrary::MATERIAL);
 		int loc = glGetUniformLocation(shader, "material.diffuseMap");
-		glUniform1i(loc, 0);
-		CHECKERROR;
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, textures[eTextureType::SPECULAR]);
+		glProgramUniform1i(shader, loc, 0);
+		glState::bindTexture(1, GL_TEXTURE_2D, textures[eTextureType::SPECULAR]);
+		samplerLibrary::bind(1, samplerLibrary::MATERIAL);
 		loc = glGetUniformLocation(shader, "material.specularMap");
-		glUniform1i(loc, 1);
-		CHECKERROR;
+		glProgramUniform1i(shader, loc, 1);
 	}
-	
+
 	loc = glGetUniformLocation(shader, "material.materialShininess");
 	float shiny = materialShininess / 255.f;
-	glUniform1f(loc, shiny);
+	glProgramUniform1f(shader, loc, shiny);
 
-	glBindVertexArray(mesh);
-	glDrawElements(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT, 0);
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(0);
+	glState::bindVertexArray(mesh);
+	glState::drawElements(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT);
+}
+
+// Only what a depth-only pass needs: the transform and the mesh.
+void graphicObject::drawDepth(unsigned int shader, int modelLoc)
+{
+	updateDrawMatrices();
+	glProgramUniformMatrix4fv(shader, modelLoc, 1, GL_FALSE, glm::value_ptr(drawModelMtx));
+
+	glState::bindVertexArray(mesh);
+	glState::drawElements(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT);
 }
 
 void graphicObject::setColor(glm::vec3 col)
@@ -102,6 +167,18 @@ void graphicObject::setNormalMap(unsigned int norm)
 	material = currentMaterial();
 }
 
+void graphicObject::setBoundingRadius(float radius)
+{
+	boundingRadius = radius;
+}
+
+// Bounding sphere radius around the object's position; rotation can
+// not grow it, so only the largest scale axis matters.
+float graphicObject::getWorldBoundingRadius()
+{
+	return boundingRadius * glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+}
+
 global::eObjectMaterialType graphicObject::getMaterialType()
 {
 	return material;
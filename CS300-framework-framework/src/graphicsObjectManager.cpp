@@ -12,7 +12,7 @@ graphicsObjectManager::~graphicsObjectManager()
 
 graphicsObjectManager::graphicsObjectManager(std::vector<graphicObject>& objectContainer)
 {
-	for (auto obj : objectContainer)
+	for (auto& obj : objectContainer)
 	{
 		graphicsObjects.push_back(obj);
 	}
@@ -38,7 +38,7 @@ void graphicsObjectManager::updateGraphicsObjectParam(std::vector<graphicsObject
 
 void graphicsObjectManager::draw(unsigned int shader)
 {
-	for (auto obj : graphicsObjects)
+	for (auto& obj : graphicsObjects)
 	{
 		obj.draw(shader);
 	}
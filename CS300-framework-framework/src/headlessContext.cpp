@@ -0,0 +1,105 @@
+#include "headlessContext.h"
+#include "glDebug.h"
+
+#include "GL/glew.h"
+#ifdef BENCHMARK_OSMESA
+#include <GL/osmesa.h>
+#else
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <vector>
+#include <stdio.h>
+
+#ifdef BENCHMARK_OSMESA
+static std::vector<unsigned char> colorBuffer;
+
+static bool createContext(int width, int height)
+{
+	const int attributes[] = { OSMESA_FORMAT, OSMESA_RGBA,
+							   OSMESA_DEPTH_BITS, 24,
+							   OSMESA_PROFILE, OSMESA_COMPAT_PROFILE,
+							   OSMESA_CONTEXT_MAJOR_VERSION, 4,
+							   OSMESA_CONTEXT_MINOR_VERSION, 5,
+							   0 };
+	OSMesaContext context = OSMesaCreateContextAttribs(attributes, nullptr);
+	if (!context)
+	{
+		fprintf(stderr, "OSMesa: no OpenGL 4.5 compatibility context\n");
+		return false;
+	}
+	colorBuffer.resize((size_t)width * height * 4);
+	return OSMesaMakeCurrent(context, colorBuffer.data(), GL_UNSIGNED_BYTE, width, height) == GL_TRUE;
+}
+#else
+static bool createContext(int width, int height)
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+	{
+		fprintf(stderr, "EGL: no display\n");
+		return false;
+	}
+
+	const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+										EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+										EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+										EGL_DEPTH_SIZE, 24,
+										EGL_NONE };
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		fprintf(stderr, "EGL: no RGBA8/depth 24 pbuffer config\n");
+		return false;
+	}
+
+	// the pbuffer is framebuffer 0, where the upscale and depth copy passes blit to
+	const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+	EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+	eglBindAPI(EGL_OPENGL_API);
+	const EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 4,
+										 EGL_CONTEXT_MINOR_VERSION, 5,
+										 EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+#ifdef GL_DEBUG_LAYER
+										 EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+										 EGL_NONE };
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT)
+	{
+		fprintf(stderr, "EGL: no OpenGL 4.5 compatibility context (0x%x)\n", eglGetError());
+		return false;
+	}
+	return eglMakeCurrent(display, surface, surface, context) == EGL_TRUE;
+}
+#endif
+
+bool createHeadlessContext(int width, int height)
+{
+	if (!createContext(width, height))
+		return false;
+
+	// newer GLEW reports a missing GLX display after loading the entry
+	// points, which is expected under EGL and OSMesa
+	glewExperimental = GL_TRUE;
+	GLenum err = glewInit();
+	if (err != GLEW_OK && !GLEW_VERSION_4_5)
+	{
+		fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
+		return false;
+	}
+	GL_DEBUG_INITIALIZE();
+	return true;
+}
@@ -0,0 +1,12 @@
+///////////////////////////////////////////////////////////////////////
+// OpenGL 4.5 compatibility context without a window, for the command
+// line tools (benchmark, microbenchmark).  Uses EGL with a pbuffer as
+// the default framebuffer, on the surfaceless Mesa platform when it is
+// available; building with BENCHMARK_OSMESA uses OSMesa instead.
+// Also loads the entry points and sets up the debug output, so the
+// caller can go straight to InitializeScene.  Only built by the
+// Makefile.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+bool createHeadlessContext(int width, int height);
@@ -0,0 +1,304 @@
+#include "jobSystem.h"
+#include "frameArena.h"
+#include "profiler.h"
+#include <algorithm>
+#include <stdio.h>
+
+int jobSystem::threadCount = 0;
+jobSystem::threadState* jobSystem::threads = nullptr;
+std::vector<std::thread> jobSystem::workers;
+std::atomic<bool> jobSystem::running(false);
+std::mutex jobSystem::sleepLock;
+std::condition_variable jobSystem::sleepSignal;
+std::atomic<int> jobSystem::sleepers(0);
+thread_local int jobSystem::threadIndex = -1;
+
+// failed searches for a job before a worker goes to sleep
+static const int SPIN_ROUNDS = 64;
+// the profiler keeps the name pointers
+static char workerNames[jobSystem::MAX_THREADS][16];
+
+jobSystem::workDeque::workDeque() : top(0), bottom(0)
+{
+
+}
+
+void jobSystem::workDeque::write(long long index, const job& j)
+{
+	slot& s = slots[index & MASK];
+	s.function.store(j.function, std::memory_order_relaxed);
+	s.data.store(j.data, std::memory_order_relaxed);
+	s.begin.store(j.begin, std::memory_order_relaxed);
+	s.end.store(j.end, std::memory_order_relaxed);
+	s.counter.store(j.counter, std::memory_order_relaxed);
+}
+
+void jobSystem::workDeque::read(long long index, job& j)
+{
+	slot& s = slots[index & MASK];
+	j.function = s.function.load(std::memory_order_relaxed);
+	j.data = s.data.load(std::memory_order_relaxed);
+	j.begin = s.begin.load(std::memory_order_relaxed);
+	j.end = s.end.load(std::memory_order_relaxed);
+	j.counter = s.counter.load(std::memory_order_relaxed);
+}
+
+bool jobSystem::workDeque::push(const job& j)
+{
+	long long b = bottom.load(std::memory_order_relaxed);
+	long long t = top.load(std::memory_order_acquire);
+	if (b - t >= MAX_JOBS)
+		return false;
+	write(b, j);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_relaxed);
+	return true;
+}
+
+bool jobSystem::workDeque::pop(job& j)
+{
+	long long b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	long long t = top.load(std::memory_order_relaxed);
+	if (t > b)
+	{
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return false;
+	}
+	read(b, j);
+	bool claimed = true;
+	if (t == b)
+	{
+		// the last job: the thieves may be after it too
+		claimed = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return claimed;
+}
+
+bool jobSystem::workDeque::steal(job& j)
+{
+	long long t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	long long b = bottom.load(std::memory_order_acquire);
+	if (t >= b)
+		return false;
+	// the slot can only be refilled once top moved past it, and then
+	// the claim fails
+	read(t, j);
+	return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+bool jobSystem::workDeque::isEmpty()
+{
+	return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+}
+
+void jobSystem::initialize(int count)
+{
+	if (threads)
+		shutdown();
+	if (count <= 0)
+		count = (int)std::thread::hardware_concurrency();
+	threadCount = std::min(std::max(count, 1), (int)MAX_THREADS);
+	threads = new threadState[threadCount];
+	for (int i = 0; i < threadCount; ++i)
+		threads[i].random = 2654435761u * (i + 1);
+	threadIndex = 0;
+	running.store(true, std::memory_order_release);
+	for (int i = 1; i < threadCount; ++i)
+		workers.emplace_back(&jobSystem::workerMain, i);
+}
+
+void jobSystem::shutdown()
+{
+	if (!threads)
+		return;
+	running.store(false, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock(sleepLock);
+		sleepSignal.notify_all();
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+	workers.clear();
+	delete[] threads;
+	threads = nullptr;
+	threadCount = 0;
+}
+
+int jobSystem::getThreadCount()
+{
+	return std::max(threadCount, 1);
+}
+
+// Queues the job on the calling thread's deque, or runs it right away
+// when that is not possible.  Does not wake anyone.
+bool jobSystem::submit(jobFunction function, void* data, int begin, int end, jobCounter* counter)
+{
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	job j = { function, data, begin, end, counter };
+	int index = threadIndex;
+	if (threads && index >= 0 && threads[index].deque.push(j))
+		return true;
+	execute(j);
+	return false;
+}
+
+void jobSystem::run(jobFunction function, void* data, int begin, int end, jobCounter* counter)
+{
+	if (submit(function, data, begin, end, counter))
+		wake(1);
+}
+
+void jobSystem::wait(jobCounter& counter)
+{
+	int index = threadIndex;
+	while (counter.pending.load(std::memory_order_acquire) > 0)
+	{
+		job j;
+		if (threads && index >= 0 && findJob(index, j))
+			execute(j);
+		else
+			std::this_thread::yield();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////
+// The caller runs the first chunk itself while the others get stolen.
+void jobSystem::parallelFor(int begin, int end, int grain, jobFunction function, void* data)
+{
+	long long count = end - begin;
+	if (count <= 0)
+		return;
+	int chunks = (int)std::min((count + std::max(grain, 1) - 1) / std::max(grain, 1),
+							   (long long)getThreadCount() * SPLIT_PER_THREAD);
+	if (chunks <= 1 || !threads || threadIndex < 0)
+	{
+		function(data, begin, end);
+		return;
+	}
+
+	jobCounter counter;
+	int queued = 0;
+	for (int i = 1; i < chunks; ++i)
+	{
+		if (submit(function, data, begin + (int)(count * i / chunks), begin + (int)(count * (i + 1) / chunks), &counter))
+			++queued;
+	}
+	wake(queued);
+	function(data, begin, begin + (int)(count / chunks));
+	wait(counter);
+}
+
+void jobSystem::endFrame(jobSystemParam& param)
+{
+	param.threads = getThreadCount();
+	param.jobsRun = 0;
+	param.jobsStolen = 0;
+	for (int i = 0; i < threadCount; ++i)
+	{
+		param.jobsRun += threads[i].jobsRun.exchange(0, std::memory_order_relaxed);
+		param.jobsStolen += threads[i].jobsStolen.exchange(0, std::memory_order_relaxed);
+	}
+}
+
+void jobSystem::workerMain(int index)
+{
+	threadIndex = index;
+	snprintf(workerNames[index], sizeof(workerNames[index]), "Worker %d", index);
+	PROFILE_THREAD_NAME(workerNames[index]);
+	frameArena::watchThread();
+	int idleRounds = 0;
+	while (running.load(std::memory_order_acquire))
+	{
+		job j;
+		if (findJob(index, j))
+		{
+			execute(j);
+			idleRounds = 0;
+			continue;
+		}
+		if (++idleRounds < SPIN_ROUNDS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// announce the sleep before the last look, see wake
+		std::unique_lock<std::mutex> lock(sleepLock);
+		sleepers.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (running.load(std::memory_order_acquire) && !hasWork())
+			sleepSignal.wait(lock);
+		sleepers.fetch_sub(1);
+		idleRounds = 0;
+	}
+}
+
+// Own deque first, then every other thread's, from a random one on.
+bool jobSystem::findJob(int index, job& j)
+{
+	threadState& self = threads[index];
+	if (self.deque.pop(j))
+		return true;
+
+	self.random ^= self.random << 13;
+	self.random ^= self.random >> 17;
+	self.random ^= self.random << 5;
+	int start = (int)(self.random % threadCount);
+	for (int i = 0; i < threadCount; ++i)
+	{
+		int victim = (start + i) % threadCount;
+		if (victim == index)
+			continue;
+		if (threads[victim].deque.steal(j))
+		{
+			self.jobsStolen.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void jobSystem::execute(const job& j)
+{
+	{
+		PROFILE_ZONE("jobSystem::job");
+		j.function(j.data, j.begin, j.end);
+	}
+	if (j.counter)
+		j.counter->pending.fetch_sub(1, std::memory_order_release);
+	if (threads && threadIndex >= 0)
+		threads[threadIndex].jobsRun.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool jobSystem::hasWork()
+{
+	for (int i = 0; i < threadCount; ++i)
+	{
+		if (!threads[i].deque.isEmpty())
+			return true;
+	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////
+// The fence pairs with the one after a worker counts itself as a
+// sleeper: either the worker sees the pushed job, or this sees the
+// sleeper and notifies it under the lock it holds until it waits.
+void jobSystem::wake(int count)
+{
+	if (count <= 0)
+		return;
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleepers.load(std::memory_order_relaxed) == 0)
+		return;
+	std::lock_guard<std::mutex> lock(sleepLock);
+	if (count == 1)
+		sleepSignal.notify_one();
+	else
+		sleepSignal.notify_all();
+}
@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////
+// Work-stealing job system.  initialize starts one worker thread per
+// hardware thread beside the main thread (or as many as asked for).
+// Every thread owns a Chase-Lev deque: it pushes and pops jobs at the
+// bottom, without a lock, while idle threads steal from the top with
+// a single compare-and-swap.
+//
+// A job is a function over an index range [begin, end) with a data
+// pointer, and may decrement a jobCounter when it is done.  wait
+// returns once a counter reaches zero.  Meanwhile the waiting thread
+// runs jobs itself, its own first, then stolen ones, so waiting never
+// idles a core and jobs may spawn and wait on more jobs.  parallelFor
+// splits a range into up to SPLIT_PER_THREAD chunks per thread of at
+// least grain items and waits for them.
+//
+// Jobs are stored in the deque slots themselves, so submitting does
+// not allocate.  A thief copies a job out before it claims it, and
+// keeps the copy only if the claim succeeds.  A thread may queue up
+// to MAX_JOBS jobs; a full deque runs the job right away instead.
+// Only the main thread and jobs may submit.  Other threads, like the
+// simulation thread, run their jobs inline.
+//
+// Idle workers spin for a short while, then sleep until jobs are
+// pushed.  The lock behind that sleep is only taken when a worker
+// sleeps or something wakes one.  Jobs run and stolen are counted per
+// thread, and endFrame collects the counts.  Every job runs inside a
+// "jobSystem::job" profiler zone, so workers have a track in a trace.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef void (*jobFunction)(void* data, int begin, int end);
+
+struct jobCounter
+{
+	std::atomic<int> pending;
+	jobCounter() : pending(0)
+	{
+
+	}
+};
+
+struct jobSystemParam
+{
+	int threads = 1;                // main thread included
+	int jobsRun = 0;                // last frame
+	int jobsStolen = 0;
+};
+
+class jobSystem
+{
+public:
+	static const int MAX_THREADS = 64;
+	static const int MAX_JOBS = 4096;
+	static const int SPLIT_PER_THREAD = 4;
+
+	// 0 threads: one per hardware thread.  Call from the main thread.
+	static void initialize(int threads = 0);
+	static void shutdown();
+	static int getThreadCount();
+	// Adds one to counter, if any, and takes it off when the job ran.
+	static void run(jobFunction function, void* data, int begin, int end, jobCounter* counter);
+	static void wait(jobCounter& counter);
+	static void parallelFor(int begin, int end, int grain, jobFunction function, void* data);
+	// f(begin, end) over chunks of [begin, end)
+	template <class F>
+	static void parallelFor(int begin, int end, int grain, const F& f)
+	{
+		parallelFor(begin, end, grain, &invoke<F>, (void*)&f);
+	}
+	static void endFrame(jobSystemParam& param);
+private:
+	struct job
+	{
+		jobFunction function;
+		void* data;
+		int begin, end;
+		jobCounter* counter;
+	};
+
+	// Chase-Lev, fixed capacity (Le, Pop, Cohen, Zappa Nardelli, 2013)
+	class workDeque
+	{
+	public:
+		workDeque();
+		bool push(const job& j);    // owner
+		bool pop(job& j);           // owner
+		bool steal(job& j);         // anyone
+		bool isEmpty();
+	private:
+		// a thief may read a slot while the owner refills it, then fails
+		// to claim it; the fields are atomics so that race is defined
+		struct slot
+		{
+			std::atomic<jobFunction> function;
+			std::atomic<void*> data;
+			std::atomic<int> begin;
+			std::atomic<int> end;
+			std::atomic<jobCounter*> counter;
+		};
+		void write(long long index, const job& j);
+		void read(long long index, job& j);
+		static const long long MASK = MAX_JOBS - 1;
+		std::atomic<long long> top;
+		char padding[64];           // thieves hammer top, the owner bottom
+		std::atomic<long long> bottom;
+		slot slots[MAX_JOBS];
+	};
+
+	struct threadState
+	{
+		workDeque deque;
+		unsigned int random = 0;
+		std::atomic<int> jobsRun;
+		std::atomic<int> jobsStolen;
+		threadState() : jobsRun(0), jobsStolen(0)
+		{
+
+		}
+	};
+
+	template <class F>
+	static void invoke(void* data, int begin, int end)
+	{
+		(*(const F*)data)(begin, end);
+	}
+
+	static bool submit(jobFunction function, void* data, int begin, int end, jobCounter* counter);
+	static void workerMain(int index);
+	static bool findJob(int index, job& j);
+	static void execute(const job& j);
+	static bool hasWork();
+	static void wake(int count);
+
+	static int threadCount;
+	static threadState* threads;
+	static std::vector<std::thread> workers;
+	static std::atomic<bool> running;
+	static std::mutex sleepLock;
+	static std::condition_variable sleepSignal;
+	static std::atomic<int> sleepers;
+	static thread_local int threadIndex;
+
+	jobSystem();
+	~jobSystem();
+};
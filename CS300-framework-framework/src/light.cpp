@@ -19,3 +19,8 @@ void light::setLightIndex(int index)
 {
 	lightIndex = index;
 }
+
+int light::getLightIndex()
+{
+	return lightIndex;
+}
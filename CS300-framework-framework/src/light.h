@@ -10,6 +10,7 @@ public:
 	virtual void updateLightParameter(unsigned int shader) = 0;
 	void setLightColor(glm::vec3 &col);
 	void setLightIndex(int index);
+	int getLightIndex();
 protected:
 	glm::vec3 lightColor;
 	int lightIndex = 0;
@@ -7,12 +7,12 @@ lightManager::lightManager()
 
 lightManager::lightManager(std::vector<pointLight>& ptLights, std::vector<directionalLight>& dirLights)
 {
-	for (auto ptLight : ptLights)
+	for (auto& ptLight : ptLights)
 	{
 		pointLightContainer.push_back(ptLight);
 	}
 
-	for (auto dirLight : dirLights)
+	for (auto& dirLight : dirLights)
 	{
 		directionalLightContainer.push_back(dirLight);
 	}
@@ -47,22 +47,93 @@ void lightManager::updateLightParameters(pointLightParamContainter& ptLightParam
 	}
 }
 
+////////////////////////////////////////////////////////////////////////
+// True when updateLightParameters would leave every light as it is.
+bool lightManager::matchesParameters(pointLightParamContainter& ptLightParams, directionLightParamContainter& directionalLightParameters)
+{
+	if (ptLightParams.size() < pointLightContainer.size() ||
+		directionalLightParameters.size() < directionalLightContainer.size())
+		return false;
+
+	for (unsigned int i = 0; i < pointLightContainer.size(); ++i)
+	{
+		pointLight& light = pointLightContainer[i];
+		const pointLightParam& param = ptLightParams[i];
+		float dist, constant, linear, quad;
+		light.getAttenuationParameters(dist, constant, linear, quad);
+		if (light.getTranslation() != param.pointLightPosition ||
+			light.getDiffuseColor() != param.pointLightDiffuse ||
+			light.getSpecularColor() != param.pointLightSpecular ||
+			dist != param.pointLightAttenuationDistance || constant != param.pointLightAttenuationConstanst ||
+			linear != param.pointLightAttenuationLinear || quad != param.pointLightAttenuationQuadratic)
+			return false;
+	}
+
+	for (unsigned int i = 0; i < directionalLightContainer.size(); ++i)
+	{
+		directionalLight& light = directionalLightContainer[i];
+		const directionalLightParam& param = directionalLightParameters[i];
+		if (light.getLightDirection() != param.directionLightDir ||
+			light.getDiffuseColor() != param.directionLightDiffuse ||
+			light.getSpecularColor() != param.directionLightSpecular)
+			return false;
+	}
+	return true;
+}
+
 void lightManager::passDataToShader(unsigned int shader)
 {
-	for (auto ptLight : pointLightContainer)
+	for (auto& ptLight : pointLightContainer)
 	{
 		ptLight.updateLightParameter(shader);
 	}
 
-	for (auto dirLight : directionalLightContainer)
+	for (auto& dirLight : directionalLightContainer)
 	{
 		dirLight.updateLightParameter(shader);
 	}
 }
 
+////////////////////////////////////////////////////////////////////////
+// Writes every slot of the block, in order, since it usually lives in
+// write-combined mapped memory; slots without a light are zeroed.
+void lightManager::writeLightBlock(lightBlockData& block, ambientLight& ambient)
+{
+	for (int i = 0; i < MAX_SHADER_LIGHTS; ++i)
+		block.directionLight[i] = directionalLightBlock();
+	for (auto& dirLight : directionalLightContainer)
+	{
+		int index = dirLight.getLightIndex();
+		if (index < 0 || index >= MAX_SHADER_LIGHTS)
+			continue;
+		directionalLightBlock& slot = block.directionLight[index];
+		slot.diffuse = glm::vec4(dirLight.getDiffuseColor(), 0.f);
+		slot.specular = glm::vec4(dirLight.getSpecularColor(), 0.f);
+		slot.direction = glm::vec4(dirLight.getLightDirection(), 0.f);
+	}
+
+	for (int i = 0; i < MAX_SHADER_LIGHTS; ++i)
+		block.pointLight[i] = pointLightBlock();
+	for (auto& ptLight : pointLightContainer)
+	{
+		int index = ptLight.getLightIndex();
+		if (index < 0 || index >= MAX_SHADER_LIGHTS)
+			continue;
+		float dist, constant, linear, quad;
+		ptLight.getAttenuationParameters(dist, constant, linear, quad);
+		pointLightBlock& slot = block.pointLight[index];
+		slot.diffuseDistance = glm::vec4(ptLight.getDiffuseColor(), dist);
+		slot.specularConstant = glm::vec4(ptLight.getSpecularColor(), constant);
+		slot.positionLinear = glm::vec4(ptLight.getTranslation(), linear);
+		slot.quadratic = glm::vec4(quad, 0.f, 0.f, 0.f);
+	}
+
+	block.ambient = glm::vec4(ambient.getAmbientColor(), ambient.getAmbientStrength());
+}
+
 void lightManager::draw(unsigned int shader)
 {
-	for (auto ptLight : pointLightContainer)
+	for (auto& ptLight : pointLightContainer)
 	{
 		ptLight.draw(shader);
 	}
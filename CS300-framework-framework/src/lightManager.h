@@ -3,6 +3,7 @@
 #include <vector>
 #include "pointLight.h"
 #include "directionalLight.h"
+#include "ambientLight.h"
 
 struct ambientLightParam
 {
@@ -28,6 +29,33 @@ struct pointLightParam
 	float pointLightAttenuationQuadratic;
 };
 
+// std140 layout of the lightBlock uniform block read by the deferred
+// lighting shaders; a float that follows a vec3 rides in its w.
+static const int MAX_SHADER_LIGHTS = 32;
+static const unsigned int LIGHT_BLOCK_BINDING = 1;
+
+struct directionalLightBlock
+{
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+	glm::vec4 direction;
+};
+
+struct pointLightBlock
+{
+	glm::vec4 diffuseDistance;
+	glm::vec4 specularConstant;
+	glm::vec4 positionLinear;
+	glm::vec4 quadratic;
+};
+
+struct lightBlockData
+{
+	directionalLightBlock directionLight[MAX_SHADER_LIGHTS];
+	pointLightBlock pointLight[MAX_SHADER_LIGHTS];
+	glm::vec4 ambient;              // color, strength
+};
+
 typedef std::vector<pointLightParam> pointLightParamContainter;
 typedef std::vector<directionalLightParam> directionLightParamContainter;
 
@@ -38,7 +66,9 @@ public:
 	lightManager(std::vector<pointLight>& ptLights, std::vector<directionalLight>& dirLights);
 	~lightManager();
 	void updateLightParameters(pointLightParamContainter& ptLightParams, directionLightParamContainter& directionalLightParameters);
+	bool matchesParameters(pointLightParamContainter& ptLightParams, directionLightParamContainter& directionalLightParameters);
 	void passDataToShader(unsigned int shader);
+	void writeLightBlock(lightBlockData& block, ambientLight& ambient);
 	void draw(unsigned int shader);
 	std::vector<directionalLight>& getDirectionalLights();
 	std::vector<pointLight>& getPointLights();
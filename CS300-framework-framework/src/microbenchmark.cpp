@@ -0,0 +1,622 @@
+///////////////////////////////////////////////////////////////////////
+// Microbenchmarks of the CPU side kernels: model loading, VAO and
+// procedural mesh creation, the per-object matrices of draw, the light
+// parameter update and the camera update, each over a range of input
+// sizes.  Results go to stdout as a table and to a JSON file, in ns
+// per operation and items per second.
+//
+// Every case is warmed up for a while first, then the number of
+// operations per sample is chosen so a sample takes at least
+// --min-time-ms, which keeps the clock's resolution out of the
+// results.  --reps samples are taken and summarized with the same
+// statistics as the frame benchmark.
+//
+// The model loading inputs are the bundled assets plus square grids
+// generated in the same JSON layout (and deleted afterwards).  The
+// loader's console output is switched off while it is timed.  The GL
+// kernels (createVAO, CreateSphere, CreateTeapot) include the driver's
+// copy of the data, and every created VAO is deleted again inside the
+// timed operation so memory stays flat.  Without a context only the
+// CPU only kernels run.  Only built by the Makefile
+// (make microbenchmark).
+//
+// The jobSystem kernels are the frame's parallel loops (transforms,
+// point light caster assignment, sort keys) and the parallel model
+// loading, run once per --workers thread count.  The job system is
+// restarted with that many threads for them, and a speedup over the
+// single thread run of the same input is reported (make jobscaling).
+// More workers than cores only measures the oversubscription.
+//
+//   microbenchmark [--filter SUBSTRING] [--reps N] [--min-time-ms MS]
+//                  [--warmup-ms MS] [--workers 1,2,4,...]
+//                  [--out microbenchmark.json]
+////////////////////////////////////////////////////////////////////////
+
+#include "camera.h"
+#include "graphicObject.h"
+#include "lightManager.h"
+#include "models.h"
+#include "headlessContext.h"
+#include "jobSystem.h"
+#include "benchmarkReport.h"
+
+#include "GL/glew.h"
+#include "writer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct microbenchmarkOptions
+{
+	const char* filter = nullptr;   // only kernels whose name contains it
+	int reps = 20;
+	double minSampleMs = 10.0;
+	double warmupMs = 100.0;
+	const char* out = "microbenchmark.json";
+	std::vector<int> workers = { 1, 2, 4, 8, 16, 32, 64 };
+};
+
+// One kernel at one input size.  run is a single operation over
+// items things (vertices, objects, lights, ...).
+struct microbenchmarkCase
+{
+	std::string kernel;
+	std::string input;
+	long long items;
+	const char* unit;
+	std::function<void()> run;
+	int workers;                    // job system threads, 0 for serial kernels
+};
+
+struct microbenchmarkResult
+{
+	std::string kernel;
+	std::string input;
+	long long items;
+	const char* unit;
+	long long opsPerSample;
+	sampleSummary nsPerOp;
+	int workers;
+	double speedup;                 // over one worker, jobSystem kernels only
+};
+
+// Results are folded in here so the compiler cannot drop the work.
+static volatile float sink;
+
+static bool parseOptions(int argc, char** argv, microbenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--filter") && hasValue)
+			options.filter = argv[++i];
+		else if (!strcmp(argv[i], "--reps") && hasValue)
+			options.reps = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--min-time-ms") && hasValue)
+			options.minSampleMs = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--warmup-ms") && hasValue)
+			options.warmupMs = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--out") && hasValue)
+			options.out = argv[++i];
+		else if (!strcmp(argv[i], "--workers") && hasValue)
+		{
+			options.workers.clear();
+			for (char* list = argv[++i]; *list; )
+			{
+				char* next;
+				long count = strtol(list, &next, 10);
+				if (next == list || count < 1 || count > jobSystem::MAX_THREADS)
+				{
+					fprintf(stderr, "Worker counts must be 1 to %d\n", jobSystem::MAX_THREADS);
+					return false;
+				}
+				options.workers.push_back((int)count);
+				list = *next == ',' ? next + 1 : next;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete option %s\n", argv[i]);
+			return false;
+		}
+	}
+	if (options.reps < 1 || options.minSampleMs < 0.0 || options.warmupMs < 0.0 || options.workers.empty())
+	{
+		fprintf(stderr, "Reps must be positive, times not negative\n");
+		return false;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Inputs
+
+// side x side vertices on the unit square, two triangles per cell
+static meshData makeGridMesh(int side)
+{
+	meshData mesh;
+	mesh.meshName = "grid" + std::to_string(side);
+	for (int y = 0; y < side; ++y)
+	{
+		for (int x = 0; x < side; ++x)
+		{
+			glm::vec3 uv(x / (side - 1.f), y / (side - 1.f), 0.f);
+			mesh.verts.push_back(glm::vec3(uv.x - 0.5f, 0.f, uv.y - 0.5f));
+			mesh.normals.push_back(glm::vec3(0.f, 1.f, 0.f));
+			mesh.uvs.push_back(uv);
+			mesh.tans.push_back(glm::vec3(1.f, 0.f, 0.f));
+			mesh.biTans.push_back(glm::vec3(0.f, 0.f, 1.f));
+		}
+	}
+	for (int y = 0; y + 1 < side; ++y)
+	{
+		for (int x = 0; x + 1 < side; ++x)
+		{
+			unsigned int i = y * side + x;
+			unsigned int quad[6] = { i, i + side, i + 1, i + 1, i + side, i + side + 1 };
+			mesh.faces.insert(mesh.faces.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+static void writeVectors(rapidjson::Writer<rapidjson::StringBuffer>& writer, const char* key, const std::vector<glm::vec3>& values)
+{
+	writer.Key(key);
+	writer.StartArray();
+	for (const glm::vec3& value : values)
+	{
+		writer.StartArray();
+		writer.Double(value.x);
+		writer.Double(value.y);
+		writer.Double(value.z);
+		writer.EndArray();
+	}
+	writer.EndArray();
+}
+
+// In the layout loadModelFromFile reads.
+static bool writeModelFile(const char* path, const meshData& mesh)
+{
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("ModelFile"); writer.String(path);
+	writer.Key("MeshName");  writer.String(mesh.meshName.c_str());
+	writeVectors(writer, "Vertices", mesh.verts);
+	writer.Key("Indices");
+	writer.StartArray();
+	for (unsigned int index : mesh.faces)
+		writer.Uint(index);
+	writer.EndArray();
+	writeVectors(writer, "Normals", mesh.normals);
+	writeVectors(writer, "TexCoords", mesh.uvs);
+	writeVectors(writer, "Tangents", mesh.tans);
+	writeVectors(writer, "BiTangents", mesh.biTans);
+	writer.EndObject();
+	return writeJsonFile(path, buffer);
+}
+
+static float nextFloat(std::mt19937& random, float low, float high)
+{
+	return low + (high - low) * ((random() >> 8) * (1.f / 16777216.f));
+}
+
+////////////////////////////////////////////////////////////////////////
+// Cases
+
+// Fills modelPaths with the inputs that loaded.
+static void addModelLoadCases(std::vector<microbenchmarkCase>& cases, std::vector<std::string>& generatedFiles,
+							  std::vector<std::string>& modelPaths)
+{
+	const char* assets[] = { "assets/model/cube.json", "assets/model/sphere.json", "assets/model/ground.json" };
+	std::vector<std::string> paths(assets, assets + 3);
+	for (int side : { 16, 64, 256 })
+	{
+		std::string path = "microbenchmark_grid" + std::to_string(side) + ".json";
+		if (writeModelFile(path.c_str(), makeGridMesh(side)))
+		{
+			generatedFiles.push_back(path);
+			paths.push_back(path);
+		}
+	}
+
+	for (const std::string& path : paths)
+	{
+		meshData probe;
+		std::streambuf* console = std::cout.rdbuf(nullptr);
+		bool loaded = loadModelFromFile(path.c_str(), probe);
+		std::cout.rdbuf(console);
+		std::cout.clear();
+		if (!loaded)
+			continue;
+		modelPaths.push_back(path);
+		cases.push_back({ "loadModelFromFile", path, (long long)probe.verts.size(), "vertices",
+						  [path]() {
+							  meshData mesh;
+							  loadModelFromFile(path.c_str(), mesh);
+							  sink = sink + (float)mesh.faces.size();
+						  } });
+	}
+}
+
+static void addMeshCreationCases(std::vector<microbenchmarkCase>& cases)
+{
+	for (int side : { 16, 64, 256 })
+	{
+		std::shared_ptr<meshData> mesh = std::make_shared<meshData>(makeGridMesh(side));
+		cases.push_back({ "createVAO", std::to_string(side) + "x" + std::to_string(side) + " grid",
+						  (long long)mesh->verts.size(), "vertices",
+						  [mesh]() { deleteVAO(createVAO(*mesh)); } });
+	}
+
+	for (int n : { 8, 16, 32, 64 })
+	{
+		unsigned int count;
+		deleteVAO(CreateSphere(n, count));
+		cases.push_back({ "CreateSphere", "n=" + std::to_string(n), (long long)count / 3, "triangles",
+						  [n]() { unsigned int count; deleteVAO(CreateSphere(n, count)); } });
+	}
+
+	for (int n : { 4, 8, 12, 16 })
+	{
+		unsigned int count;
+		deleteVAO(CreateTeapot(n, count));
+		cases.push_back({ "CreateTeapot", "n=" + std::to_string(n), (long long)count / 3, "triangles",
+						  [n]() { unsigned int count; deleteVAO(CreateTeapot(n, count)); } });
+	}
+}
+
+// Objects scattered like the stress scene's, so the rotations differ.
+static void addMatrixCases(std::vector<microbenchmarkCase>& cases)
+{
+	for (int count : { 1000, 10000, 100000 })
+	{
+		std::shared_ptr<std::vector<graphicObject>> objects = std::make_shared<std::vector<graphicObject>>();
+		std::mt19937 random(1);
+		objects->reserve(count);
+		for (int i = 0; i < count; ++i)
+		{
+			glm::vec3 position(nextFloat(random, -500.f, 500.f), nextFloat(random, 0.f, 10.f), nextFloat(random, -500.f, 500.f));
+			glm::vec3 rotation(0.f, nextFloat(random, 0.f, 6.2831853f), 0.f);
+			objects->push_back(graphicObject(position, rotation, glm::vec3(nextFloat(random, 0.5f, 4.f)), 0, 0));
+		}
+		cases.push_back({ "graphicObject::getDrawMatrices", std::to_string(count) + " objects", (long long)count, "objects",
+						  [objects]() {
+							  glm::mat4 model, normal;
+							  float sum = 0.f;
+							  for (graphicObject& object : *objects)
+							  {
+								  object.getDrawMatrices(model, normal);
+								  sum += model[3][0] + normal[3][0];
+							  }
+							  sink = sink + sum;
+						  } });
+	}
+}
+
+struct lightCaseData
+{
+	lightManager manager;
+	pointLightParamContainter pointParameters;
+	directionLightParamContainter directionalParameters;
+};
+
+static void addLightCases(std::vector<microbenchmarkCase>& cases)
+{
+	for (int count : { 8, 32, 1000, 10000 })
+	{
+		std::shared_ptr<lightCaseData> data = std::make_shared<lightCaseData>();
+		std::mt19937 random(1);
+		std::vector<pointLight> pointLights;
+		std::vector<directionalLight> directionalLights;
+		for (int i = 0; i < count; ++i)
+		{
+			pointLightParam param;
+			param.pointLightPosition = glm::vec3(nextFloat(random, -500.f, 500.f), 20.f, nextFloat(random, -500.f, 500.f));
+			param.pointLightDiffuse = glm::vec3(nextFloat(random, 0.f, 1.f));
+			param.pointLightSpecular = param.pointLightDiffuse;
+			param.pointLightAttenuationDistance = 160.f;
+			param.pointLightAttenuationConstanst = 1.f;
+			param.pointLightAttenuationLinear = 0.027f;
+			param.pointLightAttenuationQuadratic = 0.0028f;
+			data->pointParameters.push_back(param);
+			pointLights.push_back(pointLight(param.pointLightPosition, 0, 0, param.pointLightDiffuse, param.pointLightSpecular));
+		}
+		directionalLightParam sun;
+		sun.directionLightDir = glm::vec3(-0.3f, -1.f, -0.2f);
+		sun.directionLightDiffuse = glm::vec3(1.f);
+		sun.directionLightSpecular = glm::vec3(1.f);
+		data->directionalParameters.push_back(sun);
+		directionalLights.push_back(directionalLight(sun.directionLightDir, sun.directionLightDiffuse, sun.directionLightSpecular));
+		data->manager = lightManager(pointLights, directionalLights);
+
+		cases.push_back({ "lightManager::updateLightParameters", std::to_string(count) + " point lights", (long long)count, "lights",
+						  [data]() {
+							  data->manager.updateLightParameters(data->pointParameters, data->directionalParameters);
+							  sink = sink + data->manager.getPointLights().back().getTranslation().x;
+						  } });
+	}
+}
+
+static void addCameraCases(std::vector<microbenchmarkCase>& cases)
+{
+	for (int count : { 1, 64, 4096 })
+	{
+		std::shared_ptr<std::vector<camera>> cameras = std::make_shared<std::vector<camera>>(count);
+		std::mt19937 random(1);
+		for (camera& c : *cameras)
+			c.initialize(glm::vec3(nextFloat(random, -100.f, 100.f), 50.f, nextFloat(random, -100.f, 100.f)), glm::vec3(0.f));
+		cases.push_back({ "camera::update", std::to_string(count) + " cameras", (long long)count, "cameras",
+						  [cameras]() {
+							  float sum = 0.f;
+							  for (camera& c : *cameras)
+							  {
+								  c.update();
+								  sum += c.getViewMtx()[3][2];
+							  }
+							  sink = sink + sum;
+						  } });
+	}
+}
+
+struct jobScalingData
+{
+	std::vector<graphicObject> objects;
+	std::vector<glm::mat4> modelMatrices;
+	std::vector<glm::mat4> normalMatrices;
+	std::vector<unsigned long long> sortKeys;
+	std::vector<glm::vec3> lights;
+	std::vector<std::vector<int>> lightCasters;
+	std::vector<std::string> modelPaths;
+	std::vector<meshData> meshes;
+};
+
+// Every kernel writes its own slots only, like the frame's loops.
+static void addJobScalingCases(std::vector<microbenchmarkCase>& cases, const std::vector<int>& workers,
+							   const std::vector<std::string>& modelPaths)
+{
+	const int objectCount = 100000, lightCount = 256, lightObjectCount = 10000;
+	std::shared_ptr<jobScalingData> data = std::make_shared<jobScalingData>();
+	std::mt19937 random(1);
+	data->objects.reserve(objectCount);
+	for (int i = 0; i < objectCount; ++i)
+	{
+		glm::vec3 position(nextFloat(random, -500.f, 500.f), nextFloat(random, 0.f, 10.f), nextFloat(random, -500.f, 500.f));
+		glm::vec3 rotation(0.f, nextFloat(random, 0.f, 6.2831853f), 0.f);
+		graphicObject object(position, rotation, glm::vec3(nextFloat(random, 0.5f, 4.f)), i % 7, 0);
+		object.setTextureMap(i % 13);
+		object.setIsShadowCaster(true);
+		data->objects.push_back(object);
+	}
+	data->modelMatrices.resize(objectCount);
+	data->normalMatrices.resize(objectCount);
+	data->sortKeys.resize(objectCount);
+	for (int i = 0; i < lightCount; ++i)
+		data->lights.push_back(glm::vec3(nextFloat(random, -500.f, 500.f), 20.f, nextFloat(random, -500.f, 500.f)));
+	data->lightCasters.resize(lightCount);
+	data->modelPaths = modelPaths;
+	data->meshes.resize(modelPaths.size());
+
+	for (int count : workers)
+	{
+		cases.push_back({ "jobSystem getDrawMatrices", std::to_string(objectCount) + " objects", (long long)objectCount, "objects",
+						  [data]() {
+							  jobSystem::parallelFor(0, (int)data->objects.size(), 256, [&](int begin, int end)
+							  {
+								  for (int i = begin; i < end; ++i)
+									  data->objects[i].getDrawMatrices(data->modelMatrices[i], data->normalMatrices[i]);
+							  });
+							  sink = sink + data->modelMatrices.back()[3][0];
+						  }, count });
+
+		// what pointShadowAtlas gathers per tile: the casters in range
+		cases.push_back({ "jobSystem light casters", std::to_string(lightCount) + " lights x " + std::to_string(lightObjectCount) + " objects",
+						  (long long)lightCount * lightObjectCount, "pairs",
+						  [data, lightObjectCount]() {
+							  jobSystem::parallelFor(0, (int)data->lights.size(), 1, [&](int begin, int end)
+							  {
+								  for (int i = begin; i < end; ++i)
+								  {
+									  std::vector<int>& casters = data->lightCasters[i];
+									  casters.clear();
+									  for (int j = 0; j < lightObjectCount; ++j)
+									  {
+										  graphicObject& object = data->objects[j];
+										  float reach = 160.f + object.getWorldBoundingRadius();
+										  glm::vec3 offset = object.getTranslation() - data->lights[i];
+										  if (object.getIsShadowCaster() && glm::dot(offset, offset) <= reach * reach)
+											  casters.push_back(j);
+									  }
+								  }
+							  });
+							  sink = sink + (float)data->lightCasters.back().size();
+						  }, count });
+
+		cases.push_back({ "jobSystem sort keys", std::to_string(objectCount) + " objects", (long long)objectCount, "objects",
+						  [data]() {
+							  jobSystem::parallelFor(0, (int)data->objects.size(), 256, [&](int begin, int end)
+							  {
+								  for (int i = begin; i < end; ++i)
+									  data->sortKeys[i] = data->objects[i].getSortKey() | (unsigned long long)i;
+							  });
+							  sink = sink + (float)(data->sortKeys.back() >> 48);
+						  }, count });
+
+		if (!modelPaths.empty())
+		{
+			cases.push_back({ "jobSystem loadModelFromFile", std::to_string(modelPaths.size()) + " files",
+							  (long long)modelPaths.size(), "files",
+							  [data]() {
+								  jobSystem::parallelFor(0, (int)data->modelPaths.size(), 1, [&](int begin, int end)
+								  {
+									  for (int i = begin; i < end; ++i)
+									  {
+										  data->meshes[i] = meshData();
+										  loadModelFromFile(data->modelPaths[i].c_str(), data->meshes[i]);
+									  }
+								  });
+								  sink = sink + (float)data->meshes.back().faces.size();
+							  }, count });
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////
+// Measurement
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static microbenchmarkResult measure(const microbenchmarkCase& benchmarkCase, const microbenchmarkOptions& options)
+{
+	// warm up caches, the allocator and the driver, and time one
+	// operation on the way for the batch size
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	long long warmupOps = 0;
+	do
+	{
+		benchmarkCase.run();
+		++warmupOps;
+	} while (millisecondsSince(start) < options.warmupMs);
+	double opMs = millisecondsSince(start) / warmupOps;
+
+	microbenchmarkResult result;
+	result.kernel = benchmarkCase.kernel;
+	result.input = benchmarkCase.input;
+	result.items = benchmarkCase.items;
+	result.unit = benchmarkCase.unit;
+	result.opsPerSample = opMs > 0.0 ? std::max(1LL, (long long)ceil(options.minSampleMs / opMs)) : 1LL;
+	result.workers = benchmarkCase.workers;
+	result.speedup = 0.0;
+
+	std::vector<double> nsPerOp;
+	for (int rep = 0; rep < options.reps; ++rep)
+	{
+		start = std::chrono::steady_clock::now();
+		for (long long op = 0; op < result.opsPerSample; ++op)
+			benchmarkCase.run();
+		nsPerOp.push_back(millisecondsSince(start) * 1.0e6 / result.opsPerSample);
+	}
+	result.nsPerOp = summarizeSamples(nsPerOp);
+	return result;
+}
+
+static double itemsPerSecond(const microbenchmarkResult& result)
+{
+	return result.nsPerOp.p50 > 0.0 ? result.items * 1.0e9 / result.nsPerOp.p50 : 0.0;
+}
+
+static bool writeReport(const microbenchmarkOptions& options, bool hasContext, const std::vector<microbenchmarkResult>& results)
+{
+	rapidjson::StringBuffer buffer;
+	jsonWriter writer(buffer);
+	writer.StartObject();
+	writer.Key("renderer"); writer.String(hasContext ? (const char*)glGetString(GL_RENDERER) : "none");
+	writer.Key("reps");        writer.Int(options.reps);
+	writer.Key("minSampleMs"); writer.Double(options.minSampleMs);
+	writer.Key("warmupMs");    writer.Double(options.warmupMs);
+	writer.Key("results");
+	writer.StartArray();
+	for (const microbenchmarkResult& result : results)
+	{
+		writer.StartObject();
+		writer.Key("kernel");       writer.String(result.kernel.c_str());
+		writer.Key("input");        writer.String(result.input.c_str());
+		writer.Key("items");        writer.Int64(result.items);
+		writer.Key("unit");         writer.String(result.unit);
+		writer.Key("opsPerSample"); writer.Int64(result.opsPerSample);
+		writeSummary(writer, "nsPerOp", result.nsPerOp);
+		writer.Key("itemsPerSecond"); writer.Double(itemsPerSecond(result));
+		if (result.workers > 0)
+		{
+			writer.Key("workers"); writer.Int(result.workers);
+			writer.Key("speedup"); writer.Double(result.speedup);
+		}
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+	return writeJsonFile(options.out, buffer);
+}
+
+int main(int argc, char** argv)
+{
+	microbenchmarkOptions options;
+	if (!parseOptions(argc, argv, options))
+		return -1;
+
+	bool hasContext = createHeadlessContext(64, 64);
+	if (hasContext)
+		printf("Rendered by: %s, OpenGL %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	else
+		printf("No OpenGL context, only the CPU only kernels run\n");
+
+	std::vector<microbenchmarkCase> cases;
+	std::vector<std::string> generatedFiles;
+	std::vector<std::string> modelPaths;
+	addModelLoadCases(cases, generatedFiles, modelPaths);
+	if (hasContext)
+		addMeshCreationCases(cases);
+	addMatrixCases(cases);
+	addLightCases(cases);
+	addCameraCases(cases);
+	addJobScalingCases(cases, options.workers, modelPaths);
+
+	printf("%-36s %-26s %12s %12s %12s %12s %14s\n", "kernel", "input", "p50 ns/op", "min", "p95", "stddev", "items/s");
+	std::vector<microbenchmarkResult> results;
+	for (const microbenchmarkCase& benchmarkCase : cases)
+	{
+		if (options.filter && benchmarkCase.kernel.find(options.filter) == std::string::npos)
+			continue;
+		if (benchmarkCase.workers > 0 && benchmarkCase.workers != jobSystem::getThreadCount())
+			jobSystem::initialize(benchmarkCase.workers);
+		std::streambuf* console = std::cout.rdbuf(nullptr);
+		microbenchmarkResult result = measure(benchmarkCase, options);
+		std::cout.rdbuf(console);
+		std::cout.clear();
+		printf("%-36s %-26s %12.0f %12.0f %12.0f %12.0f %14.4g\n", result.kernel.c_str(), result.input.c_str(),
+			   result.nsPerOp.p50, result.nsPerOp.min, result.nsPerOp.p95, result.nsPerOp.stddev, itemsPerSecond(result));
+		fflush(stdout);
+		results.push_back(result);
+	}
+	jobSystem::shutdown();
+
+	// speedups against the single worker run of the same kernel and input
+	bool scaling = false;
+	for (microbenchmarkResult& result : results)
+	{
+		if (result.workers == 0)
+			continue;
+		for (const microbenchmarkResult& baseline : results)
+		{
+			if (baseline.workers == 1 && baseline.kernel == result.kernel && baseline.input == result.input &&
+				result.nsPerOp.p50 > 0.0)
+				result.speedup = baseline.nsPerOp.p50 / result.nsPerOp.p50;
+		}
+		if (!scaling)
+			printf("\n%-36s %-26s %8s %12s %8s\n", "kernel", "input", "workers", "p50 ns/op", "speedup");
+		scaling = true;
+		printf("%-36s %-26s %8d %12.0f %8.2f\n", result.kernel.c_str(), result.input.c_str(), result.workers,
+			   result.nsPerOp.p50, result.speedup);
+	}
+
+	for (const std::string& path : generatedFiles)
+		remove(path.c_str());
+	if (!writeReport(options, hasContext, results))
+		return -1;
+	printf("%d results written to %s\n", (int)results.size(), options.out);
+	return 0;
+}
@@ -14,11 +14,10 @@
 // tangent,			vec3,	attribute #3
 //
 // An instance of any of these shapes is create with a single call:
-//    unsigned int obj = CreateSphere(divisions, &quadCount);
+//    unsigned int obj = CreateSphere(divisions, indexCount);
 // and drawn by:
-//	  glBindVertexArray(obj);
-//	  glDrawElements(GL_QUADS, quadCount, GL_UNSIGNED_INT, 0);
-//	  glBindVertexArray(0);
+//	  glState::bindVertexArray(obj);
+//	  glState::drawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT);
 //
 // Copyright 2013 DigiPen Institute of Technology
 ////////////////////////////////////////////////////////////////////////
@@ -27,7 +26,9 @@
 #include <fstream>
 #include <sstream>
 #include <stdlib.h>
-#include "GL\glew.h"
+#include "GL/glew.h"
+#include "profiler.h"
+#include "glState.h"
 
 #include "math.h"
 
@@ -37,58 +38,62 @@
 const float PI = 3.14159f;
 const float rad = PI/180.0f;
 
+////////////////////////////////////////////////////////////////////////
+// Vertex arrays are built through direct state access: buffers get
+// immutable storage with glNamedBufferStorage and are attached to the
+// VAO without binding either, so creating geometry never disturbs
+// what the renderer has bound.  Each stream uses the binding index of
+// its attribute.  An empty stream is left disabled.
+static void addVertexStream(unsigned int vao, int attribute, int components, const void* data, size_t bytes)
+{
+	if (bytes == 0)
+		return;
+	unsigned int buffer;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, bytes, data, 0);
+	glVertexArrayVertexBuffer(vao, attribute, buffer, 0, sizeof(float) * components);
+	glVertexArrayAttribFormat(vao, attribute, components, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(vao, attribute, attribute);
+	glEnableVertexArrayAttrib(vao, attribute);
+}
+
+static void setIndexBuffer(unsigned int vao, const void* data, size_t bytes)
+{
+	if (bytes == 0)
+		return;
+	unsigned int buffer;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, bytes, data, 0);
+	glVertexArrayElementBuffer(vao, buffer);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Create a Vertex Array Object from (1) a collection of arrays
 // containing vertex data and (2) a set of indices inticating quads.
 // The arrays must all be the same length and contain respectively,
 // the vertex position, normal, texture coordinate, and tangent
 // vector.  This is the latest and most efficient way to get geometry
-// into the OpenGL graphics pipeline.
+// into the OpenGL graphics pipeline.  Each quad is split into two
+// triangles, the only primitive the renderer draws.
 unsigned int VaoFromArrays(int nv, int nq, float* Pnt, float* Nrm,
 						   float* Tex, float* Tan, unsigned int* Ind)
 {
+	std::vector<unsigned int> triangles(6*nq);
+	for (int q = 0; q < nq; ++q)
+	{
+		const unsigned int* quad = Ind + 4*q;
+		unsigned int* tri = &triangles[6*q];
+		tri[0] = quad[0];  tri[1] = quad[1];  tri[2] = quad[2];
+		tri[3] = quad[0];  tri[4] = quad[2];  tri[5] = quad[3];
+	}
+
 	unsigned int vao;
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
-
-	GLuint Pbuff;
-	glGenBuffers(1, &Pbuff);
-	glBindBuffer(GL_ARRAY_BUFFER, Pbuff);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float)*4*nv, Pnt, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	GLuint Nbuff;
-	glGenBuffers(1, &Nbuff);
-	glBindBuffer(GL_ARRAY_BUFFER, Nbuff);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float)*3*nv, Nrm, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	GLuint Tbuff;
-	glGenBuffers(1, &Tbuff);
-	glBindBuffer(GL_ARRAY_BUFFER, Tbuff);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float)*2*nv, Tex, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	GLuint Dbuff;
-	glGenBuffers(1, &Dbuff);
-	glBindBuffer(GL_ARRAY_BUFFER, Dbuff);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float)*3*nv, Tan, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	GLuint Ibuff;
-	glGenBuffers(1, &Ibuff);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Ibuff);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int)*4*nq, Ind, GL_STATIC_DRAW);
-
-	glBindVertexArray(0);
+	glCreateVertexArrays(1, &vao);
+	addVertexStream(vao, 0, 4, Pnt, sizeof(float)*4*nv);
+	addVertexStream(vao, 1, 3, Nrm, sizeof(float)*3*nv);
+	addVertexStream(vao, 2, 2, Tex, sizeof(float)*2*nv);
+	addVertexStream(vao, 3, 3, Tan, sizeof(float)*3*nv);
+	setIndexBuffer(vao, triangles.data(), sizeof(unsigned int)*triangles.size());
 
 	delete[] Pnt;
 	delete[] Nrm;
@@ -539,6 +544,7 @@ unsigned int CreateTeapot(const int n, unsigned int& count)
 					p30++; p31++; p32++; p33++; }
 
 				*pp++ = 1.0;
+				*tp++ = u;  *tp++ = v;
 
 				// Calculate the surface notmal as the cross product of the two tangents.
 				*np++ = -(du[1]*dv[2]-du[2]*dv[1]);
@@ -553,12 +559,22 @@ unsigned int CreateTeapot(const int n, unsigned int& count)
 					*ip++ = p*(n+1)*(n+1) + (i  )*(n+1) + (j-1); } } } }
 
 	GLuint vao = VaoFromArrays(nv, nq, Pnt, Nrm, Tex, Tan, Ind);
-	count = 4*nq;
+	count = 6*nq;
 	return vao;
 }
 
 
 
+// A Bezier patch lies inside the convex hull of its control points,
+// so the farthest control point bounds the whole teapot.
+float teapotBoundingRadius()
+{
+	float radius = 0.f;
+	for (unsigned int i = 0; i < sizeof(P)/sizeof(P[0]); ++i)
+		radius = glm::max(radius, glm::length(glm::vec3(P[i][0], P[i][1], P[i][2])));
+	return radius;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Generates a sphere with normals, texture coords, and tangent vectors.
 unsigned int CreateSphere(const int n, unsigned int& count)
@@ -589,7 +605,7 @@ unsigned int CreateSphere(const int n, unsigned int& count)
 				*ip++ = (i  )*(n+1) + (j-1); } } }
 	
 	GLuint vao = VaoFromArrays(nv, nq, Pnt, Nrm, Tex, Tan, Ind);
-	count = 4*nq;
+	count = 6*nq;
 	return vao;
 }
 
@@ -622,12 +638,13 @@ unsigned int CreateGround(const float r, const int n, unsigned int& count)
 				*ip++ = (i  )*(n+1) + (j-1); } } }
 	
 	GLuint vao = VaoFromArrays(nv, nq, Pnt, Nrm, Tex, Tan, Ind);
-	count = 4*nq;
+	count = 6*nq;
 	return vao;
 }
 
 bool loadModelFromFile(const char *path, meshData &mesh)
 {
+	PROFILE_ZONE("loadModelFromFile");
 	std::ifstream ifs(path, std::ifstream::in | std::ifstream::binary);
 	if (!ifs.is_open())
 	{
@@ -699,61 +716,53 @@ bool loadModelFromFile(const char *path, meshData &mesh)
 
 unsigned int createVAO(meshData& mesh)
 {
+	PROFILE_ZONE("createVAO");
 	unsigned int vao;
-
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
-
-	unsigned int vertices;
-	glGenBuffers(1, &vertices);
-	glBindBuffer(GL_ARRAY_BUFFER, vertices);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.verts.size(), &mesh.verts.front(), GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	unsigned int normals;
-	glGenBuffers(1, &normals);
-	glBindBuffer(GL_ARRAY_BUFFER, normals);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.normals.size(), &mesh.normals.front(), GL_STATIC_DRAW);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(1);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	
-	unsigned int uv;
-	glGenBuffers(1, &uv);
-	glBindBuffer(GL_ARRAY_BUFFER, uv);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.uvs.size(), &mesh.uvs.front(), GL_STATIC_DRAW);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(2);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	unsigned int tan;
-	glGenBuffers(1, &tan);
-	glBindBuffer(GL_ARRAY_BUFFER, tan);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.tans.size(), &mesh.tans.front(), GL_STATIC_DRAW);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(3);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	unsigned int bitan;
-	glGenBuffers(1, &bitan);
-	glBindBuffer(GL_ARRAY_BUFFER, bitan);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.biTans.size(), &mesh.biTans.front(), GL_STATIC_DRAW);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(4);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	unsigned int indicies;
-	glGenBuffers(1, &indicies);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indicies);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.faces.size(), &mesh.faces.front(), GL_STATIC_DRAW);
-
-	glBindVertexArray(0);
+	glCreateVertexArrays(1, &vao);
+	addVertexStream(vao, 0, 3, mesh.verts.data(), sizeof(glm::vec3) * mesh.verts.size());
+	addVertexStream(vao, 1, 3, mesh.normals.data(), sizeof(glm::vec3) * mesh.normals.size());
+	addVertexStream(vao, 2, 3, mesh.uvs.data(), sizeof(glm::vec3) * mesh.uvs.size());
+	addVertexStream(vao, 3, 3, mesh.tans.data(), sizeof(glm::vec3) * mesh.tans.size());
+	addVertexStream(vao, 4, 3, mesh.biTans.data(), sizeof(glm::vec3) * mesh.biTans.size());
+	setIndexBuffer(vao, mesh.faces.data(), sizeof(unsigned int) * mesh.faces.size());
 
 	return vao;
 }
 
+// Radius of the sphere around the model origin containing every vertex.
+// The streams sit on the binding index of their attribute, so the
+// buffers are found without remembering them at creation.
+void deleteVAO(unsigned int vao)
+{
+	for (int binding = 0; binding <= 4; ++binding)
+	{
+		int buffer = 0;
+		glGetVertexArrayIndexediv(vao, binding, GL_VERTEX_BINDING_BUFFER, &buffer);
+		if (buffer != 0)
+		{
+			unsigned int name = (unsigned int)buffer;
+			glDeleteBuffers(1, &name);
+		}
+	}
+	int indexBuffer = 0;
+	glGetVertexArrayiv(vao, GL_ELEMENT_ARRAY_BUFFER_BINDING, &indexBuffer);
+	if (indexBuffer != 0)
+	{
+		unsigned int name = (unsigned int)indexBuffer;
+		glDeleteBuffers(1, &name);
+	}
+	glState::onDeleteVertexArray(vao);
+	glDeleteVertexArrays(1, &vao);
+}
+
+float computeBoundingRadius(const meshData& mesh)
+{
+	float radius = 0.f;
+	for (unsigned int i = 0; i < mesh.verts.size(); ++i)
+		radius = glm::max(radius, glm::length(mesh.verts[i]));
+	return radius;
+}
+
 unsigned int createQuad(unsigned int &faceCount)
 {
 
@@ -804,30 +813,11 @@ unsigned int createQuad(unsigned int &faceCount)
 		0, 1, 3, // First Triangle
 		1, 2, 3  // Second Triangle
 	};
-	GLuint VBO, VAO, EBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-
-	glBindVertexArray(VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	unsigned int uv;
-	glGenBuffers(1, &uv);
-	glBindBuffer(GL_ARRAY_BUFFER, uv);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(texCoords), texCoords, GL_STATIC_DRAW);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(1);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	glBindVertexArray(0); // Unbind VAO
+	GLuint VAO;
+	glCreateVertexArrays(1, &VAO);
+	addVertexStream(VAO, 0, 3, vertices, sizeof(vertices));
+	addVertexStream(VAO, 1, 2, texCoords, sizeof(texCoords));
+	setIndexBuffer(VAO, indices, sizeof(indices));
 	faceCount = 6;
 	return VAO;
 
@@ -14,11 +14,12 @@
 // tangent,			vec3,	attribute #3
 //
 // An instance of any of these shapes is create with a single call:
-//    unsigned int obj = CreateSphere(divisions, &quadCount);
+//    unsigned int obj = CreateSphere(divisions, indexCount);
 // and drawn by:
-//	  glBindVertexArray(obj);
-//	  glDrawElements(GL_QUADS, quadCount, GL_UNSIGNED_INT, 0);
-//	  glBindVertexArray(0);
+//	  glState::bindVertexArray(obj);
+//	  glState::drawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT);
+// and released, buffers included, by:
+//    deleteVAO(obj);
 //
 // Copyright 2013 DigiPen Institute of Technology
 ////////////////////////////////////////////////////////////////////////
@@ -26,7 +27,7 @@
 #include <string>
 #include <vector>
 
-#include "glm\ext.hpp"
+#include "glm/ext.hpp"
 
 struct meshData
 {
@@ -43,7 +44,10 @@ typedef std::vector<meshData> modelData;
 
 bool loadModelFromFile(const char *path, meshData &mesh);
 unsigned int createVAO(meshData& mesh);
+void deleteVAO(unsigned int vao);
+float computeBoundingRadius(const meshData& mesh);
 unsigned int createQuad(unsigned int& faceCount);
 unsigned int CreateTeapot(const int n,  unsigned int& count);
+float teapotBoundingRadius();
 unsigned int CreateSphere(const int n,  unsigned int& count);
 unsigned int CreateGround(const float range, const int n,  unsigned int& count);
@@ -1,5 +1,5 @@
 #include "object.h"
-#include "glm\ext.hpp"
+#include "glm/ext.hpp"
 object::object()
 {
 
@@ -10,18 +10,24 @@ object::~object()
 
 }
 
-void object::setPosition(glm::vec3 &pos)
+void object::setPosition(const glm::vec3 &pos)
 {
+	if (translate != pos)
+		++transformVersion;
 	translate = pos;
 }
 
 void object::setRotation(glm::vec3 &rot)
 {
+	if (rotate != rot)
+		++transformVersion;
 	rotate = rot;
 }
 
 void object::setScale(glm::vec3 &s)
 {
+	if (scale != s)
+		++transformVersion;
 	scale = s;
 }
 
@@ -40,6 +46,11 @@ void object::setIsVisible(bool flag)
 	isVisible = flag;
 }
 
+void object::setIsStatic(bool flag)
+{
+	isStatic = flag;
+}
+
 void object::setName(char* name)
 {
 	objectName = name;
@@ -75,6 +86,16 @@ bool object::getIsVisible()
 	return isVisible;
 }
 
+bool object::getIsStatic()
+{
+	return isStatic;
+}
+
+unsigned int object::getTransformVersion()
+{
+	return transformVersion;
+}
+
 const char* object::getName()
 {
 	return objectName.c_str();
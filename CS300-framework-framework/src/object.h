@@ -1,6 +1,6 @@
 #pragma once
 
-#include "glm\glm.hpp"
+#include "glm/glm.hpp"
 #include <string>
 
 class object
@@ -10,12 +10,13 @@ public:
 	~object();
 	virtual void update(void(*updateFN)()) = 0;
 	virtual void draw(unsigned int shader) = 0;
-	void setPosition(glm::vec3 &pos);
+	void setPosition(const glm::vec3 &pos);
 	void setRotation(glm::vec3 &rot);
 	void setScale(glm::vec3 &s);
 	void setIsShadowCaster(bool flag);
 	void setIsShadowReceiver(bool flag);
 	void setIsVisible(bool flag);
+	void setIsStatic(bool flag);
 	void setName(char* name);
 
 	glm::vec3 getTranslation();
@@ -24,6 +25,8 @@ public:
 	bool getIsShadowCaster();
 	bool getIsShadowReceiver();
 	bool getIsVisible();
+	bool getIsStatic();
+	unsigned int getTransformVersion();
 	const char* getName();
 protected:
 	std::string objectName;
@@ -33,4 +36,7 @@ protected:
 	bool isShadowCaster = false;
 	bool isShadowReceiver = false;
 	bool isVisible = true;
+	bool isStatic = true;
+	// bumped whenever the position, rotation or scale actually changes
+	unsigned int transformVersion = 0;
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "shader.h"
+#include "fbo.h"
+#include "scene.h"
+#include "onDemandRendering.h"
+#include "profiler.h"
+
+void requestRedraw(Scene &scene, int frames)
+{
+	onDemandParam &param = scene.onDemandParameters;
+	param.redrawFrames = glm::max(param.redrawFrames, frames + param.settleFrames);
+}
+
+static bool sceneChanged(Scene &scene)
+{
+	onDemandParam &param = scene.onDemandParameters;
+	bool changed = false;
+
+	unsigned int cameraVersion = scene.gEditorCamera.getVersion();
+	if (cameraVersion != param.cameraVersion)
+	{
+		param.cameraVersion = cameraVersion;
+		changed = true;
+	}
+
+	unsigned int objectVersions = 0;
+	for (graphicObject &object : scene.graphicsObjectContainer)
+		objectVersions += object.getTransformVersion();
+	unsigned int objectCount = (unsigned int)scene.graphicsObjectContainer.size();
+	if (objectVersions != param.objectVersions || objectCount != param.objectCount)
+	{
+		param.objectVersions = objectVersions;
+		param.objectCount = objectCount;
+		changed = true;
+	}
+
+	if (changed)
+		return true;
+	if (scene.recording.mode != frameRecordingState::OFF)
+		return true;
+	if (scene.mAmbientLight.getAmbientColor() != scene.ambientLightParameters.ambientLightColor ||
+		scene.mAmbientLight.getAmbientStrength() != scene.ambientLightParameters.ambientLightStrength)
+		return true;
+	return !scene.mLightManager.matchesParameters(scene.pointLightParameters, scene.directionalLightParameters);
+}
+
+bool beginOnDemandFrame(Scene &scene)
+{
+	PROFILE_ZONE("beginOnDemandFrame");
+	onDemandParam &param = scene.onDemandParameters;
+	// the versions are followed while disabled too, so turning it on
+	// does not count the whole history as one change
+	if (sceneChanged(scene))
+		requestRedraw(scene);
+
+	bool draw = !param.enabled || param.redrawFrames > 0;
+	if (param.redrawFrames > 0)
+		--param.redrawFrames;
+	if (draw)
+		++param.framesDrawn;
+	else
+		++param.framesSkipped;
+	param.skippedPercent = 100.f * param.framesSkipped / (param.framesDrawn + param.framesSkipped);
+	return draw;
+}
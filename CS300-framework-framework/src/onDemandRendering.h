@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////
+// On-demand rendering: when nothing that shows on screen changed since
+// the last frame, the framework skips DrawScene and the buffer swap,
+// so the window keeps presenting the last frame and an idle display
+// costs next to nothing.
+//
+// A frame is drawn when
+//   * the camera moved (camera::getVersion),
+//   * an object was moved, turned or scaled (object::getTransformVersion),
+//   * a light parameter differs from what the lights were last drawn
+//     with (lightManager::matchesParameters, plus the ambient light),
+//   * a frame recording is recording or replaying, or
+//   * someone asked for it with requestRedraw: the framework does on
+//     every input event (which covers everything the tweak bars edit),
+//     resize and expose; time-based effects call it every frame they
+//     animate.
+// Every change is followed by settleFrames more frames, for whatever
+// needs a few frames to catch up: the staggered shadow cascades, the
+// GPU timer results that arrive late, dynamic resolution.
+//
+// The skipped frames are the idle savings: frames that would have been
+// drawn had rendering been continuous.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+class Scene;
+
+struct onDemandParam
+{
+	bool enabled = false;
+	int settleFrames = 4;           // the farthest cascades redraw every 4th frame
+	int framesDrawn = 0;
+	int framesSkipped = 0;
+	float skippedPercent = 0.f;
+	// what the last drawn frame saw
+	int redrawFrames = 0;           // still owed, settling included
+	unsigned int cameraVersion = 0;
+	unsigned int objectVersions = 0;    // sum over the objects, they only grow
+	unsigned int objectCount = 0;
+};
+
+// Draws the next frames frames, then settleFrames more.
+void requestRedraw(Scene &scene, int frames = 1);
+// Called once per frame before DrawScene; false when it can be skipped.
+bool beginOnDemandFrame(Scene &scene);
@@ -1,7 +1,8 @@
 #include "pointLight.h"
-#include "GL\glew.h"
-#include "glm\ext.hpp"
-#include <sstream>
+#include "GL/glew.h"
+#include "frameArena.h"
+#include "glState.h"
+#include "glm/ext.hpp"
 
 pointLight::pointLight()
 {
@@ -13,8 +14,8 @@ pointLight::~pointLight()
 
 }
 
-pointLight::pointLight(glm::vec3 &pos, unsigned int meshType, unsigned int indexCount,
-	glm::vec3 &diffuseColor, glm::vec3 &hilightColor)
+pointLight::pointLight(const glm::vec3 &pos, unsigned int meshType, unsigned int indexCount,
+	const glm::vec3 &diffuseColor, const glm::vec3 &hilightColor)
 {
 	setPosition(pos);
 	lightColor = diffuseColor;
@@ -31,29 +32,26 @@ void pointLight::update(void(*updateFN)())
 
 void pointLight::updateLightParameter(unsigned int shader)
 {
-	std::stringstream ss;
-	ss << "pointLight[" << lightIndex << "].";
+	int loc = glGetUniformLocation(shader, frameArena::format("pointLight[%d].diffuse", lightIndex));
+	glProgramUniform3fv(shader, loc, 1, glm::value_ptr(lightColor));
 
-	int loc = glGetUniformLocation(shader, (ss.str() + "diffuse").c_str());
-	glUniform3fv(loc, 1, glm::value_ptr(lightColor));
+	loc = glGetUniformLocation(shader, frameArena::format("pointLight[%d].position", lightIndex));
+	glProgramUniform3fv(shader, loc, 1, glm::value_ptr(getTranslation()));
 
-	loc = glGetUniformLocation(shader, (ss.str() + "position").c_str());
-	glUniform3fv(loc, 1, glm::value_ptr(getTranslation()));
+	loc = glGetUniformLocation(shader, frameArena::format("pointLight[%d].specular", lightIndex));
+	glProgramUniform3fv(shader, loc, 1, glm::value_ptr(specularColor));
 
-	loc = glGetUniformLocation(shader, (ss.str() + "specular").c_str());
-	glUniform3fv(loc, 1, glm::value_ptr(specularColor));
+	loc = glGetUniformLocation(shader, frameArena::format("pointLight[%d].distance", lightIndex));
+	glProgramUniform1f(shader, loc, attenuationDistance);
 
-	loc = glGetUniformLocation(shader, (ss.str() + "distance").c_str());
-	glUniform1f(loc, attenuationDistance);
+	loc = glGetUniformLocation(shader, frameArena::format("pointLight[%d].constant", lightIndex));
+	glProgramUniform1f(shader, loc, attenutationConstant);
 
-	loc = glGetUniformLocation(shader, (ss.str() + "constant").c_str());
-	glUniform1f(loc, attenutationConstant);
+	loc = glGetUniformLocation(shader, frameArena::format("pointLight[%d].linear", lightIndex));
+	glProgramUniform1f(shader, loc, attenutationLinear);
 
-	loc = glGetUniformLocation(shader, (ss.str() + "linear").c_str());
-	glUniform1f(loc, attenutationLinear);
-
-	loc = glGetUniformLocation(shader, (ss.str() + "quadratic").c_str());
-	glUniform1f(loc, attenuationQuadratic);
+	loc = glGetUniformLocation(shader, frameArena::format("pointLight[%d].quadratic", lightIndex));
+	glProgramUniform1f(shader, loc, attenuationQuadratic);
 }
 
 void pointLight::draw(unsigned int shader)
@@ -63,12 +61,11 @@ void pointLight::draw(unsigned int shader)
 	glm::mat4 scale = glm::scale(glm::vec3(5, 5, 5));
 	glm::mat4 modelMtx  = translate * scale;
 	int loc = glGetUniformLocation(shader, "ModelMatrix");
-	glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(modelMtx));
+	glProgramUniformMatrix4fv(shader, loc, 1, GL_FALSE, glm::value_ptr(modelMtx));
 	loc = glGetUniformLocation(shader, "diffuse");
-	glUniform3fv(loc, 1, glm::value_ptr(lightColor));
-	glBindVertexArray(mesh);
-	glDrawElements(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	glProgramUniform3fv(shader, loc, 1, glm::value_ptr(lightColor));
+	glState::bindVertexArray(mesh);
+	glState::drawElements(GL_TRIANGLES, meshIndexCount, GL_UNSIGNED_INT);
 }
 
 void pointLight::setDiffuseColor(glm::vec3 &diffuse)
@@ -7,10 +7,10 @@ class pointLight : public light
 public:
 	pointLight();
 	~pointLight();
-	pointLight(glm::vec3 &position,
+	pointLight(const glm::vec3 &position,
 		       unsigned int meshType, unsigned int indexCount,
-		       glm::vec3 &diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f),
-		       glm::vec3 &hilightColor = glm::vec3(0.5f, 0.5f, 0.5f));
+		       const glm::vec3 &diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f),
+		       const glm::vec3 &hilightColor = glm::vec3(0.5f, 0.5f, 0.5f));
 
 	void update(void(*updateFN)());
 	void draw(unsigned int shader);
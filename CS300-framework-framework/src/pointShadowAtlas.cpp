@@ -0,0 +1,376 @@
+#include "pointShadowAtlas.h"
+#include "pointLight.h"
+#include "graphicObject.h"
+#include "GL/glew.h"
+#include "glState.h"
+#include "glDebug.h"
+#include "frameTiming.h"
+#include "jobSystem.h"
+#include "frameArena.h"
+#include "profiler.h"
+#include "glm/ext.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// Same table as the lighting pass: face 0..5 = +X, -X, +Y, -Y, +Z, -Z,
+	// laid out as columns face % 3, rows face / 3 of a tile.
+	const glm::vec3 faceForward[6] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+									   glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+	const glm::vec3 faceUp[6] = { glm::vec3(0, -1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1),
+								  glm::vec3(0, 0, -1), glm::vec3(0, -1, 0), glm::vec3(0, -1, 0) };
+
+	unsigned int hashCombine(unsigned int hash, unsigned int value)
+	{
+		return (hash ^ value) * 16777619u;
+	}
+
+	unsigned int hashFloat(unsigned int hash, float value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return hashCombine(hash, bits);
+	}
+
+	int nextPowerOfTwo(int value)
+	{
+		int result = 1;
+		while (result < value)
+			result <<= 1;
+		return result;
+	}
+}
+
+pointShadowAtlas::pointShadowAtlas()
+{
+
+}
+
+pointShadowAtlas::~pointShadowAtlas()
+{
+
+}
+
+void pointShadowAtlas::initialize(renderTargetPool& pool, int size)
+{
+	atlasSize = size;
+
+	fboDesc desc;
+	desc.width = atlasSize;
+	desc.height = atlasSize;
+	desc.layers = 2;
+	desc.depthFormat = GL_DEPTH_COMPONENT24;
+	target = pool.acquire(desc);
+	GL_DEBUG_LABEL(GL_FRAMEBUFFER, target->getFBO(), "Point Shadow Atlas");
+
+	// start with the whole atlas at the far plane
+	target->Bind();
+	target->BindLayer(SHADOW_LAYER);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// forces every tile to be packed and drawn again
+	tiles.clear();
+	for (int i = 0; i < MAX_LIGHTS; ++i)
+	{
+		tileUniform[i] = glm::vec4(0.f);
+		farPlane[i] = 1.f;
+	}
+}
+
+void pointShadowAtlas::release(renderTargetPool& pool)
+{
+	pool.release(target);
+	target = nullptr;
+}
+
+// Shelf packing of 3 x 2 face tiles, largest first.  Fails when the
+// atlas is too small for the requested sizes.
+bool pointShadowAtlas::packTiles(int lightCount, const int* faceSizes)
+{
+	int order[MAX_LIGHTS];
+	for (int i = 0; i < lightCount; ++i)
+		order[i] = i;
+	std::sort(order, order + lightCount, [&](int a, int b) { return faceSizes[a] > faceSizes[b]; });
+
+	int shelfX = 0, shelfY = 0, shelfHeight = 0;
+	for (int i = 0; i < lightCount; ++i)
+	{
+		int light = order[i];
+		int width = faceSizes[light] * 3;
+		int height = faceSizes[light] * 2;
+		if (shelfX + width > atlasSize)
+		{
+			shelfY += shelfHeight;
+			shelfX = 0;
+			shelfHeight = 0;
+		}
+		if (shelfY + height > atlasSize || width > atlasSize)
+			return false;
+
+		tiles[light].x = shelfX;
+		tiles[light].y = shelfY;
+		tiles[light].faceSize = faceSizes[light];
+		shelfX += width;
+		shelfHeight = std::max(shelfHeight, height);
+	}
+	return true;
+}
+
+void pointShadowAtlas::allocateTiles(std::vector<pointLight>& lights, const glm::vec3& cameraPos, float fovDeg,
+									 int screenHeight, int minFaceSize, int maxFaceSize)
+{
+	int lightCount = std::min((int)lights.size(), (int)MAX_LIGHTS);
+	bool repack = (int)tiles.size() != lightCount;
+	if (repack)
+		tiles.assign(lightCount, tileState());
+
+	// face size from the screen height covered by the light's radius
+	float tanHalfFov = glm::tan(glm::radians(fovDeg) * 0.5f);
+	int faceSizes[MAX_LIGHTS];
+	for (int i = 0; i < lightCount; ++i)
+	{
+		float radius, constant, linear, quadratic;
+		lights[i].getAttenuationParameters(radius, constant, linear, quadratic);
+		float distance = glm::length(lights[i].getTranslation() - cameraPos);
+		float coverage = distance > radius ? radius / (distance * tanHalfFov) : 1.f;
+		int desired = nextPowerOfTwo((int)(glm::min(coverage, 1.f) * screenHeight * 0.5f));
+		desired = glm::clamp(desired, minFaceSize, maxFaceSize);
+
+		// only follow the camera by whole powers of two, so tiles are not
+		// repacked (and redrawn) every time the camera moves a little
+		int current = tiles[i].faceSize;
+		if (current == 0 || desired >= current * 2 || desired * 4 <= current ||
+			current > maxFaceSize || current < minFaceSize)
+		{
+			faceSizes[i] = desired;
+			repack |= desired != current;
+		}
+		else
+		{
+			faceSizes[i] = current;
+		}
+	}
+
+	if (repack)
+	{
+		// halve everything until it fits
+		while (!packTiles(lightCount, faceSizes))
+		{
+			for (int i = 0; i < lightCount; ++i)
+				faceSizes[i] = std::max(faceSizes[i] / 2, 16);
+		}
+	}
+
+	for (int i = 0; i < MAX_LIGHTS; ++i)
+	{
+		if (i < lightCount)
+		{
+			float radius, constant, linear, quadratic;
+			lights[i].getAttenuationParameters(radius, constant, linear, quadratic);
+			tileUniform[i] = glm::vec4((float)tiles[i].x / atlasSize, (float)tiles[i].y / atlasSize,
+									   (float)tiles[i].faceSize / atlasSize, 1.f);
+			farPlane[i] = std::max(radius, nearPlane * 2.f);
+		}
+		else
+		{
+			tileUniform[i] = glm::vec4(0.f);
+		}
+	}
+}
+
+void pointShadowAtlas::renderFaces(tileState& tile, const glm::vec3& lightPos, float lightFar, int layer,
+								   std::vector<graphicObject>& objects, const int* casters, int casterCount,
+								   unsigned int shader)
+{
+	target->BindLayer(layer);
+	glm::mat4 projection = glm::perspective(90.f, 1.f, nearPlane, lightFar);
+	int lightSpaceLoc = glGetUniformLocation(shader, "LightSpaceMtx");
+	int modelLoc = glGetUniformLocation(shader, "ModelMatrix");
+	for (int face = 0; face < 6; ++face)
+	{
+		int x = tile.x + (face % 3) * tile.faceSize;
+		int y = tile.y + (face / 3) * tile.faceSize;
+		glState::viewport(x, y, tile.faceSize, tile.faceSize);
+		glScissor(x, y, tile.faceSize, tile.faceSize);
+		if (layer == STATIC_LAYER)
+			glClear(GL_DEPTH_BUFFER_BIT);
+
+		glm::mat4 view = glm::lookAt(lightPos, lightPos + faceForward[face], faceUp[face]);
+		glm::mat4 lightSpace = projection * view;
+		glProgramUniformMatrix4fv(shader, lightSpaceLoc, 1, GL_FALSE, glm::value_ptr(lightSpace));
+
+		// planes of the 90 degree face frustum
+		faceCasters.clear();
+		{
+			frameTiming::scope culling(frameTiming::CULLING);
+			glm::vec3 side = glm::normalize(glm::cross(faceForward[face], faceUp[face]));
+			glm::vec3 up = glm::cross(side, faceForward[face]);
+			glm::vec3 planes[4] = { faceForward[face] + side, faceForward[face] - side,
+									faceForward[face] + up, faceForward[face] - up };
+			for (int i = 0; i < casterCount; ++i)
+			{
+				graphicObject& object = objects[casters[i]];
+				glm::vec3 offset = object.getTranslation() - lightPos;
+				float radius = object.getWorldBoundingRadius() * 1.41422f;  // planes are not normalized
+				bool outside = false;
+				for (int p = 0; p < 4 && !outside; ++p)
+					outside = glm::dot(offset, planes[p]) < -radius;
+				if (!outside)
+					faceCasters.push_back(casters[i]);
+			}
+		}
+		for (int i : faceCasters)
+			objects[i].drawDepth(shader, modelLoc);
+		++facesRendered;
+	}
+}
+
+void pointShadowAtlas::gatherCasters(unsigned int tileIndex, const glm::vec3& lightPos, std::vector<graphicObject>& objects)
+{
+	const tileState& tile = tiles[tileIndex];
+	tileCasters& result = casters[tileIndex];
+	float lightFar = farPlane[tileIndex];
+	auto inReach = [&](graphicObject& object)
+	{
+		if (!object.getIsShadowCaster())
+			return false;
+		float reach = lightFar + object.getWorldBoundingRadius();
+		glm::vec3 offset = object.getTranslation() - lightPos;
+		return glm::dot(offset, offset) <= reach * reach;
+	};
+
+	// counted first, so the arena only holds the casters in reach
+	int staticCount = 0;
+	int dynamicCount = 0;
+	for (graphicObject& object : objects)
+	{
+		if (inReach(object))
+			++(object.getIsStatic() ? staticCount : dynamicCount);
+	}
+	result.staticCasters = frameArena::allocateArray<int>(staticCount);
+	result.dynamicCasters = frameArena::allocateArray<int>(dynamicCount);
+	result.staticCount = 0;
+	result.dynamicCount = 0;
+	unsigned int staticHash = 2166136261u;
+	staticHash = hashFloat(staticHash, lightPos.x);
+	staticHash = hashFloat(staticHash, lightPos.y);
+	staticHash = hashFloat(staticHash, lightPos.z);
+	staticHash = hashFloat(staticHash, lightFar);
+	staticHash = hashCombine(staticHash, tile.x);
+	staticHash = hashCombine(staticHash, tile.y);
+	staticHash = hashCombine(staticHash, tile.faceSize);
+	unsigned int dynamicHash = 2166136261u;
+	for (unsigned int j = 0; j < objects.size(); ++j)
+	{
+		graphicObject& object = objects[j];
+		if (!inReach(object))
+			continue;
+
+		if (object.getIsStatic())
+		{
+			result.staticCasters[result.staticCount++] = j;
+			staticHash = hashCombine(hashCombine(staticHash, j), object.getTransformVersion());
+		}
+		else
+		{
+			result.dynamicCasters[result.dynamicCount++] = j;
+			dynamicHash = hashCombine(hashCombine(dynamicHash, j), object.getTransformVersion());
+		}
+	}
+	result.staticHash = staticHash;
+	result.dynamicHash = dynamicHash;
+}
+
+void pointShadowAtlas::render(std::vector<pointLight>& lights, std::vector<graphicObject>& objects, unsigned int shader)
+{
+	staticTilesRedrawn = 0;
+	shadowTilesRedrawn = 0;
+	facesRendered = 0;
+
+	{
+		frameTiming::scope culling(frameTiming::CULLING);
+		casters.resize(tiles.size());
+		jobSystem::parallelFor(0, (int)tiles.size(), 1, [&](int begin, int end)
+		{
+			PROFILE_ZONE("pointShadowAtlas::gatherCasters chunk");
+			for (int i = begin; i < end; ++i)
+				gatherCasters(i, lights[i].getTranslation(), objects);
+		});
+	}
+
+	target->Bind();
+	glState::setEnabled(GL_SCISSOR_TEST, true);
+	glState::setEnabled(GL_POLYGON_OFFSET_FILL, true);
+	glPolygonOffset(2.f, 4.f);
+	for (unsigned int i = 0; i < tiles.size(); ++i)
+	{
+		tileState& tile = tiles[i];
+		const tileCasters& inRange = casters[i];
+		glm::vec3 lightPos = lights[i].getTranslation();
+		float lightFar = farPlane[i];
+
+		bool staticDirty = inRange.staticHash != tile.staticHash;
+		if (staticDirty)
+		{
+			renderFaces(tile, lightPos, lightFar, STATIC_LAYER, objects, inRange.staticCasters, inRange.staticCount, shader);
+			tile.staticHash = inRange.staticHash;
+			++staticTilesRedrawn;
+		}
+
+		if (staticDirty || inRange.dynamicHash != tile.dynamicHash)
+		{
+			// cached static depth first, then the dynamic casters on top
+			unsigned int depthTexture = target->getDepthTexture();
+			glCopyImageSubData(depthTexture, GL_TEXTURE_2D_ARRAY, 0, tile.x, tile.y, STATIC_LAYER,
+							   depthTexture, GL_TEXTURE_2D_ARRAY, 0, tile.x, tile.y, SHADOW_LAYER,
+							   tile.faceSize * 3, tile.faceSize * 2, 1);
+			if (inRange.dynamicCount > 0)
+				renderFaces(tile, lightPos, lightFar, SHADOW_LAYER, objects, inRange.dynamicCasters, inRange.dynamicCount, shader);
+			tile.dynamicHash = inRange.dynamicHash;
+			++shadowTilesRedrawn;
+		}
+	}
+	glState::setEnabled(GL_POLYGON_OFFSET_FILL, false);
+	glState::setEnabled(GL_SCISSOR_TEST, false);
+}
+
+int pointShadowAtlas::getAtlasSize()
+{
+	return atlasSize;
+}
+
+unsigned int pointShadowAtlas::getDepthTexture()
+{
+	return target->getDepthTexture();
+}
+
+float pointShadowAtlas::getNearPlane()
+{
+	return nearPlane;
+}
+
+const glm::vec4* pointShadowAtlas::getTiles()
+{
+	return tileUniform;
+}
+
+const float* pointShadowAtlas::getFarPlanes()
+{
+	return farPlane;
+}
+
+int pointShadowAtlas::getStaticTilesRedrawn()
+{
+	return staticTilesRedrawn;
+}
+
+int pointShadowAtlas::getShadowTilesRedrawn()
+{
+	return shadowTilesRedrawn;
+}
+
+int pointShadowAtlas::getFacesRendered()
+{
+	return facesRendered;
+}
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////
+// Omnidirectional shadows for point lights, packed into one depth
+// atlas.  Every light gets a tile of six faces (3 x 2) whose size
+// follows how much of the screen the light's radius covers.
+//
+// The atlas texture has two layers.  Layer 0 caches the static casters
+// of each tile and is only redrawn when the light moves, its tile is
+// repacked, or a static caster in range changes.  Layer 1 is what the
+// lighting pass samples: the cached tile copied over, with dynamic
+// casters drawn on top, and only when the set of dynamic casters in
+// range (or one of their transforms) changed.
+//
+// Finding the casters in range of each light and hashing them is done
+// for all tiles at once, a job per tile; only the drawing is serial.
+// The caster lists live in the frame arena.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "renderTargetPool.h"
+
+class pointLight;
+class graphicObject;
+
+class pointShadowAtlas
+{
+public:
+	static const int MAX_LIGHTS = 32;
+	static const int STATIC_LAYER = 0;
+	static const int SHADOW_LAYER = 1;
+
+	pointShadowAtlas();
+	~pointShadowAtlas();
+	void initialize(renderTargetPool& pool, int size);
+	void release(renderTargetPool& pool);
+	void allocateTiles(std::vector<pointLight>& lights, const glm::vec3& cameraPos, float fovDeg,
+					   int screenHeight, int minFaceSize, int maxFaceSize);
+	void render(std::vector<pointLight>& lights, std::vector<graphicObject>& objects, unsigned int shader);
+
+	int getAtlasSize();
+	unsigned int getDepthTexture();
+	float getNearPlane();
+	const glm::vec4* getTiles();
+	const float* getFarPlanes();
+	int getStaticTilesRedrawn();
+	int getShadowTilesRedrawn();
+	int getFacesRendered();
+private:
+	struct tileState
+	{
+		int x = 0, y = 0;
+		int faceSize = 0;
+		unsigned int staticHash = 0;
+		unsigned int dynamicHash = 0;
+	};
+	// casters in range of a tile's light, and hashes of everything that
+	// would change the tile, for this frame
+	struct tileCasters
+	{
+		int* staticCasters = nullptr;   // frame arena
+		int* dynamicCasters = nullptr;
+		int staticCount = 0;
+		int dynamicCount = 0;
+		unsigned int staticHash = 0;
+		unsigned int dynamicHash = 0;
+	};
+	bool packTiles(int lightCount, const int* faceSizes);
+	void gatherCasters(unsigned int tileIndex, const glm::vec3& lightPos, std::vector<graphicObject>& objects);
+	void renderFaces(tileState& tile, const glm::vec3& lightPos, float lightFar, int layer,
+					 std::vector<graphicObject>& objects, const int* casters, int casterCount, unsigned int shader);
+
+	FBO* target = nullptr;  // held across frames, the tiles are cached
+	int atlasSize = 0;
+	const float nearPlane = 0.5f;
+	std::vector<tileState> tiles;
+	std::vector<tileCasters> casters;
+	std::vector<int> faceCasters;     // scratch, reused every face
+	// per light values for the lighting pass: tile origin (uv), face size (uv), has tile
+	glm::vec4 tileUniform[MAX_LIGHTS];
+	float farPlane[MAX_LIGHTS];
+	int staticTilesRedrawn = 0;
+	int shadowTilesRedrawn = 0;
+	int facesRendered = 0;
+};
@@ -0,0 +1,212 @@
+#include "profiler.h"
+#include <fstream>
+#include <stdio.h>
+
+std::atomic<profiler::threadBuffer*> profiler::threads[MAX_THREADS];
+std::atomic<int> profiler::threadCount(0);
+profiler::threadBuffer profiler::gpuEvents;
+long long profiler::gpuSyncNs = 0;
+long long profiler::gpuSyncTicks = 0;
+long long profiler::startTicks = 0;
+long long profiler::startNs = 0;
+double profiler::nsPerTick = 1.0;
+
+thread_local profiler::threadBuffer* profiler::localBuffer = nullptr;
+
+profiler::profiler()
+{
+
+}
+
+profiler::~profiler()
+{
+
+}
+
+static long long steadyNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// TSC rate from the run so far; steady_clock ticks convert exactly
+void profiler::calibrate()
+{
+#ifdef PROFILER_TSC
+	long long ticks = now();
+	long long ns = steadyNs();
+	if (startTicks == 0 || ticks <= startTicks)
+	{
+		startTicks = ticks;
+		startNs = ns;
+		return;
+	}
+	nsPerTick = (double)(ns - startNs) / (double)(ticks - startTicks);
+#endif
+}
+
+long long profiler::ticksToNs(long long ticks)
+{
+#ifdef PROFILER_TSC
+	return startNs + (long long)((ticks - startTicks) * nsPerTick);
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::duration(ticks)).count();
+#endif
+}
+
+long long profiler::eventNs(long long time, bool isGpu)
+{
+	return isGpu ? ticksToNs(gpuSyncTicks) + (time - gpuSyncNs) : ticksToNs(time);
+}
+
+// First zone on a thread: claim a slot.  Buffers are never freed, so
+// an exported trace still has the zones of threads that have exited.
+profiler::threadBuffer* profiler::registerThread()
+{
+	int index = threadCount.fetch_add(1);
+	if (index >= MAX_THREADS)
+		return nullptr;
+	// the first thread to record sets the TSC reference point
+	if (index == 0)
+		calibrate();
+	threadBuffer* buffer = new threadBuffer();
+	buffer->written.store(0);
+	buffer->threadId = index + 1;
+	buffer->name = nullptr;
+	threads[index].store(buffer, std::memory_order_release);
+	return buffer;
+}
+
+void profiler::record(const char* name, long long start, long long end)
+{
+	threadBuffer* buffer = localBuffer;
+	if (!buffer)
+	{
+		buffer = localBuffer = registerThread();
+		if (!buffer)
+			return;
+	}
+	unsigned int index = buffer->written.load(std::memory_order_relaxed);
+	zoneEvent& event = buffer->events[index % EVENTS_PER_THREAD];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	// publishes the event to an exporting thread
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void profiler::setThreadName(const char* name)
+{
+	if (!localBuffer)
+		localBuffer = registerThread();
+	if (localBuffer)
+		localBuffer->name = name;
+}
+
+void profiler::syncGpuClock(long long gpuNowNs)
+{
+	if (startTicks == 0)
+		calibrate();
+	gpuSyncNs = gpuNowNs;
+	gpuSyncTicks = now();
+}
+
+// GPU results are only read back on the GL thread
+void profiler::recordGpu(const char* name, long long gpuStartNs, long long gpuEndNs)
+{
+	unsigned int index = gpuEvents.written.load(std::memory_order_relaxed);
+	zoneEvent& event = gpuEvents.events[index % EVENTS_PER_THREAD];
+	event.name = name;
+	event.start = gpuStartNs;
+	event.end = gpuEndNs;
+	gpuEvents.written.store(index + 1, std::memory_order_release);
+}
+
+long long profiler::oldestStartNs(const threadBuffer& buffer, bool isGpu)
+{
+	unsigned int written = buffer.written.load(std::memory_order_acquire);
+	if (written == 0)
+		return -1;
+	return eventNs(buffer.events[written > EVENTS_PER_THREAD ? written % EVENTS_PER_THREAD : 0].start, isGpu);
+}
+
+static void writeName(std::ostream& out, const char* name)
+{
+	out << '"';
+	for (const char* c = name; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+			out << '\\';
+		out << *c;
+	}
+	out << '"';
+}
+
+// Complete ("X") events in microseconds from origin.  Zones a thread
+// writes while this runs may replace the oldest ones being read; those
+// few come out wrong, nothing else does.
+void profiler::writeEvents(std::ostream& out, const threadBuffer& buffer, const char* name, bool isGpu,
+						   long long origin, bool& first)
+{
+	unsigned int written = buffer.written.load(std::memory_order_acquire);
+	unsigned int begin = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+
+	out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.threadId
+		<< ",\"args\":{\"name\":";
+	writeName(out, name);
+	out << "}}";
+	first = false;
+	for (unsigned int i = begin; i < written; ++i)
+	{
+		const zoneEvent& event = buffer.events[i % EVENTS_PER_THREAD];
+		long long start = eventNs(event.start, isGpu);
+		long long end = eventNs(event.end, isGpu);
+		out << ",\n{\"name\":";
+		writeName(out, event.name);
+		out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.threadId
+			<< ",\"ts\":" << (start - origin) / 1000.0 << ",\"dur\":" << (end - start) / 1000.0 << "}";
+	}
+}
+
+bool profiler::exportChromeTrace(const char* path)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		printf("Profiler: could not open %s\n", path);
+		return false;
+	}
+	int count = threadCount.load();
+	if (count > MAX_THREADS)
+		count = MAX_THREADS;
+	gpuEvents.threadId = MAX_THREADS + 1;
+	calibrate();
+
+	// timestamps start at the oldest zone still in any ring
+	long long origin = oldestStartNs(gpuEvents, true);
+	for (int t = 0; t < count; ++t)
+	{
+		threadBuffer* buffer = threads[t].load(std::memory_order_acquire);
+		long long start = buffer ? oldestStartNs(*buffer, false) : -1;
+		if (start >= 0 && (origin < 0 || start < origin))
+			origin = start;
+	}
+	if (origin < 0)
+		origin = 0;
+
+	out.precision(15);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (int t = 0; t < count; ++t)
+	{
+		threadBuffer* buffer = threads[t].load(std::memory_order_acquire);
+		if (!buffer)
+			continue;
+		char fallback[32];
+		sprintf(fallback, "Thread %d", buffer->threadId);
+		writeEvents(out, *buffer, buffer->name ? buffer->name : fallback, false, origin, first);
+	}
+	writeEvents(out, gpuEvents, "GPU", true, origin, first);
+	out << "\n]}\n";
+	printf("Profiler: trace written to %s\n", path);
+	return true;
+}
@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////
+// CPU profiling zones.  PROFILE_ZONE("name") at the top of a block
+// records when the block was entered and left.  Every thread writes
+// into its own ring buffer, so recording takes no lock: two clock reads
+// and a store into memory only that thread touches.  Rings wrap, so the
+// last few seconds of a busy thread are kept.
+//
+// On x86 the clock is the time stamp counter, which reads in a few ns
+// where steady_clock can take tens; ticks are turned into time at
+// export, against steady_clock over the whole run.  Other targets use
+// steady_clock directly.
+//
+// exportChromeTrace writes everything currently in the rings as Chrome
+// trace event JSON (chrome://tracing, ui.perfetto.dev), one track per
+// thread plus a GPU track fed by the gpuTimer results, moved onto the
+// CPU clock with the offset measured by syncGpuClock.
+//
+// Names must outlive the export (string literals, pass names, ...).
+// Building with DISABLE_PROFILER removes every PROFILE_* macro.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_TSC
+#endif
+
+#if !defined(DISABLE_PROFILER)
+#define PROFILER_ENABLED
+#endif
+
+class profiler
+{
+public:
+	static const int MAX_THREADS = 64;
+	static const int EVENTS_PER_THREAD = 1 << 15;
+	// TSC or steady_clock ticks
+	static long long now()
+	{
+#ifdef PROFILER_TSC
+		return (long long)__rdtsc();
+#else
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+	static void record(const char* name, long long start, long long end);
+	static void setThreadName(const char* name);
+	// GPU timestamps (ns) are moved onto the CPU clock with the offset
+	// measured here, from a glGetInteger64v(GL_TIMESTAMP) taken right now
+	static void syncGpuClock(long long gpuNowNs);
+	static void recordGpu(const char* name, long long startNs, long long endNs);
+	static bool exportChromeTrace(const char* path);
+private:
+	struct zoneEvent
+	{
+		const char* name;
+		long long start;
+		long long end;
+	};
+	struct threadBuffer
+	{
+		zoneEvent events[EVENTS_PER_THREAD];
+		std::atomic<unsigned int> written;  // only ever incremented by the owner
+		int threadId;
+		const char* name;
+	};
+	profiler();
+	~profiler();
+	static threadBuffer* registerThread();
+	static void calibrate();
+	static long long ticksToNs(long long ticks);
+	static long long eventNs(long long time, bool isGpu);
+	static long long oldestStartNs(const threadBuffer& buffer, bool isGpu);
+	static void writeEvents(std::ostream& out, const threadBuffer& buffer, const char* name, bool isGpu,
+							long long origin, bool& first);
+	static std::atomic<threadBuffer*> threads[MAX_THREADS];
+	static std::atomic<int> threadCount;
+	static thread_local threadBuffer* localBuffer;
+	static threadBuffer gpuEvents;     // in GPU ns
+	static long long gpuSyncNs;        // GL_TIMESTAMP at gpuSyncTicks
+	static long long gpuSyncTicks;
+	// a tick/steady_clock pair from startup and one from the last export
+	static long long startTicks, startNs;
+	static double nsPerTick;
+};
+
+// Records the enclosing scope as a zone.
+class profileZone
+{
+public:
+	explicit profileZone(const char* zoneName) : name(zoneName), start(profiler::now()) {}
+	~profileZone() { profiler::record(name, start, profiler::now()); }
+private:
+	const char* name;
+	long long start;
+};
+
+#ifdef PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) profileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) profiler::setThreadName(name)
+#define PROFILE_SYNC_GPU_CLOCK(gpuNowNs) profiler::syncGpuClock(gpuNowNs)
+#define PROFILE_GPU_ZONE(name, startNs, endNs) profiler::recordGpu(name, startNs, endNs)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#define PROFILE_SYNC_GPU_CLOCK(gpuNowNs) ((void)0)
+#define PROFILE_GPU_ZONE(name, startNs, endNs) ((void)0)
+#endif
@@ -0,0 +1,299 @@
+#include "renderGraph.h"
+#include "glDebug.h"
+#include "profiler.h"
+#include "GL/glew.h"
+#include <stdio.h>
+
+renderGraph::renderGraph()
+{
+
+}
+
+renderGraph::~renderGraph()
+{
+
+}
+
+int renderGraph::addResource(const char* name, lifetimeFunction acquire, lifetimeFunction release)
+{
+	if ((int)resources.size() >= MAX_RESOURCES)
+	{
+		printf("Render graph: too many resources, %s ignored\n", name);
+		return -1;
+	}
+	graphResource resource;
+	resource.name = name;
+	resource.acquire = acquire;
+	resource.release = release;
+	resources.push_back(resource);
+	dirty = true;
+	return (int)resources.size() - 1;
+}
+
+void renderGraph::markOutput(int resource)
+{
+	resources[resource].isOutput = true;
+	dirty = true;
+}
+
+int renderGraph::addPass(const char* name, executeFunction execute)
+{
+	if ((int)passes.size() >= MAX_PASSES)
+	{
+		printf("Render graph: too many passes, %s ignored\n", name);
+		return -1;
+	}
+	graphPass pass;
+	pass.name = name;
+	pass.execute = execute;
+	passes.push_back(pass);
+	passes.back().timer.initialize();
+	passes.back().timer.setName(name);
+	dirty = true;
+	return (int)passes.size() - 1;
+}
+
+void renderGraph::read(int pass, int resource, eAccess access)
+{
+	resourceAccess use = { resource, access, 0 };
+	passes[pass].reads.push_back(use);
+	dirty = true;
+}
+
+void renderGraph::write(int pass, int resource, eAccess access, unsigned int clearMask)
+{
+	resourceAccess use = { resource, access, clearMask };
+	passes[pass].writes.push_back(use);
+	dirty = true;
+}
+
+void renderGraph::setEnabled(int pass, bool enabled)
+{
+	if (passes[pass].enabled != enabled)
+	{
+		passes[pass].enabled = enabled;
+		dirty = true;
+	}
+}
+
+int renderGraph::getPassCount()
+{
+	return (int)passes.size();
+}
+
+const char* renderGraph::getPassName(int pass)
+{
+	return passes[pass].name;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Topological sort over the declared reads and writes.  Among the
+// passes that are ready the one declared first goes next, so a graph
+// declared in a sensible order runs in that order.
+void renderGraph::sortPasses()
+{
+	int passCount = (int)passes.size();
+	unsigned int dependsOn[MAX_PASSES] = {};
+	for (int r = 0; r < (int)resources.size(); ++r)
+	{
+		unsigned int writers = 0;
+		int lastWriter = -1;
+		for (int p = 0; p < passCount; ++p)
+		{
+			for (const resourceAccess& use : passes[p].writes)
+			{
+				if (use.resource != r)
+					continue;
+				if (lastWriter >= 0 && lastWriter != p)
+					dependsOn[p] |= 1u << lastWriter;
+				writers |= 1u << p;
+				lastWriter = p;
+			}
+		}
+		for (int p = 0; p < passCount; ++p)
+		{
+			for (const resourceAccess& use : passes[p].reads)
+			{
+				if (use.resource == r)
+					dependsOn[p] |= writers & ~(1u << p);
+			}
+		}
+	}
+
+	unsigned int scheduled = 0;
+	for (int i = 0; i < passCount; ++i)
+	{
+		int next = -1;
+		for (int p = 0; p < passCount && next < 0; ++p)
+		{
+			if (!(scheduled & (1u << p)) && (dependsOn[p] & ~scheduled) == 0)
+				next = p;
+		}
+		if (next < 0)
+		{
+			printf("Render graph: dependency cycle, falling back to declaration order\n");
+			for (int p = 0; p < passCount; ++p)
+				order[p] = p;
+			return;
+		}
+		order[i] = next;
+		scheduled |= 1u << next;
+	}
+}
+
+void renderGraph::compile()
+{
+	sortPasses();
+	int passCount = (int)passes.size();
+	int resourceCount = (int)resources.size();
+
+	// walk back from the outputs; a pass only runs if something
+	// downstream needs one of the resources it writes
+	bool needed[MAX_RESOURCES];
+	for (int r = 0; r < resourceCount; ++r)
+		needed[r] = resources[r].isOutput;
+	for (int i = passCount - 1; i >= 0; --i)
+	{
+		graphPass& pass = passes[order[i]];
+		pass.live = false;
+		if (!pass.enabled)
+			continue;
+		for (const resourceAccess& use : pass.writes)
+			pass.live = pass.live || needed[use.resource];
+		if (!pass.live)
+			continue;
+		for (const resourceAccess& use : pass.reads)
+			needed[use.resource] = true;
+	}
+
+	// clears go to the first live writer; barriers are put in front of
+	// the first read of something last written outside the framebuffer
+	unsigned int clearBits[MAX_RESOURCES] = {};
+	int firstWriter[MAX_RESOURCES];
+	eAccess lastWrite[MAX_RESOURCES];
+	unsigned int visibleBits[MAX_RESOURCES] = {};
+	int firstUse[MAX_RESOURCES];
+	int lastUse[MAX_RESOURCES];
+	for (int r = 0; r < resourceCount; ++r)
+	{
+		firstWriter[r] = -1;
+		lastWrite[r] = RENDER_TARGET;
+		firstUse[r] = -1;
+		lastUse[r] = -1;
+	}
+	clearsMerged = 0;
+	barriersInserted = 0;
+	for (int i = 0; i < passCount; ++i)
+	{
+		graphPass& pass = passes[order[i]];
+		pass.clearMask = 0;
+		pass.barrierBits = 0;
+		pass.acquireMask = 0;
+		pass.releaseMask = 0;
+		if (!pass.live)
+			continue;
+
+		for (const resourceAccess& use : pass.reads)
+		{
+			int r = use.resource;
+			if (lastWrite[r] == IMAGE || lastWrite[r] == STORAGE_BUFFER)
+			{
+				unsigned int bits = 0;
+				switch (use.access)
+				{
+				case TEXTURE:        bits = GL_TEXTURE_FETCH_BARRIER_BIT; break;
+				case IMAGE:          bits = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT; break;
+				case STORAGE_BUFFER: bits = GL_SHADER_STORAGE_BARRIER_BIT; break;
+				default:             bits = GL_FRAMEBUFFER_BARRIER_BIT; break;
+				}
+				if (bits & ~visibleBits[r])
+				{
+					pass.barrierBits |= bits;
+					visibleBits[r] |= bits;
+				}
+			}
+			if (firstUse[r] < 0)
+				firstUse[r] = i;
+			lastUse[r] = i;
+		}
+		for (const resourceAccess& use : pass.writes)
+		{
+			int r = use.resource;
+			if (firstWriter[r] < 0)
+			{
+				firstWriter[r] = order[i];
+			}
+			else if (use.clearMask)
+			{
+				++clearsMerged;
+			}
+			clearBits[r] |= use.clearMask;
+			lastWrite[r] = use.access;
+			visibleBits[r] = 0;
+			if (firstUse[r] < 0)
+				firstUse[r] = i;
+			lastUse[r] = i;
+		}
+	}
+	for (int r = 0; r < resourceCount; ++r)
+	{
+		if (firstWriter[r] >= 0)
+			passes[firstWriter[r]].clearMask |= clearBits[r];
+		if (firstUse[r] >= 0)
+		{
+			passes[order[firstUse[r]]].acquireMask |= 1u << r;
+			passes[order[lastUse[r]]].releaseMask |= 1u << r;
+		}
+	}
+	for (int p = 0; p < passCount; ++p)
+	{
+		if (passes[p].barrierBits)
+			++barriersInserted;
+	}
+	dirty = false;
+}
+
+void renderGraph::execute(renderGraphParam& stats)
+{
+	PROFILE_ZONE("renderGraph::execute");
+	if (dirty)
+		compile();
+
+	stats.passesExecuted = 0;
+	stats.passesCulled = 0;
+	for (int i = 0; i < (int)passes.size(); ++i)
+	{
+		int p = order[i];
+		graphPass& pass = passes[p];
+		if (!pass.live)
+		{
+			++stats.passesCulled;
+			stats.passTiming[p].lastMs = 0.f;
+			continue;
+		}
+		for (int r = 0; r < (int)resources.size(); ++r)
+		{
+			if ((pass.acquireMask & (1u << r)) && resources[r].acquire)
+				resources[r].acquire();
+		}
+		if (pass.barrierBits)
+			glMemoryBarrier(pass.barrierBits);
+
+		PROFILE_ZONE(pass.name);
+		GL_DEBUG_PUSH_GROUP(pass.name);
+		pass.timer.begin();
+		pass.execute(pass.clearMask);
+		pass.timer.end();
+		GL_DEBUG_POP_GROUP();
+		pass.timer.summarize(stats.passTiming[p]);
+
+		for (int r = 0; r < (int)resources.size(); ++r)
+		{
+			if ((pass.releaseMask & (1u << r)) && resources[r].release)
+				resources[r].release();
+		}
+		++stats.passesExecuted;
+	}
+	stats.clearsMerged = clearsMerged;
+	stats.barriers = barriersInserted;
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+// Frame organised as a graph of render passes.  Each pass declares the
+// resources (render targets, shadow maps, the back buffer) it reads and
+// writes, and from that the graph works out:
+//   * the execution order: a reader runs after every writer of what it
+//     reads, writers of the same resource keep their declaration order,
+//   * which passes to skip: disabled passes, and passes whose results
+//     are never read on the way to an output resource,
+//   * clears: every clear asked for on a resource is done once, by the
+//     first pass that writes it,
+//   * the memory barriers needed between a pass writing through image
+//     stores or storage buffers and a later pass reading the result
+//     (render target and blit writes are ordered by GL itself),
+//   * transient lifetimes: a resource's acquire callback runs right
+//     before its first user and release right after its last one.
+// Each pass that runs is timed on the GPU, see renderGraphParam.
+//
+// The graph is built once; per frame only the enabled flags change,
+// and it is only recompiled when one of them does.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "gpuTimer.h"
+
+struct renderGraphParam;
+
+class renderGraph
+{
+public:
+	enum eAccess
+	{
+		RENDER_TARGET,      // framebuffer attachment
+		TEXTURE,            // sampled in a shader
+		BLIT,               // glBlitFramebuffer / glCopyImageSubData
+		IMAGE,              // image load/store
+		STORAGE_BUFFER
+	};
+	static const int MAX_PASSES = 32;
+	static const int MAX_RESOURCES = 32;
+	// called with the clear bits the pass has to apply to its target
+	typedef std::function<void(unsigned int clearMask)> executeFunction;
+	typedef std::function<void()> lifetimeFunction;
+
+	renderGraph();
+	~renderGraph();
+	int addResource(const char* name, lifetimeFunction acquire = lifetimeFunction(),
+					lifetimeFunction release = lifetimeFunction());
+	void markOutput(int resource);
+	int addPass(const char* name, executeFunction execute);
+	void read(int pass, int resource, eAccess access = TEXTURE);
+	void write(int pass, int resource, eAccess access = RENDER_TARGET, unsigned int clearMask = 0);
+	void setEnabled(int pass, bool enabled);
+	void execute(renderGraphParam& stats);
+	int getPassCount();
+	const char* getPassName(int pass);
+private:
+	struct resourceAccess
+	{
+		int resource;
+		eAccess access;
+		unsigned int clearMask;
+	};
+	struct graphResource
+	{
+		const char* name;
+		lifetimeFunction acquire;
+		lifetimeFunction release;
+		bool isOutput = false;
+	};
+	struct graphPass
+	{
+		const char* name;
+		executeFunction execute;
+		std::vector<resourceAccess> reads;
+		std::vector<resourceAccess> writes;
+		bool enabled = true;
+		gpuTimer timer;
+		// filled in by compile
+		bool live = false;
+		unsigned int clearMask = 0;
+		unsigned int barrierBits = 0;
+		unsigned int acquireMask = 0;   // resources, by bit
+		unsigned int releaseMask = 0;
+	};
+	void compile();
+	void sortPasses();
+	std::vector<graphResource> resources;
+	std::vector<graphPass> passes;
+	int order[MAX_PASSES];
+	bool dirty = true;
+	int clearsMerged = 0;
+	int barriersInserted = 0;
+};
+
+struct renderGraphParam
+{
+	int passesExecuted = 0;         // last frame
+	int passesCulled = 0;
+	int clearsMerged = 0;           // clear requests folded into another pass's clear
+	int barriers = 0;
+	// per pass, by declaration index; lastMs is 0 for a culled pass
+	timingSummary passTiming[renderGraph::MAX_PASSES];
+};
@@ -0,0 +1,94 @@
+#include "renderTargetPool.h"
+
+renderTargetPool::renderTargetPool()
+{
+
+}
+
+renderTargetPool::~renderTargetPool()
+{
+
+}
+
+void renderTargetPool::beginFrame()
+{
+	++frameIndex;
+	allocationsThisFrame = 0;
+	for (auto it = entries.begin(); it != entries.end();)
+	{
+		if (!it->inUse && frameIndex - it->lastUsedFrame > maxIdleFrames)
+		{
+			allocatedBytes -= it->bytes;
+			it->target.Release();
+			it = entries.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	// targets held across frames count from the start
+	peakInUseBytes = inUseBytes;
+}
+
+void renderTargetPool::endFrame(renderTargetPoolParam& stats)
+{
+	stats.targetsAllocated = (int)entries.size();
+	stats.allocationsLastFrame = allocationsThisFrame;
+	stats.allocatedMB = allocatedBytes / (1024.f * 1024.f);
+	stats.peakInUseMB = peakInUseBytes / (1024.f * 1024.f);
+}
+
+FBO* renderTargetPool::acquire(const fboDesc& desc)
+{
+	poolEntry* found = nullptr;
+	for (auto& entry : entries)
+	{
+		if (!entry.inUse && entry.target.getDesc() == desc)
+		{
+			found = &entry;
+			break;
+		}
+	}
+
+	if (!found)
+	{
+		entries.push_back(poolEntry());
+		found = &entries.back();
+		found->target.Create(desc);
+		found->bytes = found->target.getSizeInBytes();
+		allocatedBytes += found->bytes;
+		++allocationsThisFrame;
+	}
+
+	found->inUse = true;
+	found->lastUsedFrame = frameIndex;
+	inUseBytes += found->bytes;
+	if (inUseBytes > peakInUseBytes)
+		peakInUseBytes = inUseBytes;
+	return &found->target;
+}
+
+void renderTargetPool::release(FBO* target)
+{
+	for (auto& entry : entries)
+	{
+		if (&entry.target == target && entry.inUse)
+		{
+			entry.inUse = false;
+			entry.lastUsedFrame = frameIndex;
+			inUseBytes -= entry.bytes;
+			return;
+		}
+	}
+}
+
+void renderTargetPool::clear()
+{
+	for (auto& entry : entries)
+		entry.target.Release();
+	entries.clear();
+	allocatedBytes = 0;
+	inUseBytes = 0;
+	peakInUseBytes = 0;
+}
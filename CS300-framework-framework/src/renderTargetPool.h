@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////
+// Hands out FBOs by descriptor (formats, size, samples, ...).  A
+// target is acquired for as long as it is needed and released back to
+// the pool; the next acquire with the same descriptor, later in the
+// frame or in a following frame, gets the same target back instead of
+// a new allocation.  Two transient targets whose lifetimes within a
+// frame do not overlap therefore share the same video memory.
+//
+// Targets nobody acquired for a few frames (for example the G buffer
+// at the old size after a resize) are freed at the start of a frame.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <list>
+#include "fbo.h"
+
+struct renderTargetPoolParam
+{
+	int targetsAllocated = 0;
+	int allocationsLastFrame = 0;
+	float allocatedMB = 0.f;        // everything the pool holds
+	float peakInUseMB = 0.f;        // most held at once during the last frame
+};
+
+class renderTargetPool
+{
+public:
+	renderTargetPool();
+	~renderTargetPool();
+	void beginFrame();
+	void endFrame(renderTargetPoolParam& stats);
+	FBO* acquire(const fboDesc& desc);
+	void release(FBO* target);
+	void clear();
+private:
+	struct poolEntry
+	{
+		FBO target;
+		size_t bytes = 0;
+		bool inUse = false;
+		unsigned int lastUsedFrame = 0;
+	};
+	std::list<poolEntry> entries;
+	unsigned int frameIndex = 0;
+	size_t allocatedBytes = 0;
+	size_t inUseBytes = 0;
+	size_t peakInUseBytes = 0;
+	int allocationsThisFrame = 0;
+	const unsigned int maxIdleFrames = 3;
+};
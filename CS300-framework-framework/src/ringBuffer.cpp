@@ -0,0 +1,151 @@
+#include "ringBuffer.h"
+#include "glDebug.h"
+#include "GL/glew.h"
+#include <chrono>
+#include <stdio.h>
+
+ringBuffer::ringBuffer()
+{
+
+}
+
+ringBuffer::~ringBuffer()
+{
+
+}
+
+void ringBuffer::initialize(size_t bytesPerFrame)
+{
+	int uniformAlignment = 0, storageAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+	alignment = (size_t)(uniformAlignment > storageAlignment ? uniformAlignment : storageAlignment);
+	if (alignment == 0)
+		alignment = 256;
+	regionSize = (bytesPerFrame + alignment - 1) / alignment * alignment;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, regionSize * MAX_FRAMES_IN_FLIGHT, nullptr, flags);
+	GL_DEBUG_LABEL(GL_BUFFER, buffer, "Frame Data Ring");
+	mapped = (unsigned char*)glMapNamedBufferRange(buffer, 0, regionSize * MAX_FRAMES_IN_FLIGHT, flags);
+	if (!mapped)
+		printf("Ring buffer: could not map %d bytes\n", (int)(regionSize * MAX_FRAMES_IN_FLIGHT));
+	head = 0;
+	frameIndex = 0;
+	region = 0;
+}
+
+void ringBuffer::release()
+{
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		if (fences[i])
+			glDeleteSync((GLsync)fences[i]);
+		fences[i] = nullptr;
+	}
+	if (buffer)
+	{
+		glUnmapNamedBuffer(buffer);
+		glDeleteBuffers(1, &buffer);
+	}
+	buffer = 0;
+	mapped = nullptr;
+}
+
+void ringBuffer::reserve(size_t bytesPerFrame)
+{
+	if (bytesPerFrame <= regionSize)
+		return;
+	// the old buffer may still be read by the frames in flight
+	glFinish();
+	size_t grown = regionSize * 2;
+	release();
+	initialize(bytesPerFrame > grown ? bytesPerFrame : grown);
+	overflowReported = false;
+}
+
+void ringBuffer::waitForFrame(int frame, ringBufferParam& stats)
+{
+	if (frame < 0)
+		return;
+	int slot = frame % MAX_FRAMES_IN_FLIGHT;
+	GLsync fence = (GLsync)fences[slot];
+	if (!fence)
+		return;
+
+	// only time it when the GPU is actually behind
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		auto start = std::chrono::steady_clock::now();
+		const GLuint64 oneMs = 1000000;
+		do
+		{
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, oneMs);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		float waitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		stats.fenceWaitMs += waitMs;
+		stats.totalFenceWaitMs += waitMs;
+		++stats.fenceWaits;
+	}
+	glDeleteSync(fence);
+	fences[slot] = nullptr;
+}
+
+void ringBuffer::beginFrame(ringBufferParam& stats)
+{
+	stats.bytesUsed = (int)head;
+	stats.fenceWaitMs = 0.f;
+	if (stats.framesInFlight < 1)
+		stats.framesInFlight = 1;
+	if (stats.framesInFlight > MAX_FRAMES_IN_FLIGHT)
+		stats.framesInFlight = MAX_FRAMES_IN_FLIGHT;
+
+	++frameIndex;
+	region = frameIndex % MAX_FRAMES_IN_FLIGHT;
+	head = 0;
+
+	// the frame framesInFlight back (and everything older, including
+	// the last user of this region) must be done on the GPU
+	for (int back = MAX_FRAMES_IN_FLIGHT; back >= stats.framesInFlight; --back)
+		waitForFrame(frameIndex - back, stats);
+}
+
+void ringBuffer::endFrame()
+{
+	int slot = frameIndex % MAX_FRAMES_IN_FLIGHT;
+	if (fences[slot])
+		glDeleteSync((GLsync)fences[slot]);
+	fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* ringBuffer::allocate(size_t size, size_t& offset)
+{
+	size_t start = (head + alignment - 1) / alignment * alignment;
+	if (!mapped || start + size > regionSize)
+	{
+		if (!overflowReported)
+			printf("Ring buffer: out of space for this frame (%d bytes per frame)\n", (int)regionSize);
+		overflowReported = true;
+		return nullptr;
+	}
+	head = start + size;
+	offset = region * regionSize + start;
+	return mapped + offset;
+}
+
+void ringBuffer::bindRange(unsigned int target, unsigned int index, size_t offset, size_t size)
+{
+	glBindBufferRange(target, index, buffer, offset, size);
+}
+
+unsigned int ringBuffer::getBuffer()
+{
+	return buffer;
+}
+
+size_t ringBuffer::getAlignment()
+{
+	return alignment;
+}
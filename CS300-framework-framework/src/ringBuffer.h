@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////
+// Streams per-frame data (light blocks, frame constants, ...) to the
+// GPU without glBufferData orphaning or a glUniform call per value.
+// One buffer is created with glNamedBufferStorage and kept persistently
+// mapped; it is split into one region per frame in flight and the CPU
+// writes a frame's data straight into that frame's region.  Ranges are
+// bound with glBindBufferRange.
+//
+// A fence is inserted at the end of every frame.  Before a region is
+// written again, the frame that last used it has to be done on the
+// GPU; framesInFlight (1 up to MAX_FRAMES_IN_FLIGHT) lowers how far
+// the CPU may run ahead.  Time spent waiting on fences is reported.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>
+
+struct ringBufferParam
+{
+	int framesInFlight = 3;
+	int bytesUsed = 0;              // last frame
+	int fenceWaits = 0;             // frames that had to wait so far
+	float fenceWaitMs = 0.f;        // last frame
+	float totalFenceWaitMs = 0.f;
+};
+
+class ringBuffer
+{
+public:
+	static const int MAX_FRAMES_IN_FLIGHT = 3;
+	ringBuffer();
+	~ringBuffer();
+	void initialize(size_t bytesPerFrame);
+	void release();
+	// Grows the regions to at least bytesPerFrame; waits for the GPU
+	// when it does.  Call before beginFrame.
+	void reserve(size_t bytesPerFrame);
+	void beginFrame(ringBufferParam& stats);
+	void endFrame();
+	// returns where to write size bytes this frame, nullptr when full
+	void* allocate(size_t size, size_t& offset);
+	void bindRange(unsigned int target, unsigned int index, size_t offset, size_t size);
+	unsigned int getBuffer();
+	size_t getAlignment();
+private:
+	void waitForFrame(int frame, ringBufferParam& stats);
+	unsigned int buffer = 0;
+	unsigned char* mapped = nullptr;
+	size_t regionSize = 0;
+	size_t alignment = 256;
+	size_t head = 0;                // next free byte in the current region
+	int region = 0;
+	// fences of the last frames, indexed by frame % MAX_FRAMES_IN_FLIGHT
+	void* fences[MAX_FRAMES_IN_FLIGHT] = {};
+	int frameIndex = 0;
+	bool overflowReported = false;
+};
@@ -0,0 +1,70 @@
+#include "rollingStats.h"
+#include <algorithm>
+
+rollingStats::rollingStats()
+{
+
+}
+
+rollingStats::~rollingStats()
+{
+
+}
+
+void rollingStats::initialize(int windowSize)
+{
+	samples.assign(windowSize > 0 ? windowSize : 1, 0.f);
+	sorted.reserve(samples.size());
+	next = 0;
+	count = 0;
+	last = 0.f;
+}
+
+void rollingStats::add(float sample)
+{
+	if (samples.empty())
+		initialize(120);
+	samples[next] = sample;
+	next = (next + 1) % (int)samples.size();
+	if (count < (int)samples.size())
+		++count;
+	last = sample;
+}
+
+void rollingStats::summarize(timingSummary& summary)
+{
+	summary.lastMs = last;
+	if (count == 0)
+	{
+		summary.meanMs = summary.minMs = summary.maxMs = summary.p50Ms = summary.p95Ms = summary.p99Ms = 0.f;
+		return;
+	}
+	// the window is either full or filled from the front; a copied
+	// rollingStats lost the reserve made by initialize
+	sorted.reserve(samples.size());
+	sorted.assign(samples.begin(), samples.begin() + count);
+	std::sort(sorted.begin(), sorted.end());
+	float sum = 0.f;
+	for (float sample : sorted)
+		sum += sample;
+	summary.meanMs = sum / count;
+	summary.minMs = sorted.front();
+	summary.maxMs = sorted.back();
+	// nearest rank
+	summary.p50Ms = sorted[(count * 50 + 99) / 100 - 1];
+	summary.p95Ms = sorted[(count * 95 + 99) / 100 - 1];
+	summary.p99Ms = sorted[(count * 99 + 99) / 100 - 1];
+}
+
+int rollingStats::getCount()
+{
+	return count;
+}
+
+void rollingStats::getSamples(std::vector<float>& oldestFirst)
+{
+	oldestFirst.clear();
+	int start = count < (int)samples.size() ? 0 : next;
+	for (int i = 0; i < count; ++i)
+		oldestFirst.push_back(samples[(start + i) % samples.size()]);
+}
@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////////////////////////
+// Summary of the last N samples of a timing: mean, min, max and the
+// 50th, 95th and 99th percentiles over a fixed size window, plus the
+// latest sample.  Old
+// samples fall out of the window as new ones come in, so a hitch shows
+// up for a while and then ages out.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <vector>
+
+struct timingSummary
+{
+	float lastMs = 0.f;
+	float meanMs = 0.f;
+	float minMs = 0.f;
+	float maxMs = 0.f;
+	float p50Ms = 0.f;
+	float p95Ms = 0.f;
+	float p99Ms = 0.f;
+};
+
+class rollingStats
+{
+public:
+	rollingStats();
+	~rollingStats();
+	void initialize(int windowSize);
+	void add(float sample);
+	void summarize(timingSummary& summary);
+	int getCount();
+	void getSamples(std::vector<float>& oldestFirst);
+private:
+	std::vector<float> samples;
+	std::vector<float> sorted;      // scratch for the percentile
+	int next = 0;
+	int count = 0;
+	float last = 0.f;
+};
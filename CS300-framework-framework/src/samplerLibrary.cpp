@@ -0,0 +1,61 @@
+#include "samplerLibrary.h"
+#include "glState.h"
+#include "glDebug.h"
+#include "GL/glew.h"
+
+unsigned int samplerLibrary::samplers[SAMPLER_COUNT];
+
+samplerLibrary::samplerLibrary()
+{
+
+}
+
+samplerLibrary::~samplerLibrary()
+{
+
+}
+
+static void setFilterAndWrap(unsigned int sampler, int minFilter, int magFilter, int wrap)
+{
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, wrap);
+}
+
+void samplerLibrary::initialize()
+{
+	glCreateSamplers(SAMPLER_COUNT, samplers);
+	setFilterAndWrap(samplers[MATERIAL], GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT);
+	setFilterAndWrap(samplers[CLAMPED_LINEAR], GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE);
+	setFilterAndWrap(samplers[POINT], GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE);
+
+	setFilterAndWrap(samplers[SHADOW_COMPARE], GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_BORDER);
+	float border[] = { 1.f, 1.f, 1.f, 1.f };
+	glSamplerParameterfv(samplers[SHADOW_COMPARE], GL_TEXTURE_BORDER_COLOR, border);
+	glSamplerParameteri(samplers[SHADOW_COMPARE], GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glSamplerParameteri(samplers[SHADOW_COMPARE], GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+	GL_DEBUG_LABEL(GL_SAMPLER, samplers[MATERIAL], "Material");
+	GL_DEBUG_LABEL(GL_SAMPLER, samplers[CLAMPED_LINEAR], "Clamped Linear");
+	GL_DEBUG_LABEL(GL_SAMPLER, samplers[POINT], "Point");
+	GL_DEBUG_LABEL(GL_SAMPLER, samplers[SHADOW_COMPARE], "Shadow Compare");
+}
+
+void samplerLibrary::release()
+{
+	glDeleteSamplers(SAMPLER_COUNT, samplers);
+	for (int i = 0; i < SAMPLER_COUNT; ++i)
+		samplers[i] = 0;
+}
+
+unsigned int samplerLibrary::get(eSampler sampler)
+{
+	return samplers[sampler];
+}
+
+void samplerLibrary::bind(unsigned int unit, eSampler sampler)
+{
+	glState::bindSampler(unit, samplers[sampler]);
+}
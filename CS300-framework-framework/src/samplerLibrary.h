@@ -0,0 +1,29 @@
+///////////////////////////////////////////////////////////////////////
+// The few ways the renderer samples a texture, as shared sampler
+// objects.  Textures and render targets only own their storage; the
+// sampler bound next to them on a unit decides filtering, wrapping
+// and depth compare, so one render target can be read point sampled
+// in one pass and filtered in another.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+class samplerLibrary
+{
+public:
+	enum eSampler
+	{
+		MATERIAL,           // trilinear, repeat
+		CLAMPED_LINEAR,     // bilinear, clamp to edge (skybox)
+		POINT,              // nearest, clamp to edge (G buffer reads)
+		SHADOW_COMPARE,     // sampler*Shadow, border of 1 i.e. "lit"
+		SAMPLER_COUNT
+	};
+	static void initialize();
+	static void release();
+	static unsigned int get(eSampler sampler);
+	static void bind(unsigned int unit, eSampler sampler);
+private:
+	samplerLibrary();
+	~samplerLibrary();
+	static unsigned int samplers[SAMPLER_COUNT];
+};
@@ -19,26 +19,30 @@
 #include "models.h"
 #include "globals.h"
 #include "timer.h"
+#include "glState.h"
+#include "samplerLibrary.h"
+#include "glDebug.h"
+#include "profiler.h"
+#include "frameArena.h"
 
 #include "math.h"
 #include <fstream>
+#include <chrono>
 #include <stdlib.h>
+#include <algorithm>
+#include <mutex>
 
 #include "SOIL.h"
 
-#include "GL\glew.h"
-#include <GL/freeglut.h>
-#include "glm\ext.hpp"
-#include "glm\gtc\matrix_inverse.hpp"
+#include "GL/glew.h"
+#include "glm/ext.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
 
 
 ////////////////////////////////////////////////////////////////////////
-// This macro make sit easy to sprinkle checkd for OpenGL errors
-// throught your code.  Most OpenGL calls can record errors, and a
-// careful programmer will check the error status *often*, perhaps as
-// often as after each OpenGL call.  At the very least, once per
-// refresh will tell you if something is going wrong.
-#define CHECKERROR {int err = glGetError(); if (err) { fprintf(stderr, "OpenGL error (at line %d): %s\n", __LINE__, gluErrorString(err)); exit(-1);} }
+// OpenGL errors are reported by the debug output callback (see
+// glDebug) in debug builds, rather than by polling glGetError, which
+// stalls the pipeline every time it is called.
 
 
 float ambientColor[3] = {0.5f, 0.5f, 0.5f};
@@ -54,121 +58,191 @@ const float PI = 3.14159f;
 const float rad = PI/180.0f;
 meshData boxMesh, sphereMesh, groundMesh, quadMesh;
 
-void setUPGBuffer(Scene &scene)
+// the frame ring's share for everything but the object constants
+static const size_t FRAME_DATA_BYTES = 64 * 1024;
+// fewer draws than this are not worth a job of their own
+static const int MIN_DRAWS_PER_LIST = 64;
+// the most a draw records: constants, two textures and samplers, mesh, draw
+static const int COMMANDS_PER_DRAW = 7;
+
+// one object's range, placed where a uniform range may start
+static size_t getObjectConstantsStride(Scene &scene)
 {
-	int width = (int)global::gWidth;
-	int height = (int)global::gHeight;
-	// bind FBO for G buffer
-	glGenFramebuffers(1, &scene.gBufferData.gBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, scene.gBufferData.gBuffer);
-	CHECKERROR;
-	// position texture buffer
-	glGenTextures(1, &scene.gBufferData.gPositionTexture);
-	glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gPositionTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, scene.gBufferData.gPositionTexture, 0);
-	CHECKERROR;
-	// Normal texture buffer
-	glGenTextures(1, &scene.gBufferData.gNormalTexture);
-	glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gNormalTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, scene.gBufferData.gNormalTexture, 0);
-	CHECKERROR;
-	// albedo buffer
-	glGenTextures(1, &scene.gBufferData.gAlbedoTexture);
-	glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gAlbedoTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, scene.gBufferData.gAlbedoTexture, 0);
-	CHECKERROR;
-	// specular buffer
-	glGenTextures(1, &scene.gBufferData.gSpecularTexture);
-	glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gSpecularTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, scene.gBufferData.gSpecularTexture, 0);
-	CHECKERROR;
-	unsigned int colorAttachment[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
-	glDrawBuffers(4, colorAttachment);
-	CHECKERROR;
-	// depth buffer
-	glGenRenderbuffers(1, &scene.gBufferData.gDepthTexure);
-	glBindRenderbuffer(GL_RENDERBUFFER, scene.gBufferData.gDepthTexure);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, scene.gBufferData.gDepthTexure);
-	CHECKERROR;
-	int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (status != GL_FRAMEBUFFER_COMPLETE)
-		printf("FBO Error: %d\n", status);
-	CHECKERROR;
+	size_t alignment = scene.frameDataRing.getAlignment();
+	return (sizeof(objectConstants) + alignment - 1) / alignment * alignment;
 }
 
-unsigned int loadCube(const std::vector<const char*> &facePath)
+////////////////////////////////////////////////////////////////////////
+// The G buffer is acquired from the render target pool for the frame
+// and released once its last reader is done.  The pool hands the same
+// target back every frame until the size or layout changes.
+void setUPGBuffer(Scene &scene)
 {
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-	glActiveTexture(GL_TEXTURE0);
-
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-	for (unsigned int i = 0; i < facePath.size(); ++i)
+	dsGBufferParam &gBuffer = scene.gBufferData;
+	bool changed = gBuffer.width != scene.width || gBuffer.height != scene.height ||
+				   gBuffer.isCompact != scene.compactGBuffer;
+	gBuffer.width = scene.width;
+	gBuffer.height = scene.height;
+	gBuffer.isCompact = scene.compactGBuffer;
+
+	fboDesc &desc = gBuffer.desc;
+	if (changed)
+	{
+		desc.width = scene.width;
+		desc.height = scene.height;
+		desc.depthFormat = GL_DEPTH_COMPONENT24;
+		if (gBuffer.isCompact)
+		{
+			// octahedral normal, albedo, specular + shininess; depth is sampled
+			// by the lighting pass to rebuild the position
+			desc.colorFormats = { GL_RG16F, GL_RGBA8, GL_RGBA8 };
+			desc.sampleDepth = true;
+		}
+		else
+		{
+			// position, normal, albedo, specular + shininess
+			desc.colorFormats = { GL_RGB16F, GL_RGB16F, GL_RGB16F, GL_RGBA8 };
+			desc.sampleDepth = false;
+		}
+	}
+	gBuffer.target = scene.mRenderTargetPool.acquire(desc);
+	GL_DEBUG_LABEL(GL_FRAMEBUFFER, gBuffer.target->getFBO(), "G Buffer");
+
+	FBO &target = *gBuffer.target;
+	gBuffer.gBuffer = target.getFBO();
+	int attachment = 0;
+	gBuffer.gPositionTexture = gBuffer.isCompact ? 0 : target.getColorTexture(attachment++);
+	gBuffer.gNormalTexture = target.getColorTexture(attachment++);
+	gBuffer.gAlbedoTexture = target.getColorTexture(attachment++);
+	gBuffer.gSpecularTexture = target.getColorTexture(attachment++);
+	gBuffer.gDepthTexure = target.getDepthTexture();
+	gBuffer.bytesPerPixel = target.getBytesPerPixel();
+	gBuffer.lightingBytesPerPixel = gBuffer.isCompact ? target.getBytesPerPixel() : target.getColorBytesPerPixel();
+	if (changed)
 	{
-		int width, height, channel;
-		unsigned char *image = SOIL_load_image(facePath[i], &width, &height, &channel, SOIL_LOAD_RGBA);
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+		printf("G buffer: %s, %dx%d, %d bytes per pixel\n", gBuffer.isCompact ? "compact" : "full",
+			   scene.width, scene.height, gBuffer.bytesPerPixel);
 	}
+}
+
+void releaseGBuffer(Scene &scene)
+{
+	scene.mRenderTargetPool.release(scene.gBufferData.target);
+	scene.gBufferData.target = nullptr;
+}
+
+// Transient target for the upscaled lighting result.
+void setUPSceneColor(Scene &scene)
+{
+	fboDesc &desc = scene.sceneColorDesc;
+	desc.width = scene.width;
+	desc.height = scene.height;
+	if (desc.colorFormats.empty())
+		desc.colorFormats = { GL_RGBA8 };
+	scene.sceneColor = scene.mRenderTargetPool.acquire(desc);
+	GL_DEBUG_LABEL(GL_FRAMEBUFFER, scene.sceneColor->getFBO(), "Scene Color");
+}
+
+void releaseSceneColor(Scene &scene)
+{
+	scene.mRenderTargetPool.release(scene.sceneColor);
+	scene.sceneColor = nullptr;
+}
+
+// Both loaders create immutable textures through direct state access;
+// sampling state lives in the samplers of samplerLibrary.  Each is
+// split into a decode, which does not touch GL and may run in a job,
+// and an upload on the GL thread, which frees the pixels.
+//
+// SOIL and its stb_image keep global state (the last error, the zlib
+// tables), so decodes take turns; only the model parsing overlaps.
+static std::mutex soilLock;
 
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+void decodeImage(decodedImage &image)
+{
+	PROFILE_ZONE("decodeImage");
+	std::lock_guard<std::mutex> lock(soilLock);
+	image.pixels = SOIL_load_image(image.path, &image.width, &image.height, 0, SOIL_LOAD_RGBA);
+	if (!image.pixels)
+		printf("Could not load %s\n", image.path);
+}
 
+unsigned int uploadCube(decodedImage* faces, unsigned int count)
+{
+	PROFILE_ZONE("uploadCube");
+	unsigned int textureID;
+	glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &textureID);
+	bool hasStorage = false;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		decodedImage &face = faces[i];
+		if (!face.pixels)
+			continue;
+		// the faces share one storage, sized by the first that decoded
+		if (!hasStorage)
+		{
+			glTextureStorage2D(textureID, 1, GL_RGBA8, face.width, face.height);
+			hasStorage = true;
+		}
+		glTextureSubImage3D(textureID, 0, 0, 0, i, face.width, face.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, face.pixels);
+		SOIL_free_image_data(face.pixels);
+		face.pixels = nullptr;
+	}
+	GL_DEBUG_LABEL(GL_TEXTURE, textureID, count == 0 ? "cube map" : faces[0].path);
 	return textureID;
 }
 
-unsigned int loadTexture(const char* path)
+unsigned int uploadTexture(decodedImage &image)
 {
+	PROFILE_ZONE("uploadTexture");
 	unsigned int textureID;
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID); // All upcoming GL_TEXTURE_2D operations now have effect on our texture object
-													   // Set our texture parameters
-	CHECKERROR;
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	// Set texture wrapping to GL_REPEAT
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	// Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	int width, height;
-	unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGBA);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	CHECKERROR;
+	glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+	if (!image.pixels)
+		return textureID;
+	int levels = 1;
+	for (int size = image.width > image.height ? image.width : image.height; size > 1; size /= 2)
+		++levels;
+	glTextureStorage2D(textureID, levels, GL_RGBA8, image.width, image.height);
+	glTextureSubImage2D(textureID, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+	glGenerateTextureMipmap(textureID);
+	SOIL_free_image_data(image.pixels);
+	image.pixels = nullptr;
+	GL_DEBUG_LABEL(GL_TEXTURE, textureID, image.path);
 	return textureID;
 }
 
+unsigned int loadCube(const std::vector<const char*> &facePath)
+{
+	std::vector<decodedImage> faces(facePath.size());
+	for (unsigned int i = 0; i < facePath.size(); ++i)
+	{
+		faces[i] = { facePath[i], nullptr, 0, 0 };
+		decodeImage(faces[i]);
+	}
+	return uploadCube(faces.data(), (unsigned int)faces.size());
+}
+
+unsigned int loadTexture(const char* path)
+{
+	decodedImage image = { path, nullptr, 0, 0 };
+	decodeImage(image);
+	return uploadTexture(image);
+}
+
 ////////////////////////////////////////////////////////////////////////
 // InitializeScene is called once during setup to create all the
 // textures, model VAOs, render target FBOs, and shader programs as
 // well as a number of other parameters.
 void InitializeScene(Scene &scene)
 {
-	CHECKERROR;
+	PROFILE_ZONE("InitializeScene");
+	GL_DEBUG_PUSH_GROUP("InitializeScene");
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	PROFILE_SYNC_GPU_CLOCK(gpuNow);
 
-	scene.dirShadowMap.shadowMapWidth = 1280;
-	scene.dirShadowMap.shadowMapHeight = 720;
-	scene.dirShadowMap.lightFrustrumWidth = 100.f;
-	scene.dirShadowMap.lightFrustrumHeight = 100.f;
-	scene.dirShadowMap.shadowDistance = 200.f;
-	scene.dirShadowMap.shadowDepthMap.CreateFBO(scene.dirShadowMap.shadowMapWidth, scene.dirShadowMap.shadowMapHeight);
+	scene.dirShadowMap.cascades.initialize(scene.mRenderTargetPool, scene.dirShadowMap.cascadeCount, scene.dirShadowMap.resolution);
+	scene.pointShadowMap.atlas.initialize(scene.mRenderTargetPool, scene.pointShadowMap.atlasSize);
 
 	scene.gEditorCamera.initialize(glm::vec3(0,50,-100),
 									 glm::vec3(0, 0, 0));
@@ -176,30 +250,63 @@ void InitializeScene(Scene &scene)
     // Enable OpenGL depth-testing
     glEnable(GL_DEPTH_TEST);
 
-    // Create the scene models and textures
-	if (!loadModelFromFile("assets/model/ground.json", groundMesh))
-		std::cout << "Unable to load assets/model/ground.json" << std::endl;
+	samplerLibrary::initialize();
+
+    // Create the scene models and textures.  The files are parsed and
+    // decoded in jobs, a job per file, the decodes one at a time; the
+    // GL objects are made here.
+	const int MODEL_COUNT = 3, TEXTURE_COUNT = 4, FACE_COUNT = 6;
+	const char* modelPaths[MODEL_COUNT] = { "assets/model/ground.json", "assets/model/cube.json", "assets/model/sphere.json" };
+	meshData* models[MODEL_COUNT] = { &groundMesh, &boxMesh, &sphereMesh };
+	bool modelLoaded[MODEL_COUNT];
+	decodedImage textureImages[TEXTURE_COUNT] = {
+		{ "assets/texture/ground_diffuse.png", nullptr, 0, 0 }, { "assets/texture/ground_specular.png", nullptr, 0, 0 },
+		{ "assets/texture/crate_diffuse.png", nullptr, 0, 0 }, { "assets/texture/crate_specular.png", nullptr, 0, 0 } };
+	decodedImage skyBoxFaces[FACE_COUNT] = {
+		{ "assets/texture/skybox_right.tga", nullptr, 0, 0 }, { "assets/texture/skybox_left.tga", nullptr, 0, 0 },
+		{ "assets/texture/skybox_up.tga", nullptr, 0, 0 }, { "assets/texture/skybox_down.tga", nullptr, 0, 0 },
+		{ "assets/texture/skybox_back.tga", nullptr, 0, 0 }, { "assets/texture/skybox_front.tga", nullptr, 0, 0 } };
+	jobSystem::parallelFor(0, MODEL_COUNT + TEXTURE_COUNT + FACE_COUNT, 1, [&](int begin, int end)
+	{
+		PROFILE_ZONE("InitializeScene::load chunk");
+		for (int i = begin; i < end; ++i)
+		{
+			if (i < MODEL_COUNT)
+				modelLoaded[i] = loadModelFromFile(modelPaths[i], *models[i]);
+			else if (i < MODEL_COUNT + TEXTURE_COUNT)
+				decodeImage(textureImages[i - MODEL_COUNT]);
+			else
+				decodeImage(skyBoxFaces[i - MODEL_COUNT - TEXTURE_COUNT]);
+		}
+	});
+	for (int i = 0; i < MODEL_COUNT; ++i)
+	{
+		if (!modelLoaded[i])
+			std::cout << "Unable to load " << modelPaths[i] << std::endl;
+	}
 	scene.groundVAO = createVAO(groundMesh);
-
-	if (!loadModelFromFile("assets/model/cube.json", boxMesh))
-		std::cout << "Unable to load assets/model/cube.json" << std::endl;
 	scene.boxVAO = createVAO(boxMesh);
-
-	if (!loadModelFromFile("assets/model/sphere.json", sphereMesh))
-		std::cout << "Unable to load assets/model/sphere.json" << std::endl;
 	scene.sphereVAO = createVAO(sphereMesh);
 
-	scene.quad = createQuad(scene.quadCount);
-
-	scene.groundTexture = loadTexture("assets/texture/ground_diffuse.png");
-	scene.groundSpecular = loadTexture("assets/texture/ground_specular.png");
-	scene.boxTexture = loadTexture("assets/texture/crate_diffuse.png");
-	scene.boxSpecular= loadTexture("assets/texture/crate_specular.png");
+	scene.teapotVAO = CreateTeapot(12, scene.teapotCount);
+	scene.boxCount = boxMesh.faces.size();
+	scene.sphereCount = sphereMesh.faces.size();
+	scene.boxRadius = computeBoundingRadius(boxMesh);
+	scene.sphereRadius = computeBoundingRadius(sphereMesh);
+	scene.teapotRadius = teapotBoundingRadius();
 
-	std::vector<const char*> skyBoxTexturePaths = { "assets/texture/skybox_right.tga", "assets/texture/skybox_left.tga",
-		"assets/texture/skybox_up.tga", "assets/texture/skybox_down.tga",
-		"assets/texture/skybox_back.tga", "assets/texture/skybox_front.tga", };
-	scene.skyBoxTexture = loadCube(skyBoxTexturePaths);
+	scene.quad = createQuad(scene.quadCount);
+	GL_DEBUG_LABEL(GL_VERTEX_ARRAY, scene.groundVAO, "Ground");
+	GL_DEBUG_LABEL(GL_VERTEX_ARRAY, scene.boxVAO, "Box");
+	GL_DEBUG_LABEL(GL_VERTEX_ARRAY, scene.sphereVAO, "Sphere");
+	GL_DEBUG_LABEL(GL_VERTEX_ARRAY, scene.teapotVAO, "Teapot");
+	GL_DEBUG_LABEL(GL_VERTEX_ARRAY, scene.quad, "Quad");
+
+	scene.groundTexture = uploadTexture(textureImages[0]);
+	scene.groundSpecular = uploadTexture(textureImages[1]);
+	scene.boxTexture = uploadTexture(textureImages[2]);
+	scene.boxSpecular= uploadTexture(textureImages[3]);
+	scene.skyBoxTexture = uploadCube(skyBoxFaces, FACE_COUNT);
 
 	// initialize light data
 
@@ -233,7 +340,8 @@ void InitializeScene(Scene &scene)
 		scene.pointLightParameters.push_back(ptLightParam);
 	}
 
-	directionalLight dirLight = directionalLight(glm::vec3(1, 0, 0));
+	// angled down so the cascaded shadows land on the ground
+	directionalLight dirLight = directionalLight(glm::normalize(glm::vec3(1, -1, 0.5f)));
 	directionalLightParam dirLightParam;
 	dirLightParam.directionLightDiffuse = dirLight.getDiffuseColor();
 	dirLightParam.directionLightDir = dirLight.getLightDirection();
@@ -253,7 +361,6 @@ void InitializeScene(Scene &scene)
 	glBindAttribLocation(scene.shaderFINAL.getProgram(), 2, "vertexTexture");
 	glBindAttribLocation(scene.shaderFINAL.getProgram(), 3, "vertexTangent");
 	scene.shaderFINAL.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::BLINN_PHONG][global::eObjectMaterialType::COLOR] = scene.shaderFINAL;
 
 	// Create the FINAL shader program from source code files.
@@ -267,7 +374,6 @@ void InitializeScene(Scene &scene)
 	glBindAttribLocation(textureShader.getProgram(), 2, "vertexTexture");
 	glBindAttribLocation(textureShader.getProgram(), 3, "vertexTangent");
 	textureShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::BLINN_PHONG][global::eObjectMaterialType::TEXTURE] = textureShader;
 
 	ShaderProgram textureSpecularShader;
@@ -279,7 +385,6 @@ void InitializeScene(Scene &scene)
 	glBindAttribLocation(textureSpecularShader.getProgram(), 1, "vertexNormal");
 	glBindAttribLocation(textureSpecularShader.getProgram(), 2, "vertexTexture");
 	textureSpecularShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::BLINN_PHONG][global::eObjectMaterialType::TEXTURE_SPECULAR] = textureSpecularShader;
 
 	ShaderProgram lightShader;
@@ -288,7 +393,6 @@ void InitializeScene(Scene &scene)
 	lightShader.CreateShader("shaders/drawLight.frag", GL_FRAGMENT_SHADER);
 	glBindAttribLocation(textureShader.getProgram(), 0, "vertex");
 	lightShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::LIGHT_COLOR] = lightShader;
 
 	ShaderProgram skyboxShader;
@@ -297,7 +401,6 @@ void InitializeScene(Scene &scene)
 	skyboxShader.CreateShader("shaders/skybox.frag", GL_FRAGMENT_SHADER);
 	glBindAttribLocation(skyboxShader.getProgram(), 0, "vertex");
 	skyboxShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::TEXTURE_SKYBOX] = skyboxShader;
 
 	ShaderProgram shadowDepthShader;
@@ -306,7 +409,6 @@ void InitializeScene(Scene &scene)
 	shadowDepthShader.CreateShader("shaders/shadowDepth.frag", GL_FRAGMENT_SHADER);
 	glBindAttribLocation(shadowDepthShader.getProgram(), 0, "vertex");
 	shadowDepthShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::BLINN_PHONG][global::eObjectMaterialType::SHADOW_DEPTH] = shadowDepthShader;
 
 	ShaderProgram quadRenderShader;
@@ -316,7 +418,6 @@ void InitializeScene(Scene &scene)
 	glBindAttribLocation(quadRenderShader.getProgram(), 0, "vertex");
 	glBindAttribLocation(quadRenderShader.getProgram(), 1, "vertexTexture");
 	quadRenderShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::TEXTURE_QUAD] = quadRenderShader;
 
 	ShaderProgram deferredGBufferShader;
@@ -327,7 +428,6 @@ void InitializeScene(Scene &scene)
 	glBindAttribLocation(deferredGBufferShader.getProgram(), 1, "vertexNormal");
 	glBindAttribLocation(deferredGBufferShader.getProgram(), 2, "vertexTexture");
 	deferredGBufferShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][global::eObjectMaterialType::DEFERRED_GBUFFER] = deferredGBufferShader;
 
 	ShaderProgram deferredGBufferGammaShader;
@@ -338,7 +438,6 @@ void InitializeScene(Scene &scene)
 	glBindAttribLocation(deferredGBufferGammaShader.getProgram(), 1, "vertexNormal");
 	glBindAttribLocation(deferredGBufferGammaShader.getProgram(), 2, "vertexTexture");
 	deferredGBufferGammaShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][global::eObjectMaterialType::DEFERRED_GBUFFER_GAMMA] = deferredGBufferGammaShader;
 
 	ShaderProgram deferredLightPassShader;
@@ -348,7 +447,6 @@ void InitializeScene(Scene &scene)
 	glBindAttribLocation(deferredLightPassShader.getProgram(), 0, "vertex");
 	glBindAttribLocation(deferredLightPassShader.getProgram(), 1, "vertexTexture");
 	deferredLightPassShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][global::eObjectMaterialType::DEFERRED_LIGHTING_PASS] = deferredLightPassShader;
 
 	ShaderProgram deferredLightPassGammaShader;
@@ -358,9 +456,76 @@ void InitializeScene(Scene &scene)
 	glBindAttribLocation(deferredLightPassGammaShader.getProgram(), 0, "vertex");
 	glBindAttribLocation(deferredLightPassGammaShader.getProgram(), 1, "vertexTexture");
 	deferredLightPassGammaShader.LinkProgram();
-	CHECKERROR;
 	scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][global::eObjectMaterialType::DEFERRED_LIGHTING_PASS_GAMMA] = deferredLightPassGammaShader;
 
+	// compact G buffer variants of the deferred shaders
+	const char* compactDefines = "#define COMPACT_GBUFFER\n";
+	ShaderProgram deferredGBufferCompactShader;
+	deferredGBufferCompactShader.CreateProgram();
+	deferredGBufferCompactShader.CreateShader("shaders/deferred_gBuffer.vert", GL_VERTEX_SHADER);
+	deferredGBufferCompactShader.CreateShader("shaders/deferred_gBuffer.frag", GL_FRAGMENT_SHADER, compactDefines);
+	glBindAttribLocation(deferredGBufferCompactShader.getProgram(), 0, "vertex");
+	glBindAttribLocation(deferredGBufferCompactShader.getProgram(), 1, "vertexNormal");
+	glBindAttribLocation(deferredGBufferCompactShader.getProgram(), 2, "vertexTexture");
+	deferredGBufferCompactShader.LinkProgram();
+	scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][global::eObjectMaterialType::DEFERRED_GBUFFER_COMPACT] = deferredGBufferCompactShader;
+
+	ShaderProgram deferredGBufferCompactGammaShader;
+	deferredGBufferCompactGammaShader.CreateProgram();
+	deferredGBufferCompactGammaShader.CreateShader("shaders/deferred_gBuffer.vert", GL_VERTEX_SHADER);
+	deferredGBufferCompactGammaShader.CreateShader("shaders/deferred_gBufferGamma.frag", GL_FRAGMENT_SHADER, compactDefines);
+	glBindAttribLocation(deferredGBufferCompactGammaShader.getProgram(), 0, "vertex");
+	glBindAttribLocation(deferredGBufferCompactGammaShader.getProgram(), 1, "vertexNormal");
+	glBindAttribLocation(deferredGBufferCompactGammaShader.getProgram(), 2, "vertexTexture");
+	deferredGBufferCompactGammaShader.LinkProgram();
+	scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][global::eObjectMaterialType::DEFERRED_GBUFFER_COMPACT_GAMMA] = deferredGBufferCompactGammaShader;
+
+	ShaderProgram deferredLightPassCompactShader;
+	deferredLightPassCompactShader.CreateProgram();
+	deferredLightPassCompactShader.CreateShader("shaders/deferred_lightPass.vert", GL_VERTEX_SHADER);
+	deferredLightPassCompactShader.CreateShader("shaders/deferred_lightPass.frag", GL_FRAGMENT_SHADER, compactDefines);
+	glBindAttribLocation(deferredLightPassCompactShader.getProgram(), 0, "vertex");
+	glBindAttribLocation(deferredLightPassCompactShader.getProgram(), 1, "vertexTexture");
+	deferredLightPassCompactShader.LinkProgram();
+	scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][global::eObjectMaterialType::DEFERRED_LIGHTING_PASS_COMPACT] = deferredLightPassCompactShader;
+
+	ShaderProgram deferredLightPassCompactGammaShader;
+	deferredLightPassCompactGammaShader.CreateProgram();
+	deferredLightPassCompactGammaShader.CreateShader("shaders/deferred_lightPass.vert", GL_VERTEX_SHADER);
+	deferredLightPassCompactGammaShader.CreateShader("shaders/deferred_lightPassGamma.frag", GL_FRAGMENT_SHADER, compactDefines);
+	glBindAttribLocation(deferredLightPassCompactGammaShader.getProgram(), 0, "vertex");
+	glBindAttribLocation(deferredLightPassCompactGammaShader.getProgram(), 1, "vertexTexture");
+	deferredLightPassCompactGammaShader.LinkProgram();
+	scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][global::eObjectMaterialType::DEFERRED_LIGHTING_PASS_COMPACT_GAMMA] = deferredLightPassCompactGammaShader;
+
+	// uniform blocks filled from the frame's ring buffer range sit at
+	// fixed binding points in every program that declares them
+	for (int lightType = 0; lightType < global::eLightingType::MAX_LIGHTING_COUNT; ++lightType)
+	{
+		for (int materialType = 0; materialType < global::eObjectMaterialType::MAX_MATERIAL_COUNT; ++materialType)
+		{
+			unsigned int program = scene.shaderLibrary[lightType][materialType].getProgram();
+			if (program == 0)
+				continue;
+			unsigned int blockIndex = glGetUniformBlockIndex(program, "FrameConstants");
+			if (blockIndex != GL_INVALID_INDEX)
+				glUniformBlockBinding(program, blockIndex, FRAME_CONSTANTS_BINDING);
+			blockIndex = glGetUniformBlockIndex(program, "lightBlock");
+			if (blockIndex != GL_INVALID_INDEX)
+				glUniformBlockBinding(program, blockIndex, LIGHT_BLOCK_BINDING);
+			blockIndex = glGetUniformBlockIndex(program, "ObjectConstants");
+			if (blockIndex != GL_INVALID_INDEX)
+				glUniformBlockBinding(program, blockIndex, OBJECT_CONSTANTS_BINDING);
+			// recorded draws bind the material maps to these units
+			int loc = glGetUniformLocation(program, "material.diffuseMap");
+			if (loc >= 0)
+				glProgramUniform1i(program, loc, 0);
+			loc = glGetUniformLocation(program, "material.specularMap");
+			if (loc >= 0)
+				glProgramUniform1i(program, loc, 1);
+		}
+	}
+
 	scene.fovDeg = 45.f;
 	scene.nearplane = 0.1f;
 	scene.farplane = 20000.f;
@@ -372,6 +537,8 @@ void InitializeScene(Scene &scene)
 	graphicObject groundObject(glm::vec3(0.f, 0.f, 0.f), glm::vec3(), glm::vec3(250,1,250), scene.groundVAO, groundMesh.faces.size());
 	groundObject.setTextureMap(scene.groundTexture); 
 	groundObject.setSpecularMap(scene.groundSpecular);
+	groundObject.setBoundingRadius(computeBoundingRadius(groundMesh));
+	groundObject.setIsShadowReceiver(true);
 	scene.graphicsObjectContainer.push_back(groundObject);
 
 	glm::vec3 boxPosition[27] = { glm::vec3(-35, 15, -35), glm::vec3(0, 15, -35), glm::vec3(35, 15, -35),
@@ -393,234 +560,713 @@ void InitializeScene(Scene &scene)
 		graphicObject boxObject(boxPosition[i], glm::vec3(), boxScale, scene.boxVAO, boxMesh.faces.size());
 		boxObject.setTextureMap(scene.boxTexture);
 		boxObject.setSpecularMap(scene.boxSpecular);
+		boxObject.setBoundingRadius(computeBoundingRadius(boxMesh));
+		boxObject.setIsShadowCaster(true);
+		boxObject.setIsShadowReceiver(true);
 		scene.graphicsObjectContainer.push_back(boxObject);
 	}
 
-	setUPGBuffer(scene);
-	CHECKERROR;
+	// the window may not have been reshaped yet
+	scene.width = (int)global::gWidth;
+	scene.height = (int)global::gHeight;
+	scene.renderWidth = scene.width;
+	scene.renderHeight = scene.height;
+	scene.lightingPassTimer.initialize();
+	scene.frameTimer.initialize();
+	scene.frameTimer.setName("Frame");
+	scene.uiTimer.initialize();
+	scene.uiTimer.setName("UI");
+	scene.frameDataRing.initialize(FRAME_DATA_BYTES);
+	buildRenderGraph(scene);
+	// the setup above bound things directly
+	glState::invalidate();
+	GL_DEBUG_POP_GROUP();
 }
 ////////////////////////////////////////////////////////////////////////
 
+// Draws in sort key order, so objects sharing textures and meshes
+// follow each other and glState can skip the rebinds.  The keys are
+// generated in parallel into the frame arena, and compared against
+// last frame's, which are still there; the sort only runs when they
+// changed.
+//
+// The draws are recorded into command lists (see commandList.h) by
+// jobs, each taking a chunk of the draw order, and the lists are
+// replayed here in order.  Every object's constants are written into
+// its own range of one ring buffer allocation while recording.
 void renderGeometry(Scene &scene, unsigned int shader)
 {
-	for (unsigned int i = 0; i < scene.graphicsObjectContainer.size(); ++i)
+	std::vector<graphicObject> &objects = scene.graphicsObjectContainer;
+	{
+		PROFILE_ZONE("renderGeometry::sortKeys");
+		int keyCount = (int)objects.size();
+		unsigned long long* keys = frameArena::allocateArray<unsigned long long>(keyCount);
+		jobSystem::parallelFor(0, keyCount, 256, [&](int begin, int end)
+		{
+			PROFILE_ZONE("renderGeometry::sortKeys chunk");
+			for (int i = begin; i < end; ++i)
+				keys[i] = objects[i].getSortKey() | (unsigned long long)i;
+		});
+		unsigned int arenaFrame = frameArena::getFrameIndex();
+		bool unchanged = scene.drawKeysFrame + 1 == arenaFrame && scene.drawKeyCount == keyCount &&
+						 std::equal(keys, keys + keyCount, scene.drawKeys);
+		if (!unchanged)
+		{
+			scene.sortedDrawKeys.assign(keys, keys + keyCount);
+			std::sort(scene.sortedDrawKeys.begin(), scene.sortedDrawKeys.end());
+		}
+		scene.drawKeys = keys;
+		scene.drawKeyCount = keyCount;
+		scene.drawKeysFrame = arenaFrame;
+	}
+
+	commandRecordingParam &recording = scene.commandRecordingParameters;
+	const std::vector<unsigned long long> &order = scene.sortedDrawKeys;
+	int count = (int)order.size();
+	size_t stride = getObjectConstantsStride(scene);
+	size_t base = 0;
+	unsigned char* constants = (unsigned char*)scene.frameDataRing.allocate(stride * count, base);
+	if (!constants)
+		return;
+
+	int listCount = 1;
+	if (recording.parallel)
+		listCount = glm::clamp((count + MIN_DRAWS_PER_LIST - 1) / MIN_DRAWS_PER_LIST, 1,
+							   jobSystem::getThreadCount() * jobSystem::SPLIT_PER_THREAD);
+	if ((int)scene.geometryCommands.size() < listCount)
+		scene.geometryCommands.resize(listCount);
+	unsigned int buffer = scene.frameDataRing.getBuffer();
+	auto record = [&](int begin, int end)
+	{
+		PROFILE_ZONE("renderGeometry::record chunk");
+		for (int l = begin; l < end; ++l)
+		{
+			commandList &list = scene.geometryCommands[l];
+			int first = (int)((long long)count * l / listCount);
+			int last = (int)((long long)count * (l + 1) / listCount);
+			list.clear();
+			list.reserve((last - first) * COMMANDS_PER_DRAW + 1);
+			list.bindProgram(shader);
+			for (int k = first; k < last; ++k)
+			{
+				graphicObject &object = objects[(unsigned int)(order[k] & 0xffffff)];
+				object.recordDraw(list, *(objectConstants*)(constants + k * stride), buffer, base + k * stride);
+			}
+		}
+	};
+	{
+		PROFILE_ZONE("renderGeometry::record");
+		if (recording.parallel)
+			jobSystem::parallelFor(0, listCount, 1, record);
+		else
+			record(0, 1);
+	}
+
+	// lights reach the lighting pass through the light block, nothing
+	// drawn here reads them
+	PROFILE_ZONE("renderGeometry::replay");
+	recording.lists = listCount;
+	recording.commands = 0;
+	for (int l = 0; l < listCount; ++l)
+	{
+		scene.geometryCommands[l].replay();
+		recording.commands += (int)scene.geometryCommands[l].size();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////
+// Shadow pass: refits the cascades of the first directional light to
+// the camera and renders the casters overlapping each cascade that is
+// due for an update this frame.
+void gatherShadowInfo(Scene &scene)
+{
+	directionalShadowMapParam &shadow = scene.dirShadowMap;
+	cascadedShadowMap &cascades = shadow.cascades;
+	shadow.cascadesRendered = 0;
+	shadow.castersRendered = 0;
+	if (scene.directionalLightContainer.empty())
+		return;
+
+	shadow.cascadeCount = glm::clamp(shadow.cascadeCount, 1, (int)cascadedShadowMap::MAX_CASCADES);
+	if (shadow.cascadeCount != cascades.getCascadeCount() || shadow.resolution != cascades.getResolution())
+	{
+		cascades.release(scene.mRenderTargetPool);
+		cascades.initialize(scene.mRenderTargetPool, shadow.cascadeCount, shadow.resolution);
+	}
+
+	glm::vec3 lightDir = scene.mLightManager.getDirectionalLights()[0].getLightDirection();
+	{
+		frameTiming::scope culling(frameTiming::CULLING);
+		cascades.update(scene.gEditorCamera.getViewMtx(), scene.fovDeg, (float)scene.width / scene.height,
+						scene.nearplane, shadow.shadowDistance, shadow.splitLambda, lightDir, shadow.staggerUpdates);
+	}
+
+	ShaderProgram &shadowDepthShader = scene.shaderLibrary[global::eLightingType::BLINN_PHONG][global::eObjectMaterialType::SHADOW_DEPTH];
+	shadowDepthShader.Use();
+	unsigned int shader = shadowDepthShader.getProgram();
+	int lightSpaceLoc = glGetUniformLocation(shader, "LightSpaceMtx");
+	int modelLoc = glGetUniformLocation(shader, "ModelMatrix");
+	glState::setEnabled(GL_DEPTH_CLAMP, true);
+	glState::setEnabled(GL_POLYGON_OFFSET_FILL, true);
+	glPolygonOffset(2.f, 4.f);
+	// visibility first, so it is timed apart from the draws: a bit per
+	// cascade due this frame, for every object at once
+	std::vector<graphicObject> &objects = scene.graphicsObjectContainer;
+	unsigned char* casterCascades = frameArena::allocateArray<unsigned char>(objects.size());
+	{
+		frameTiming::scope culling(frameTiming::CULLING);
+		jobSystem::parallelFor(0, (int)objects.size(), 256, [&](int begin, int end)
+		{
+			PROFILE_ZONE("gatherShadowInfo::casterCascades chunk");
+			for (int j = begin; j < end; ++j)
+			{
+				graphicObject &object = objects[j];
+				unsigned char mask = 0;
+				if (object.getIsShadowCaster())
+				{
+					for (int i = 0; i < cascades.getCascadeCount(); ++i)
+					{
+						if (cascades.needsRender(i) &&
+							cascades.isCasterVisible(i, object.getTranslation(), object.getWorldBoundingRadius()))
+							mask |= 1 << i;
+					}
+				}
+				casterCascades[j] = mask;
+			}
+		});
+	}
+
+	for (int i = 0; i < cascades.getCascadeCount(); ++i)
+	{
+		if (!cascades.needsRender(i))
+			continue;
+
+		cascades.bindCascade(i);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glProgramUniformMatrix4fv(shader, lightSpaceLoc, 1, GL_FALSE, glm::value_ptr(cascades.getLightViewProjections()[i]));
+		for (unsigned int j = 0; j < objects.size(); ++j)
+		{
+			if (!(casterCascades[j] & (1 << i)))
+				continue;
+			objects[j].drawDepth(shader, modelLoc);
+			++shadow.castersRendered;
+		}
+		++shadow.cascadesRendered;
+	}
+	glState::setEnabled(GL_POLYGON_OFFSET_FILL, false);
+	glState::setEnabled(GL_DEPTH_CLAMP, false);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Point light shadow pass: sizes each light's atlas tile from its
+// screen coverage, then redraws only the tiles whose light or casters
+// changed since they were last drawn.
+void gatherPointShadowInfo(Scene &scene)
+{
+	pointShadowMapParam &shadow = scene.pointShadowMap;
+	pointShadowAtlas &atlas = shadow.atlas;
+	if (shadow.atlasSize != atlas.getAtlasSize())
 	{
-		scene.mAmbientLight.updateLightParameter(shader);
-		scene.mLightManager.passDataToShader(shader);
-		scene.graphicsObjectContainer[i].draw(shader);
-		CHECKERROR;
+		atlas.release(scene.mRenderTargetPool);
+		atlas.initialize(scene.mRenderTargetPool, shadow.atlasSize);
 	}
+
+	std::vector<pointLight> &lights = scene.mLightManager.getPointLights();
+	{
+		frameTiming::scope culling(frameTiming::CULLING);
+		atlas.allocateTiles(lights, scene.gEditorCamera.getPosition(), scene.fovDeg, scene.height,
+							shadow.minFaceSize, shadow.maxFaceSize);
+	}
+
+	ShaderProgram &shadowDepthShader = scene.shaderLibrary[global::eLightingType::BLINN_PHONG][global::eObjectMaterialType::SHADOW_DEPTH];
+	shadowDepthShader.Use();
+	atlas.render(lights, scene.graphicsObjectContainer, shadowDepthShader.getProgram());
+
+	shadow.staticTilesRedrawn = atlas.getStaticTilesRedrawn();
+	shadow.shadowTilesRedrawn = atlas.getShadowTilesRedrawn();
+	shadow.facesRendered = atlas.getFacesRendered();
 }
 
 void renderLightingPass(Scene &scene)
 {
 	auto materialType = global::eObjectMaterialType::DEFERRED_LIGHTING_PASS;
-	if (scene.enableGammaCorrection)
+	if (scene.gBufferData.isCompact)
+	{
+		materialType = scene.enableGammaCorrection ? global::eObjectMaterialType::DEFERRED_LIGHTING_PASS_COMPACT_GAMMA
+												   : global::eObjectMaterialType::DEFERRED_LIGHTING_PASS_COMPACT;
+	}
+	else if (scene.enableGammaCorrection)
 	{
 		materialType = global::eObjectMaterialType::DEFERRED_LIGHTING_PASS_GAMMA;
 	}
-	ShaderProgram deferredLightPassShader = scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][materialType];
+	ShaderProgram &deferredLightPassShader = scene.shaderLibrary[global::eLightingType::DEFERRED_BLINN_PHONG][materialType];
 	deferredLightPassShader.Use();
 	unsigned int shader = deferredLightPassShader.getProgram();
-	scene.mAmbientLight.updateLightParameter(shader);
-	scene.mLightManager.passDataToShader(shader);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gPositionTexture);
-	int loc = glGetUniformLocation(shader, "gPositionTexture");
-	glUniform1i(loc, 0);
-	CHECKERROR;
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gNormalTexture);
+	int loc;
+	if (scene.gBufferData.isCompact)
+	{
+		// rebuild world positions from depth in the shader
+		glState::bindTexture(0, GL_TEXTURE_2D, scene.gBufferData.gDepthTexure);
+		samplerLibrary::bind(0, samplerLibrary::POINT);
+		loc = glGetUniformLocation(shader, "gDepthTexture");
+		glProgramUniform1i(shader, loc, 0);
+	}
+	else
+	{
+		glState::bindTexture(0, GL_TEXTURE_2D, scene.gBufferData.gPositionTexture);
+		samplerLibrary::bind(0, samplerLibrary::POINT);
+		loc = glGetUniformLocation(shader, "gPositionTexture");
+		glProgramUniform1i(shader, loc, 0);
+	}
+	glState::bindTexture(1, GL_TEXTURE_2D, scene.gBufferData.gNormalTexture);
+	samplerLibrary::bind(1, samplerLibrary::POINT);
 	loc = glGetUniformLocation(shader, "gNormalTexture");
-	glUniform1i(loc, 1);
-	CHECKERROR;
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gAlbedoTexture);
+	glProgramUniform1i(shader, loc, 1);
+	glState::bindTexture(2, GL_TEXTURE_2D, scene.gBufferData.gAlbedoTexture);
+	samplerLibrary::bind(2, samplerLibrary::POINT);
 	loc = glGetUniformLocation(shader, "gAlbedoTexture");
-	glUniform1i(loc, 2);
-	CHECKERROR;
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gSpecularTexture);
+	glProgramUniform1i(shader, loc, 2);
+	glState::bindTexture(3, GL_TEXTURE_2D, scene.gBufferData.gSpecularTexture);
+	samplerLibrary::bind(3, samplerLibrary::POINT);
 	loc = glGetUniformLocation(shader, "gSpecularTexture");
-	glUniform1i(loc, 3);
-	CHECKERROR;
-	loc = glGetUniformLocation(shader, "cameraPos");
-	glUniform3fv(loc, 1, glm::value_ptr(scene.gEditorCamera.getPosition()));
-	glBindVertexArray(scene.quad);
-	glDrawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT, 0);
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(0);
-	deferredLightPassShader.Unuse();
+	glProgramUniform1i(shader, loc, 3);
+	glm::vec2 gBufferScale = glm::vec2((float)scene.renderWidth / scene.gBufferData.width,
+									   (float)scene.renderHeight / scene.gBufferData.height);
+	loc = glGetUniformLocation(shader, "gBufferScale");
+	glProgramUniform2fv(shader, loc, 1, glm::value_ptr(gBufferScale));
+
+	// cascaded shadows of directional light 0
+	cascadedShadowMap &cascades = scene.dirShadowMap.cascades;
+	glState::bindTexture(4, GL_TEXTURE_2D_ARRAY, cascades.getDepthTexture());
+	samplerLibrary::bind(4, samplerLibrary::SHADOW_COMPARE);
+	loc = glGetUniformLocation(shader, "shadowMap");
+	glProgramUniform1i(shader, loc, 4);
+	loc = glGetUniformLocation(shader, "shadowEnabled");
+	glProgramUniform1i(shader, loc, scene.dirShadowMap.enabled ? 1 : 0);
+	loc = glGetUniformLocation(shader, "showCascades");
+	glProgramUniform1i(shader, loc, scene.dirShadowMap.showCascades ? 1 : 0);
+	loc = glGetUniformLocation(shader, "cascadeCount");
+	glProgramUniform1i(shader, loc, cascades.getCascadeCount());
+	loc = glGetUniformLocation(shader, "cascadeMatrices");
+	glProgramUniformMatrix4fv(shader, loc, cascades.getCascadeCount(), GL_FALSE, glm::value_ptr(cascades.getLightViewProjections()[0]));
+	loc = glGetUniformLocation(shader, "cascadeSplits");
+	glProgramUniform1fv(shader, loc, cascades.getCascadeCount(), cascades.getSplitDistances());
+	loc = glGetUniformLocation(shader, "cascadeTexelSize");
+	glProgramUniform1fv(shader, loc, cascades.getCascadeCount(), cascades.getTexelWorldSizes());
+
+	// point light shadow atlas
+	pointShadowAtlas &atlas = scene.pointShadowMap.atlas;
+	glState::bindTexture(5, GL_TEXTURE_2D_ARRAY, atlas.getDepthTexture());
+	samplerLibrary::bind(5, samplerLibrary::SHADOW_COMPARE);
+	loc = glGetUniformLocation(shader, "pointShadowAtlas");
+	glProgramUniform1i(shader, loc, 5);
+	loc = glGetUniformLocation(shader, "pointShadowEnabled");
+	glProgramUniform1i(shader, loc, scene.pointShadowMap.enabled ? 1 : 0);
+	loc = glGetUniformLocation(shader, "pointShadowNear");
+	glProgramUniform1f(shader, loc, atlas.getNearPlane());
+	loc = glGetUniformLocation(shader, "pointShadowTile");
+	glProgramUniform4fv(shader, loc, pointShadowAtlas::MAX_LIGHTS, glm::value_ptr(atlas.getTiles()[0]));
+	loc = glGetUniformLocation(shader, "pointShadowFar");
+	glProgramUniform1fv(shader, loc, pointShadowAtlas::MAX_LIGHTS, atlas.getFarPlanes());
+	glState::bindVertexArray(scene.quad);
+	glState::drawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT);
 }
 
 void drawGBuffer(Scene &scene)
 {
-	ShaderProgram quadShader = scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::TEXTURE_QUAD];
+	ShaderProgram &quadShader = scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::TEXTURE_QUAD];
 	quadShader.Use();
+	samplerLibrary::bind(0, samplerLibrary::POINT);
 
-	// draw G buffer position
+	// draw G buffer position (depth for the compact G buffer)
 	{
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gPositionTexture);
+		glState::bindTexture(0, GL_TEXTURE_2D, scene.gBufferData.isCompact ? scene.gBufferData.gDepthTexure
+																		   : scene.gBufferData.gPositionTexture);
 		int loc = glGetUniformLocation(quadShader.getProgram(), "texture");
-		glUniform1i(loc, 0);
+		glProgramUniform1i(quadShader.getProgram(), loc, 0);
 		glm::mat4 scale = glm::scale(glm::vec3(0.25, 0.25, 0.25));
 		glm::mat4 translate = glm::translate(glm::vec3(0.75, 0.75, 0));
 		glm::mat4 transform = translate * scale;
 		loc = glGetUniformLocation(quadShader.getProgram(), "transform");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(transform));
-		glBindVertexArray(scene.quad);
-		glDrawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT, 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindVertexArray(0);
+		glProgramUniformMatrix4fv(quadShader.getProgram(), loc, 1, GL_FALSE, glm::value_ptr(transform));
+		glState::bindVertexArray(scene.quad);
+		glState::drawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT);
 	}
 
 	// draw G Buffer Normals
 	{
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gNormalTexture);
+		glState::bindTexture(0, GL_TEXTURE_2D, scene.gBufferData.gNormalTexture);
 		int loc = glGetUniformLocation(quadShader.getProgram(), "texture");
-		glUniform1i(loc, 0);
+		glProgramUniform1i(quadShader.getProgram(), loc, 0);
 		glm::mat4 scale = glm::scale(glm::vec3(0.25, 0.25, 0.25));
 		glm::mat4 translate = glm::translate(glm::vec3(0.75, 0.25, 0));
 		glm::mat4 transform = translate * scale;
 		loc = glGetUniformLocation(quadShader.getProgram(), "transform");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(transform));
-		glBindVertexArray(scene.quad);
-		glDrawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT, 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindVertexArray(0);
+		glProgramUniformMatrix4fv(quadShader.getProgram(), loc, 1, GL_FALSE, glm::value_ptr(transform));
+		glState::bindVertexArray(scene.quad);
+		glState::drawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT);
 	}
 
 	// draw G Buffer Albedo
 	{
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gAlbedoTexture);
+		glState::bindTexture(0, GL_TEXTURE_2D, scene.gBufferData.gAlbedoTexture);
 		int loc = glGetUniformLocation(quadShader.getProgram(), "texture");
-		glUniform1i(loc, 0);
+		glProgramUniform1i(quadShader.getProgram(), loc, 0);
 		glm::mat4 scale = glm::scale(glm::vec3(0.25, 0.25, 0.25));
 		glm::mat4 translate = glm::translate(glm::vec3(0.75, -0.25, 0));
 		glm::mat4 transform = translate * scale;
 		loc = glGetUniformLocation(quadShader.getProgram(), "transform");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(transform));
-		glBindVertexArray(scene.quad);
-		glDrawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT, 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindVertexArray(0);
+		glProgramUniformMatrix4fv(quadShader.getProgram(), loc, 1, GL_FALSE, glm::value_ptr(transform));
+		glState::bindVertexArray(scene.quad);
+		glState::drawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT);
 	}
 
 	// draw G Buffer specular
 	{
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, scene.gBufferData.gSpecularTexture);
+		glState::bindTexture(0, GL_TEXTURE_2D, scene.gBufferData.gSpecularTexture);
 		int loc = glGetUniformLocation(quadShader.getProgram(), "texture");
-		glUniform1i(loc, 0);
+		glProgramUniform1i(quadShader.getProgram(), loc, 0);
 		glm::mat4 scale = glm::scale(glm::vec3(0.25, 0.25, 0.25));
 		glm::mat4 translate = glm::translate(glm::vec3(0.75, -0.75, 0));
 		glm::mat4 transform = translate * scale;
 		loc = glGetUniformLocation(quadShader.getProgram(), "transform");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(transform));
-		glBindVertexArray(scene.quad);
-		glDrawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT, 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindVertexArray(0);
+		glProgramUniformMatrix4fv(quadShader.getProgram(), loc, 1, GL_FALSE, glm::value_ptr(transform));
+		glState::bindVertexArray(scene.quad);
+		glState::drawElements(GL_TRIANGLES, scene.quadCount, GL_UNSIGNED_INT);
 	}
 
-	quadShader.Unuse();
-	CHECKERROR;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Frame passes.  Each one binds the target it draws into and applies
+// the clear the render graph hands it (the first pass writing a target
+// clears it, everyone after draws on top).
+static void clearTarget(unsigned int clearMask)
+{
+	if (clearMask)
+	{
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(clearMask);
+	}
+}
+
+static void gBufferPass(Scene &scene, unsigned int clearMask)
+{
+	glState::bindFramebuffer(GL_FRAMEBUFFER, scene.gBufferData.gBuffer);
+	glState::viewport(0, 0, scene.renderWidth, scene.renderHeight);
+	clearTarget(clearMask);
+	auto lightType = global::eLightingType::DEFERRED_BLINN_PHONG;
+	auto modelMaterial = global::eObjectMaterialType::DEFERRED_GBUFFER;
+	if (scene.gBufferData.isCompact)
+	{
+		modelMaterial = scene.enableGammaCorrection ? global::eObjectMaterialType::DEFERRED_GBUFFER_COMPACT_GAMMA
+													: global::eObjectMaterialType::DEFERRED_GBUFFER_COMPACT;
+	}
+	else if (scene.enableGammaCorrection)
+	{
+		modelMaterial = global::eObjectMaterialType::DEFERRED_GBUFFER_GAMMA;
+	}
+	ShaderProgram &currentShader = scene.shaderLibrary[lightType][modelMaterial];
+	currentShader.Use();
+	renderGeometry(scene, currentShader.getProgram());
+}
+
+// deferred lighting, straight into the back buffer or into the scene
+// color target when it has to be upscaled afterwards
+static void lightingPass(Scene &scene, unsigned int framebuffer, unsigned int clearMask)
+{
+	glState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glState::viewport(0, 0, scene.renderWidth, scene.renderHeight);
+	clearTarget(clearMask);
+	scene.lightingPassTimer.begin();
+	renderLightingPass(scene);
+	scene.lightingPassTimer.end();
+}
+
+static void upscalePass(Scene &scene, unsigned int clearMask)
+{
+	glState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+	clearTarget(clearMask);
+	glBlitNamedFramebuffer(scene.sceneColor->getFBO(), 0, 0, 0, scene.renderWidth, scene.renderHeight, 0, 0, scene.width, scene.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+}
+
+// forward passes below depth test against the G buffer's depth
+static void depthCopyPass(Scene &scene, unsigned int clearMask)
+{
+	glState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+	clearTarget(clearMask);
+	glBlitNamedFramebuffer(scene.gBufferData.gBuffer, 0, 0, 0, scene.renderWidth, scene.renderHeight, 0, 0, scene.width, scene.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+}
+
+// the physical light objects in the scene
+static void lightGizmoPass(Scene &scene, unsigned int clearMask)
+{
+	glState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState::viewport(0, 0, scene.width, scene.height);
+	clearTarget(clearMask);
+	ShaderProgram &lightShader = scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::LIGHT_COLOR];
+	lightShader.Use();
+	scene.mLightManager.draw(lightShader.getProgram());
+}
+
+static void gBufferViewPass(Scene &scene, unsigned int clearMask)
+{
+	glState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState::viewport(0, 0, scene.width, scene.height);
+	clearTarget(clearMask);
+	drawGBuffer(scene);
+}
+
+static void skyboxPass(Scene &scene, unsigned int clearMask)
+{
+	glState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState::viewport(0, 0, scene.width, scene.height);
+	clearTarget(clearMask);
+	glState::depthFunc(GL_LEQUAL);
+	ShaderProgram &skyboxProgram = scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::TEXTURE_SKYBOX];
+	skyboxProgram.Use();
+	glState::bindTexture(0, GL_TEXTURE_CUBE_MAP, scene.skyBoxTexture);
+	samplerLibrary::bind(0, samplerLibrary::CLAMPED_LINEAR);
+	int loc = glGetUniformLocation(skyboxProgram.getProgram(), "skybox");
+	glProgramUniform1i(skyboxProgram.getProgram(), loc, 0);
+	glState::bindVertexArray(scene.boxVAO);
+	glState::drawElements(GL_TRIANGLES, boxMesh.faces.size(), GL_UNSIGNED_INT);
+	glState::depthFunc(GL_LESS);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Declares the frame once: the resources, the passes and what each of
+// them reads and writes.  DrawScene only flips the enabled flags.
+void buildRenderGraph(Scene &scene)
+{
+	renderGraph &graph = scene.mRenderGraph;
+	renderPassIds &ids = scene.renderPasses;
+	const unsigned int colorAndDepth = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT;
+
+	int cascades = graph.addResource("Shadow Cascades");
+	int pointAtlas = graph.addResource("Point Shadow Atlas");
+	int gBuffer = graph.addResource("G Buffer", [&scene]() { setUPGBuffer(scene); },
+									[&scene]() { releaseGBuffer(scene); });
+	int sceneColor = graph.addResource("Scene Color", [&scene]() { setUPSceneColor(scene); },
+									   [&scene]() { releaseSceneColor(scene); });
+	int backBuffer = graph.addResource("Back Buffer");
+	graph.markOutput(backBuffer);
+
+	// the shadow passes clear only the layers they redraw themselves
+	ids.directionalShadows = graph.addPass("Directional Shadows", [&scene](unsigned int) { gatherShadowInfo(scene); });
+	graph.write(ids.directionalShadows, cascades);
+
+	ids.pointShadows = graph.addPass("Point Shadows", [&scene](unsigned int) { gatherPointShadowInfo(scene); });
+	graph.write(ids.pointShadows, pointAtlas);
+
+	int pass = graph.addPass("G Buffer", [&scene](unsigned int clearMask) { gBufferPass(scene, clearMask); });
+	graph.write(pass, gBuffer, renderGraph::RENDER_TARGET, colorAndDepth);
+
+	ids.lighting = graph.addPass("Lighting", [&scene](unsigned int clearMask) { lightingPass(scene, 0, clearMask); });
+	graph.read(ids.lighting, gBuffer);
+	graph.read(ids.lighting, cascades);
+	graph.read(ids.lighting, pointAtlas);
+	graph.write(ids.lighting, backBuffer, renderGraph::RENDER_TARGET, colorAndDepth);
+
+	ids.scaledLighting = graph.addPass("Scaled Lighting", [&scene](unsigned int clearMask) {
+		lightingPass(scene, scene.sceneColor->getFBO(), clearMask);
+	});
+	graph.read(ids.scaledLighting, gBuffer);
+	graph.read(ids.scaledLighting, cascades);
+	graph.read(ids.scaledLighting, pointAtlas);
+	graph.write(ids.scaledLighting, sceneColor, renderGraph::RENDER_TARGET, colorAndDepth);
+
+	ids.upscale = graph.addPass("Upscale", [&scene](unsigned int clearMask) { upscalePass(scene, clearMask); });
+	graph.read(ids.upscale, sceneColor, renderGraph::BLIT);
+	graph.write(ids.upscale, backBuffer, renderGraph::BLIT, colorAndDepth);
+
+	pass = graph.addPass("Depth Copy", [&scene](unsigned int clearMask) { depthCopyPass(scene, clearMask); });
+	graph.read(pass, gBuffer, renderGraph::BLIT);
+	graph.write(pass, backBuffer, renderGraph::BLIT);
+
+	pass = graph.addPass("Light Gizmos", [&scene](unsigned int clearMask) { lightGizmoPass(scene, clearMask); });
+	graph.write(pass, backBuffer);
+
+	ids.gBufferView = graph.addPass("G Buffer View", [&scene](unsigned int clearMask) { gBufferViewPass(scene, clearMask); });
+	graph.read(ids.gBufferView, gBuffer);
+	graph.write(ids.gBufferView, backBuffer);
+
+	pass = graph.addPass("Skybox", [&scene](unsigned int clearMask) { skyboxPass(scene, clearMask); });
+	graph.write(pass, backBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Camera and frame values every shader reads from the FrameConstants
+// block, written into this frame's range of the ring buffer.
+void updateFrameConstants(Scene &scene)
+{
+	PROFILE_ZONE("updateFrameConstants");
+	// no glutGet here: the headless benchmark never initializes GLUT
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t offset = 0;
+	frameConstants* constants = (frameConstants*)scene.frameDataRing.allocate(sizeof(frameConstants), offset);
+	if (!constants)
+		return;
+
+	glm::mat4 view = scene.gEditorCamera.getViewMtx();
+	glm::mat4 viewProjection = scene.perspectiveMtx * view;
+	constants->view = view;
+	constants->projection = scene.perspectiveMtx;
+	constants->viewProjection = viewProjection;
+	constants->inverseView = glm::affineInverse(view);
+	constants->inverseProjection = glm::inverse(scene.perspectiveMtx);
+	constants->inverseViewProjection = glm::inverse(viewProjection);
+	constants->cameraPos = scene.gEditorCamera.getPosition();
+	// replays step the time by a fixed amount per frame
+	if (scene.recording.mode == frameRecordingState::REPLAYING)
+		constants->time = scene.recording.time;
+	else
+		constants->time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	constants->viewport = glm::vec4((float)scene.renderWidth, (float)scene.renderHeight,
+									1.f / scene.renderWidth, 1.f / scene.renderHeight);
+	constants->frameIndex = scene.frameIndex;
+	scene.frameDataRing.bindRange(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, offset, sizeof(frameConstants));
+}
+
+// Opens gpu_timing.csv when recording is switched on, closes it when
+// it is switched off, and appends this frame's row in between.
+static void recordGpuTiming(Scene &scene)
+{
+	gpuTimingParam &timing = scene.gpuTimingParameters;
+	renderGraph &graph = scene.mRenderGraph;
+	if (!timing.recordCsv)
+	{
+		if (scene.gpuTimingCsv.is_open())
+			scene.gpuTimingCsv.close();
+		return;
+	}
+	if (!scene.gpuTimingCsv.is_open())
+	{
+		scene.gpuTimingCsv.open("gpu_timing.csv");
+		if (!scene.gpuTimingCsv)
+		{
+			printf("GPU timing: could not open gpu_timing.csv\n");
+			timing.recordCsv = false;
+			return;
+		}
+		scene.gpuTimingCsv << "frame";
+		for (int i = 0; i < graph.getPassCount(); ++i)
+			scene.gpuTimingCsv << "," << graph.getPassName(i);
+		scene.gpuTimingCsv << ",UI,Frame\n";
+		timing.rowsWritten = 0;
+	}
+	scene.gpuTimingCsv << scene.frameIndex;
+	for (int i = 0; i < graph.getPassCount(); ++i)
+		scene.gpuTimingCsv << "," << scene.renderGraphParameters.passTiming[i].lastMs;
+	scene.gpuTimingCsv << "," << timing.ui.lastMs << "," << timing.frame.lastMs << "\n";
+	++timing.rowsWritten;
 }
 
 ////////////////////////////////////////////////////////////////////////
 // Procedure DrawScene is called whenever the scene needs to be drawn.
 void DrawScene(Scene &scene)
 {    
-    // Set the viewport, and clear the screen
-    glViewport(0,0,scene.width, scene.height);
-	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT| GL_DEPTH_BUFFER_BIT);
-	CHECKERROR;
-	scene.gEditorCamera.update();
-	glm::mat4x4 viewMtx = scene.gEditorCamera.getViewMtx();
-	
-	// Calculate the inverse of the viewing matrix and send to the shader
-	glm::mat4x4 inverseViewMtx = glm::affineInverse(viewMtx);
+	// nothing to draw into while the window is minimized
+	if (scene.width <= 0 || scene.height <= 0)
+		return;
+
+	PROFILE_ZONE("DrawScene");
+	frameArena::beginFrame(scene.frameArenaParameters);
+	reserveFrameRecording(scene);
+	frameArena::beginHeapCheck();
+	// everything not in a nested stage is submission
+	frameTiming::scope submission(frameTiming::SUBMISSION);
+	GL_DEBUG_PUSH_GROUP("DrawScene");
+	scene.frameTimer.begin();
+	scene.frameDataRing.reserve(FRAME_DATA_BYTES + scene.graphicsObjectContainer.size() * getObjectConstantsStride(scene));
+	scene.frameDataRing.beginFrame(scene.frameDataRingParameters);
+	scene.mRenderTargetPool.beginFrame();
+
+	// follow the window's aspect ratio; the G buffer size is last frame's
+	if (scene.width != scene.gBufferData.width || scene.height != scene.gBufferData.height)
+	{
+		scene.perspectiveMtx = glm::perspective(scene.fovDeg, (float)scene.width / (float)scene.height,
+												scene.nearplane, scene.farplane);
+	}
+
+	// the geometry and lighting passes only cover the top-left
+	// renderWidth x renderHeight part of the render targets
+	float renderScale = scene.dynamicResolutionParameters.renderScale;
+	scene.renderWidth = glm::max(1, (int)(scene.width * renderScale));
+	scene.renderHeight = glm::max(1, (int)(scene.height * renderScale));
+	bool upscale = scene.renderWidth != scene.width || scene.renderHeight != scene.height;
 
-	scene.mLightManager.updateLightParameters(scene.pointLightParameters, scene.directionalLightParameters);
-	scene.mAmbientLight.setAmbientColor(scene.ambientLightParameters.ambientLightColor);
-	scene.mAmbientLight.setAmbientStrength(scene.ambientLightParameters.ambientLightStrength);
-	CHECKERROR;
-	// render to G BUFFER
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, scene.gBufferData.gBuffer);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		auto lightType = global::eLightingType::DEFERRED_BLINN_PHONG;
-		auto modelMaterial = global::eObjectMaterialType::DEFERRED_GBUFFER;
-		if (scene.enableGammaCorrection)
+		frameTiming::scope update(frameTiming::UPDATE);
+		updateFrameRecording(scene);
 		{
-			modelMaterial = global::eObjectMaterialType::DEFERRED_GBUFFER_GAMMA;
+			PROFILE_ZONE("camera::update");
+			scene.gEditorCamera.update();
 		}
-		ShaderProgram currentShader = scene.shaderLibrary[lightType][modelMaterial];
-		currentShader.Use();
-		int loc = glGetUniformLocation(currentShader.getProgram(), "ProjectionMatrix");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(scene.perspectiveMtx));
-		loc = glGetUniformLocation(currentShader.getProgram(), "ViewMatrix");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(viewMtx));
-		renderGeometry(scene, currentShader.getProgram());
-		currentShader.Unuse();
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
-	CHECKERROR;
-	// deferred lighting pass
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	renderLightingPass(scene);
-	CHECKERROR;
-
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, scene.gBufferData.gBuffer);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-	glBlitFramebuffer(0, 0, scene.width, scene.height, 0, 0, scene.width, scene.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	CHECKERROR;
+		{
+			PROFILE_ZONE("graphicObject::updateDrawMatrices");
+			std::vector<graphicObject> &objects = scene.graphicsObjectContainer;
+			jobSystem::parallelFor(0, (int)objects.size(), 64, [&](int begin, int end)
+			{
+				PROFILE_ZONE("graphicObject::updateDrawMatrices chunk");
+				for (int i = begin; i < end; ++i)
+					objects[i].updateDrawMatrices();
+			});
+		}
+		updateFrameConstants(scene);
+		{
+			PROFILE_ZONE("lightManager::updateLightParameters");
+			scene.mLightManager.updateLightParameters(scene.pointLightParameters, scene.directionalLightParameters);
+		}
+		scene.mAmbientLight.setAmbientColor(scene.ambientLightParameters.ambientLightColor);
+		scene.mAmbientLight.setAmbientStrength(scene.ambientLightParameters.ambientLightStrength);
 
-	// render the physical light objects in the scene
-	{
-		ShaderProgram lightShader = scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::LIGHT_COLOR];
-		lightShader.Use();
-		int loc = glGetUniformLocation(lightShader.getProgram(), "ProjectionMatrix");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(scene.perspectiveMtx));
-		loc = glGetUniformLocation(lightShader.getProgram(), "ViewMatrix");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(viewMtx));
-		scene.mLightManager.draw(lightShader.getProgram());
-		lightShader.Unuse();
+		// this frame's lights go straight into mapped memory
+		size_t lightBlockOffset = 0;
+		lightBlockData* lightBlock = (lightBlockData*)scene.frameDataRing.allocate(sizeof(lightBlockData), lightBlockOffset);
+		if (lightBlock)
+		{
+			scene.mLightManager.writeLightBlock(*lightBlock, scene.mAmbientLight);
+			scene.frameDataRing.bindRange(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, lightBlockOffset, sizeof(lightBlockData));
+		}
 	}
-	CHECKERROR;
 
-	// render the G buffer
-	if(scene.showGBuffer)
+	renderGraph &graph = scene.mRenderGraph;
+	graph.setEnabled(scene.renderPasses.directionalShadows, scene.dirShadowMap.enabled);
+	graph.setEnabled(scene.renderPasses.pointShadows, scene.pointShadowMap.enabled);
+	graph.setEnabled(scene.renderPasses.lighting, !upscale);
+	graph.setEnabled(scene.renderPasses.scaledLighting, upscale);
+	graph.setEnabled(scene.renderPasses.upscale, upscale);
+	graph.setEnabled(scene.renderPasses.gBufferView, scene.showGBuffer);
+	graph.execute(scene.renderGraphParameters);
+	// AntTweakBar draws on top of whatever is left bound
+	glState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState::viewport(0, 0, scene.width, scene.height);
+
+	// lighting pass cost against the bytes it has to read from the G buffer
+	if (scene.lightingPassTimer.hasResult() && scene.lightingPassTimer.getElapsedMs() > 0.f)
 	{
-		drawGBuffer(scene);
+		dsGBufferParam &gBuffer = scene.gBufferData;
+		gBuffer.lightingPassMs = scene.lightingPassTimer.getElapsedMs();
+		float bytesRead = (float)gBuffer.lightingBytesPerPixel * scene.renderWidth * scene.renderHeight;
+		gBuffer.lightingPassBandwidth = bytesRead / (gBuffer.lightingPassMs * 1000000.f);
 	}
-	
-	// skybox render
-	{
-		glDepthFunc(GL_LEQUAL);
-		ShaderProgram skyboxProgram = scene.shaderLibrary[global::eLightingType::NO_LIGHTING][global::eObjectMaterialType::TEXTURE_SKYBOX];
-		skyboxProgram.Use();
-		int loc = glGetUniformLocation(skyboxProgram.getProgram(), "ProjectionMatrix");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(scene.perspectiveMtx));
-		glm::mat4 skyboxView = glm::mat4(glm::mat3(viewMtx));
-		loc = glGetUniformLocation(skyboxProgram.getProgram(), "ViewMatrix");
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(skyboxView));
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, scene.skyBoxTexture);
-		loc = glGetUniformLocation(skyboxProgram.getProgram(), "skybox");
-		glUniform1i(loc, 0);
-		glBindVertexArray(scene.boxVAO);
-		glDrawElements(GL_TRIANGLES, boxMesh.faces.size(), GL_UNSIGNED_INT, 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindVertexArray(0);
-		skyboxProgram.Unuse();
-		glDepthFunc(GL_LESS);
-	}
-	CHECKERROR;
+
+	scene.mRenderTargetPool.endFrame(scene.renderTargetPoolParameters);
+	// a new target (an evicted one coming back as the render scale
+	// crosses 1, say) means the frame changed shape
+	if (scene.renderTargetPoolParameters.allocationsLastFrame > 0)
+		frameArena::resetWarmUp();
+	scene.frameTimer.end();
+	scene.frameTimer.summarize(scene.gpuTimingParameters.frame);
+	scene.uiTimer.summarize(scene.gpuTimingParameters.ui);
+	recordGpuTiming(scene);
+	scene.frameDataRing.endFrame();
+	glState::endFrame(scene.glStateParameters);
+	GL_DEBUG_POP_GROUP();
+	jobSystem::endFrame(scene.jobSystemParameters);
+	++scene.frameIndex;
+	if (scene.frameTimer.hasResult())
+		scene.mDynamicResolution.update(scene.dynamicResolutionParameters, scene.frameTimer.getElapsedMs());
+	frameArena::endHeapCheck(scene.frameArenaParameters);
 }
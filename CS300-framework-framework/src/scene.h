@@ -19,24 +19,116 @@
 #include "graphicObject.h"
 #include "lightManager.h"
 #include "fbo.h"
+#include "gpuTimer.h"
+#include "dynamicResolution.h"
+#include "cascadedShadowMap.h"
+#include "pointShadowAtlas.h"
+#include "renderTargetPool.h"
+#include "renderGraph.h"
+#include "ringBuffer.h"
+#include "glState.h"
+#include "stressScene.h"
+#include "frameRecording.h"
+#include "frameTiming.h"
+#include "framePacer.h"
+#include "onDemandRendering.h"
+#include "simulationThread.h"
+#include "jobSystem.h"
+#include "commandList.h"
+#include "frameArena.h"
 #include <vector>
+#include <fstream>
 
+// Cascaded shadows for the first directional light.
 struct directionalShadowMapParam
 {
-	int shadowMapWidth, shadowMapHeight;
-	float shadowDistance;
-	float lightFrustrumWidth, lightFrustrumHeight;
-	FBO shadowDepthMap;
+	bool enabled = true;
+	int cascadeCount = 4;
+	int resolution = 2048;
+	float shadowDistance = 500.f;
+	float splitLambda = 0.75f;      // 0 = uniform splits, 1 = logarithmic
+	bool staggerUpdates = true;
+	bool showCascades = false;
+	int cascadesRendered = 0;       // last frame
+	int castersRendered = 0;
+	cascadedShadowMap cascades;
 };
 
+// Cached omnidirectional shadows for the point lights.
+struct pointShadowMapParam
+{
+	bool enabled = true;
+	int atlasSize = 4096;
+	int minFaceSize = 64;
+	int maxFaceSize = 512;
+	int staticTilesRedrawn = 0;     // last frame
+	int shadowTilesRedrawn = 0;
+	int facesRendered = 0;
+	pointShadowAtlas atlas;
+};
+
+// The full G buffer stores position, normal and albedo as RGB16F and
+// uses a depth renderbuffer.  The compact one drops the position
+// target (rebuilt from a sampled depth texture), stores octahedral
+// normals in RG16F and albedo/specular in RGBA8.  The handles below
+// point into target while it is acquired.
 struct dsGBufferParam
 {
+	FBO* target = nullptr;          // acquired from the pool for the frame
+	fboDesc desc;                   // what is acquired, rebuilt when it changes
 	unsigned int gBuffer;
 	unsigned int gPositionTexture;
 	unsigned int gNormalTexture;
 	unsigned int gAlbedoTexture;
 	unsigned int gSpecularTexture;
 	unsigned int gDepthTexure;
+	int width = 0, height = 0;      // allocated size, follows the window
+	bool isCompact = false;
+	int bytesPerPixel = 0;          // all attachments, including depth
+	int lightingBytesPerPixel = 0;  // what the lighting pass samples
+	float lightingPassMs = 0.f;
+	float lightingPassBandwidth = 0.f;  // GB/s
+};
+
+// GPU time of the UI and the whole frame, next to the per pass timings
+// of the render graph.  While recordCsv is on, every frame appends a
+// row of the latest pass times to gpu_timing.csv.  GPU results arrive
+// a few frames late, so a row holds what was known at that frame.
+struct gpuTimingParam
+{
+	bool recordCsv = false;
+	int rowsWritten = 0;
+	timingSummary ui;
+	timingSummary frame;
+};
+
+// std140 mirror of the FrameConstants uniform block every shader
+// declares; filled once per frame right after the camera update.
+static const unsigned int FRAME_CONSTANTS_BINDING = 0;
+struct frameConstants
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::mat4 inverseView;
+	glm::mat4 inverseProjection;
+	glm::mat4 inverseViewProjection;
+	glm::vec3 cameraPos;
+	float time;                     // seconds
+	glm::vec4 viewport;             // render width, height, 1 / width, 1 / height
+	int frameIndex;
+	int padding[3];
+};
+
+// Render graph passes that are switched on and off per frame.
+struct renderPassIds
+{
+	int directionalShadows = -1;
+	int pointShadows = -1;
+	int lighting = -1;              // at window resolution
+	int scaledLighting = -1;        // below it, followed by upscale
+	int upscale = -1;
+	int gBufferView = -1;
 };
 
 class Scene
@@ -59,12 +151,15 @@ public:
     
     // Viewport
     int width, height;
+    // Part of the render targets actually drawn to this frame
+    int renderWidth, renderHeight;
 	
 	// Objects in the scene
 	unsigned int sphereVAO, sphereCount;
 	unsigned int teapotVAO, teapotCount;
 	unsigned int groundVAO, groundTexture, groundSpecular;
-	unsigned int boxVAO, boxTexture, boxSpecular;
+	unsigned int boxVAO, boxCount, boxTexture, boxSpecular;
+	float boxRadius, sphereRadius, teapotRadius;   // model space bounding spheres
 	unsigned int planeVAO, planceTexture;
 	unsigned int skyBoxTexture;
 	
@@ -87,18 +182,75 @@ public:
 	ambientLightParam ambientLightParameters;
 	lightManager mLightManager;
 	directionalShadowMapParam dirShadowMap;
+	pointShadowMapParam pointShadowMap;
 	bool showShadowDepthMap = true;
 	unsigned int quad, quadCount;
 	graphicObject quadObject;
 	dsGBufferParam gBufferData;
 	bool showGBuffer = true;
 	bool enableGammaCorrection = true;
+	bool compactGBuffer = true;
+	gpuTimer lightingPassTimer;
+	// lighting is resolved here when rendering below window resolution,
+	// then stretched onto the back buffer
+	FBO* sceneColor = nullptr;
+	fboDesc sceneColorDesc;
+	renderTargetPool mRenderTargetPool;
+	renderTargetPoolParam renderTargetPoolParameters;
+	gpuTimer frameTimer;
+	gpuTimer uiTimer;
+	gpuTimingParam gpuTimingParameters;
+	std::ofstream gpuTimingCsv;
+	dynamicResolution mDynamicResolution;
+	dynamicResolutionParam dynamicResolutionParameters;
+	renderGraph mRenderGraph;
+	renderGraphParam renderGraphParameters;
+	renderPassIds renderPasses;
+	// per-frame data streamed to the GPU (light block, ...)
+	ringBuffer frameDataRing;
+	ringBufferParam frameDataRingParameters;
+	int frameIndex = 0;
+	glStateParam glStateParameters;
+	stressSceneState stressScene;
+	frameRecordingState recording;
+	frameTimingParam frameTimingParameters;
+	framePacingParam framePacingParameters;
+	onDemandParam onDemandParameters;
+	simulationParam simulationParameters;
+	simulationThread simulation;
+	jobSystemParam jobSystemParameters;
+	// G buffer draw order: sort keys with the object index in the low
+	// bits, as generated in arena frame drawKeysFrame, and sorted
+	const unsigned long long* drawKeys = nullptr;
+	int drawKeyCount = 0;
+	unsigned int drawKeysFrame = 0;
+	std::vector<unsigned long long> sortedDrawKeys;
+	// G buffer commands, a list per chunk of the draw order
+	std::vector<commandList> geometryCommands;
+	commandRecordingParam commandRecordingParameters;
+	frameArenaParam frameArenaParameters;
 };
 void renderGeometry(Scene &scene, unsigned int shader);
 void gatherShadowInfo(Scene &scene);
+void gatherPointShadowInfo(Scene &scene);
 void setUPGBuffer(Scene &scene);
+void releaseGBuffer(Scene &scene);
+void setUPSceneColor(Scene &scene);
+void releaseSceneColor(Scene &scene);
 void renderLightingPass(Scene &scene);
 void drawGBuffer(Scene &scene);
+void buildRenderGraph(Scene &scene);
+void updateFrameConstants(Scene &scene);
+// An image decoded off the GL thread, waiting for its upload.
+struct decodedImage
+{
+	const char* path;
+	unsigned char* pixels;
+	int width, height;
+};
+void decodeImage(decodedImage &image);
+unsigned int uploadTexture(decodedImage &image);
+unsigned int uploadCube(decodedImage* faces, unsigned int count);
 unsigned int loadTexture(const char* path);
 unsigned int loadCube(const std::vector<const char*> &facePath);
 void InitializeScene(Scene &scene);
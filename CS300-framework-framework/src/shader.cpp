@@ -12,7 +12,11 @@
 
 #include "shader.h"
 #include <fstream>
-#include "GL\glew.h"
+#include <cstring>
+#include "GL/glew.h"
+#include "glState.h"
+#include "glDebug.h"
+#include "profiler.h"
 #include <GL/freeglut.h>
 // Reads a specified file into a string and returns the string.
 char* ReadFile(const char* name)
@@ -40,26 +44,36 @@ void ShaderProgram::CreateProgram()
 // Use a shader program
 void ShaderProgram::Use()
 {
-    glUseProgram(program);
-}
-
-// Done using a shader program
-void ShaderProgram::Unuse()
-{
-    glUseProgram(0);
+    glState::useProgram(program);
 }
 
 // Read, send to OpenGL, and compile a single file into a shader program.
-void ShaderProgram::CreateShader(const char* fileName, int type)
+// Optional defines (e.g. "#define COMPACT_GBUFFER\n") are spliced in
+// right after the #version line so one file can build several variants.
+void ShaderProgram::CreateShader(const char* fileName, int type, const char* defines)
 {
+    PROFILE_ZONE("ShaderProgram::CreateShader");
     // Read the source from the named file
     char* src = ReadFile(fileName);
-    const char* psrc[1] = {src};
+    const char* psrc[3] = {src, "", src};
+    int lengths[3] = {0, -1, -1};
+    if (defines != nullptr) {
+        const char* eol = strchr(src, '\n');
+        if (strncmp(src, "#version", 8) == 0 && eol != nullptr) {
+            lengths[0] = (int)(eol - src) + 1;
+            psrc[2] = eol + 1;
+        }
+        psrc[1] = defines;
+    }
 
     // Create a shader and attach, hand it the source, and compile it.
     int shader = glCreateShader(type);
+    GL_DEBUG_LABEL(GL_SHADER, shader, fileName);
+    // a program is known by its fragment shader
+    if (type == GL_FRAGMENT_SHADER)
+        GL_DEBUG_LABEL(GL_PROGRAM, program, fileName);
     glAttachShader(program, shader);
-    glShaderSource(shader, 1, psrc, NULL);
+    glShaderSource(shader, 3, psrc, lengths);
     glCompileShader(shader);
     delete src;
 
@@ -80,6 +94,7 @@ void ShaderProgram::CreateShader(const char* fileName, int type)
 
 void ShaderProgram::LinkProgram()
 {
+    PROFILE_ZONE("ShaderProgram::LinkProgram");
     // Link program and check the status
     glLinkProgram(program);
     int status;
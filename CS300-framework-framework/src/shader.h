@@ -4,7 +4,7 @@
 // and pixel shader code, and a method to link the result.  When
 // loaded (method "Use"), its vertex shader and pixel shader will be
 // invoked for all geometry passing through the graphics pipeline.
-// When done, unload it with method "Unuse".
+// It stays loaded until another program is used.
 //
 // Copyright 2013 DigiPen Institute of Technology
 ////////////////////////////////////////////////////////////////////////
@@ -15,10 +15,9 @@ class ShaderProgram
 public:
     
     void CreateProgram();
-    void CreateShader(const char* fileName, const int type);
+    void CreateShader(const char* fileName, const int type, const char* defines = nullptr);
     void LinkProgram();
     void Use();
-    void Unuse();
 	int getProgram();
 private:
 	int program;
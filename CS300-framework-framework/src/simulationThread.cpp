@@ -0,0 +1,230 @@
+#include "shader.h"
+#include "fbo.h"
+#include "scene.h"
+#include "simulationThread.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+simulationThread::simulationThread() : running(false)
+{
+
+}
+
+simulationThread::~simulationThread()
+{
+	stop();
+}
+
+void simulationThread::start(Scene& scene)
+{
+	if (isRunning())
+		return;
+	simulationParam& param = scene.simulationParameters;
+	tickRate = glm::max(param.tickRate, 1.f);
+	tick = 0;
+	simCamera = scene.gEditorCamera;
+	objectPaths.clear();
+	lightPaths.clear();
+	if (scene.stressScene.active)
+	{
+		objectPaths = scene.stressScene.objectPaths;
+		lightPaths = scene.stressScene.lightPaths;
+	}
+	lightVersion = 0;
+	lightEdit = 0;
+	pointLights = scene.pointLightParameters;
+	directionalLights = scene.directionalLightParameters;
+	ambient = scene.ambientLightParameters;
+	pending = inbox();
+	received = inbox();
+
+	appliedTick = -1;
+	appliedCameraVersion = simCamera.getVersion();
+	appliedLightVersion = lightVersion;
+	postedLightEdit = lightEdit;
+	appliedPointLights = pointLights;
+	appliedDirectionalLights = directionalLights;
+	appliedAmbient = ambient;
+	tickTimes.initialize(HISTORY_SIZE);
+
+	param.threaded = true;
+	running.store(true, std::memory_order_release);
+	thread = std::thread(&simulationThread::run, this);
+}
+
+void simulationThread::stop()
+{
+	if (!isRunning())
+		return;
+	running.store(false, std::memory_order_release);
+	thread.join();
+}
+
+bool simulationThread::isRunning()
+{
+	return thread.joinable();
+}
+
+void simulationThread::postCameraInput(float orbitX, float orbitY, const glm::vec2& pan, float zoom)
+{
+	std::lock_guard<std::mutex> lock(inboxLock);
+	pending.orbitX += orbitX;
+	pending.orbitY += orbitY;
+	pending.pan += pan;
+	pending.zoom += zoom;
+}
+
+// Light parameters are plain floats, so memcmp finds any edit.
+template <class T>
+static bool sameParameters(const std::vector<T>& a, const std::vector<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+bool simulationThread::sync(Scene& scene)
+{
+	PROFILE_ZONE("simulationThread::sync");
+	if (!sameParameters(scene.pointLightParameters, appliedPointLights) ||
+		!sameParameters(scene.directionalLightParameters, appliedDirectionalLights) ||
+		memcmp(&scene.ambientLightParameters, &appliedAmbient, sizeof(ambientLightParam)) != 0)
+	{
+		appliedPointLights = scene.pointLightParameters;
+		appliedDirectionalLights = scene.directionalLightParameters;
+		appliedAmbient = scene.ambientLightParameters;
+		++postedLightEdit;
+		std::lock_guard<std::mutex> lock(inboxLock);
+		pending.hasLights = true;
+		pending.lightEdit = postedLightEdit;
+		pending.pointLights = scene.pointLightParameters;
+		pending.directionalLights = scene.directionalLightParameters;
+		pending.ambient = scene.ambientLightParameters;
+	}
+
+	if (!snapshots.acquire())
+		return false;
+	const sceneSnapshot& snapshot = snapshots.getFront();
+	if (snapshot.cameraVersion != appliedCameraVersion)
+	{
+		scene.gEditorCamera.initialize(snapshot.cameraPosition, snapshot.cameraLookAt);
+		appliedCameraVersion = snapshot.cameraVersion;
+	}
+
+	for (const objectTransform& transform : snapshot.objects)
+	{
+		graphicObject& object = scene.graphicsObjectContainer[transform.index];
+		glm::vec3 rotation = transform.rotation;
+		object.setPosition(transform.position);
+		object.setRotation(rotation);
+	}
+
+	// copied element by element: the tweak bars point into the vectors,
+	// which must not reallocate
+	if (snapshot.lightVersion != appliedLightVersion && snapshot.lightEdit == postedLightEdit &&
+		snapshot.pointLights.size() == scene.pointLightParameters.size() &&
+		snapshot.directionalLights.size() == scene.directionalLightParameters.size())
+	{
+		std::copy(snapshot.pointLights.begin(), snapshot.pointLights.end(), scene.pointLightParameters.begin());
+		std::copy(snapshot.directionalLights.begin(), snapshot.directionalLights.end(), scene.directionalLightParameters.begin());
+		scene.ambientLightParameters = snapshot.ambient;
+		appliedPointLights = snapshot.pointLights;
+		appliedDirectionalLights = snapshot.directionalLights;
+		appliedAmbient = snapshot.ambient;
+		appliedLightVersion = snapshot.lightVersion;
+	}
+
+	simulationParam& param = scene.simulationParameters;
+	if (appliedTick >= 0)
+		param.snapshotsDropped += snapshot.tick - appliedTick - 1;
+	appliedTick = snapshot.tick;
+	param.ticks = snapshot.tick + 1;
+	++param.snapshotsApplied;
+	tickTimes.add(snapshot.tickMs);
+	if (param.snapshotsApplied % 8 == 0)
+		tickTimes.summarize(param.tick);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Ticks on a fixed grid; after a stall (a debugger, the process
+// swapped out) it starts over from now instead of rushing out the
+// missed ticks.  The simulated time is the tick count over the rate.
+void simulationThread::run()
+{
+	PROFILE_THREAD_NAME("Simulation");
+	typedef std::chrono::steady_clock clock;
+	clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+	clock::time_point next = clock::now();
+	while (running.load(std::memory_order_acquire))
+	{
+		simulate();
+		next += period;
+		clock::time_point now = clock::now();
+		if (now > next + period)
+			next = now;
+		std::this_thread::sleep_until(next);
+	}
+}
+
+void simulationThread::simulate()
+{
+	PROFILE_ZONE("simulationThread::simulate");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock(inboxLock);
+		std::swap(pending, received);
+		pending.orbitX = pending.orbitY = pending.zoom = 0.f;
+		pending.pan = glm::vec2();
+		pending.hasLights = false;
+	}
+
+	if (received.orbitX != 0.f || received.orbitY != 0.f)
+	{
+		simCamera.horizontalMove(received.orbitX);
+		simCamera.verticalMove(received.orbitY);
+	}
+	if (received.pan != glm::vec2())
+		simCamera.setPanDir(received.pan);
+	if (received.zoom != 0.f)
+		simCamera.zoom(received.zoom);
+	if (received.hasLights && received.pointLights.size() == pointLights.size() &&
+		received.directionalLights.size() == directionalLights.size())
+	{
+		pointLights = received.pointLights;
+		directionalLights = received.directionalLights;
+		ambient = received.ambient;
+		++lightVersion;
+	}
+	// a post of the wrong shape is dropped, but still answered
+	if (received.hasLights)
+		lightEdit = received.lightEdit;
+
+	float time = tick / tickRate;
+	for (const stressScenePath& path : lightPaths)
+		pointLights[path.index].pointLightPosition = getStressLightPosition(path, time);
+	if (!lightPaths.empty())
+		++lightVersion;
+
+	sceneSnapshot& snapshot = snapshots.getBack();
+	snapshot.tick = tick;
+	snapshot.time = time;
+	snapshot.cameraVersion = simCamera.getVersion();
+	snapshot.cameraPosition = simCamera.getPosition();
+	snapshot.cameraLookAt = simCamera.getLookAt();
+	snapshot.objects.resize(objectPaths.size());
+	for (size_t i = 0; i < objectPaths.size(); ++i)
+	{
+		objectTransform& transform = snapshot.objects[i];
+		transform.index = objectPaths[i].index;
+		getStressObjectPose(objectPaths[i], time, transform.position, transform.rotation);
+	}
+	snapshot.lightVersion = lightVersion;
+	snapshot.lightEdit = lightEdit;
+	snapshot.pointLights = pointLights;
+	snapshot.directionalLights = directionalLights;
+	snapshot.ambient = ambient;
+	snapshot.tickMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	snapshots.publish();
+	++tick;
+}
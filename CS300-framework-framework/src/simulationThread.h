@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////
+// Runs the scene's simulation on its own thread at a fixed tick, so it
+// overlaps the render thread's submission instead of adding to it.
+// The simulation owns copies of what it updates: the camera, the
+// lights and the stress scene's moving objects (see stressScene.h).
+// Every tick it writes them into a sceneSnapshot and publishes it
+// through a lock-free triple buffer (tripleBuffer.h).  The render
+// thread only picks up the latest snapshot in sync and writes it into
+// the scene before drawing.  Snapshots it was too slow for are
+// dropped and counted.
+//
+// The render thread talks back through a small locked inbox.
+// postCameraInput queues camera moves, and sync posts light
+// parameters that the tweak bars (or a replay) changed since the last
+// snapshot was applied.  The simulation adopts both on its next tick.
+// Light posts are numbered and snapshots echo the last one adopted;
+// snapshot lights older than the latest post are not applied, so an
+// edit is not reverted while it is on its way.
+//
+// The camera and the lights only reach the scene when their version
+// changes, so an idle simulation leaves the scene alone and
+// on-demand rendering keeps skipping frames.  A running frame
+// recording still drives the camera and lights from DrawScene, after
+// the snapshot.  Input latency, as framePacer measures it, stops at
+// the post; the move shows up to one tick later.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "tripleBuffer.h"
+#include "lightManager.h"
+#include "camera.h"
+#include "stressScene.h"
+#include "rollingStats.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Scene;
+
+struct objectTransform
+{
+	unsigned int index;             // into graphicsObjectContainer
+	glm::vec3 position;
+	glm::vec3 rotation;
+};
+
+// Written by the simulation, read-only once published.
+struct sceneSnapshot
+{
+	int tick = -1;
+	float time = 0.f;               // simulated seconds
+	float tickMs = 0.f;             // what the tick cost
+	unsigned int cameraVersion = 0;
+	glm::vec3 cameraPosition;
+	glm::vec3 cameraLookAt;
+	std::vector<objectTransform> objects;   // only the moving ones
+	unsigned int lightVersion = 0;
+	unsigned int lightEdit = 0;     // last light post adopted
+	pointLightParamContainter pointLights;
+	directionLightParamContainter directionalLights;
+	ambientLightParam ambient;
+};
+
+struct simulationParam
+{
+	bool threaded = false;          // started with the simulation thread
+	float tickRate = 60.f;          // ticks per second, read when it starts
+	int ticks = 0;                  // latest snapshot applied
+	int snapshotsApplied = 0;
+	int snapshotsDropped = 0;       // published, then overwritten unseen
+	timingSummary tick;             // simulation cost per tick
+};
+
+class simulationThread
+{
+public:
+	static const int HISTORY_SIZE = 240;
+
+	simulationThread();
+	~simulationThread();
+	// Copies what it simulates out of the scene, then starts ticking.
+	void start(Scene& scene);
+	void stop();
+	bool isRunning();
+	// render thread
+	void postCameraInput(float orbitX, float orbitY, const glm::vec2& pan, float zoom);
+	// Posts the tweak bar edits, then applies the latest snapshot;
+	// false when there was none.
+	bool sync(Scene& scene);
+private:
+	struct inbox
+	{
+		float orbitX = 0.f, orbitY = 0.f;
+		glm::vec2 pan;
+		float zoom = 0.f;
+		bool hasLights = false;
+		unsigned int lightEdit = 0;
+		pointLightParamContainter pointLights;
+		directionLightParamContainter directionalLights;
+		ambientLightParam ambient;
+	};
+
+	void run();
+	void simulate();
+
+	std::thread thread;
+	std::atomic<bool> running;
+	float tickRate = 60.f;
+	tripleBuffer<sceneSnapshot> snapshots;
+	std::mutex inboxLock;
+	inbox pending;
+	inbox received;                 // simulation side, swapped with pending
+
+	// simulation thread
+	int tick = 0;
+	camera simCamera;
+	std::vector<stressScenePath> objectPaths;
+	std::vector<stressScenePath> lightPaths;
+	unsigned int lightVersion = 0;
+	unsigned int lightEdit = 0;
+	pointLightParamContainter pointLights;
+	directionLightParamContainter directionalLights;
+	ambientLightParam ambient;
+
+	// render thread: what the last applied snapshot left the scene at
+	int appliedTick = -1;
+	unsigned int appliedCameraVersion = 0;
+	unsigned int appliedLightVersion = 0;
+	unsigned int postedLightEdit = 0;
+	pointLightParamContainter appliedPointLights;
+	directionLightParamContainter appliedDirectionalLights;
+	ambientLightParam appliedAmbient;
+	rollingStats tickTimes;
+};
@@ -0,0 +1,234 @@
+#include "shader.h"
+#include "fbo.h"
+#include "scene.h"
+#include "stressScene.h"
+#include "glDebug.h"
+#include "profiler.h"
+#include "GL/glew.h"
+#include <random>
+
+static const int COLOR_COUNT = 8;
+static const float TWO_PI = 6.2831853f;
+
+// mt19937 output is fixed by the standard, the distributions are not,
+// so the conversion to [0, 1) is done by hand
+static float nextFloat(std::mt19937 &random)
+{
+	return (random() >> 8) * (1.f / 16777216.f);
+}
+
+static float nextFloat(std::mt19937 &random, float low, float high)
+{
+	return low + (high - low) * nextFloat(random);
+}
+
+// Index of the weight the draw falls into; the weights need not add up to 1.
+static int pickWeighted(std::mt19937 &random, const float *weights, int count)
+{
+	float total = 0.f;
+	for (int i = 0; i < count; ++i)
+		total += glm::max(weights[i], 0.f);
+	float draw = nextFloat(random) * total;
+	for (int i = 0; i < count; ++i)
+	{
+		draw -= glm::max(weights[i], 0.f);
+		if (draw < 0.f)
+			return i;
+	}
+	return count - 1;
+}
+
+static glm::vec3 hueColor(float hue)
+{
+	glm::vec3 color = glm::abs(glm::fract(glm::vec3(hue) + glm::vec3(1.f, 2.f / 3.f, 1.f / 3.f)) * 6.f - glm::vec3(3.f)) - glm::vec3(1.f);
+	return glm::clamp(color, glm::vec3(0.f), glm::vec3(1.f));
+}
+
+static unsigned int createFlatTexture(const glm::vec3 &color)
+{
+	unsigned char texel[4] = { (unsigned char)(color.r * 255.f), (unsigned char)(color.g * 255.f),
+							   (unsigned char)(color.b * 255.f), 255 };
+	unsigned int texture;
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+	glTextureStorage2D(texture, 1, GL_RGBA8, 1, 1);
+	glTextureSubImage2D(texture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+	return texture;
+}
+
+void releaseStressScene(Scene &scene)
+{
+	stressSceneState &state = scene.stressScene;
+	for (unsigned int texture : state.colorTextures)
+	{
+		glState::onDeleteTexture(texture);
+		glDeleteTextures(1, &texture);
+	}
+	state.colorTextures.clear();
+	state.objectPaths.clear();
+	state.lightPaths.clear();
+	state.active = false;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Everything but the ground and the directional light is replaced.
+// Objects are scattered over a square sized so that they sit about
+// desc.spacing apart, with sizes between a quarter and three quarters
+// of that spacing.
+void buildStressScene(Scene &scene, const stressSceneDesc &desc)
+{
+	PROFILE_ZONE("buildStressScene");
+	releaseStressScene(scene);
+	stressSceneState &state = scene.stressScene;
+	state.desc = desc;
+	state.desc.objectCount = glm::clamp(desc.objectCount, 0, (int)stressSceneDesc::MAX_OBJECTS);
+	state.desc.pointLightCount = glm::clamp(desc.pointLightCount, 0, (int)stressSceneDesc::MAX_POINT_LIGHTS);
+	state.active = true;
+	const stressSceneDesc &d = state.desc;
+	std::mt19937 random(d.seed);
+
+	for (int i = 0; i < COLOR_COUNT; ++i)
+	{
+		state.colorTextures.push_back(createFlatTexture(hueColor((float)i / COLOR_COUNT)));
+		GL_DEBUG_LABEL(GL_TEXTURE, state.colorTextures.back(), "Stress Color");
+	}
+	state.colorTextures.push_back(createFlatTexture(glm::vec3(0.5f)));
+	GL_DEBUG_LABEL(GL_TEXTURE, state.colorTextures.back(), "Stress Specular");
+
+	float side = d.spacing * glm::sqrt((float)glm::max(d.objectCount, 1));
+	float half = side * 0.5f;
+	std::vector<graphicObject> &objects = scene.graphicsObjectContainer;
+	objects.erase(objects.begin() + 1, objects.end());
+	objects.reserve(d.objectCount + 1);
+	glm::vec3 groundScale(glm::max(250.f, side * 1.1f), 1.f, glm::max(250.f, side * 1.1f));
+	objects[0].setScale(groundScale);
+
+	const unsigned int meshes[] = { scene.boxVAO, scene.sphereVAO, scene.teapotVAO };
+	const unsigned int indexCounts[] = { scene.boxCount, scene.sphereCount, scene.teapotCount };
+	const float radii[] = { scene.boxRadius, scene.sphereRadius, scene.teapotRadius };
+	const float meshWeights[] = { d.boxWeight, d.sphereWeight, d.teapotWeight };
+	const float materialWeights[] = { d.crateWeight, d.groundWeight, d.colorWeight };
+	for (int i = 0; i < d.objectCount; ++i)
+	{
+		int mesh = pickWeighted(random, meshWeights, 3);
+		float size = nextFloat(random, 0.25f, 0.75f) * d.spacing * 0.5f;
+		glm::vec3 position(nextFloat(random, -half, half), size, nextFloat(random, -half, half));
+		// the teapot is modelled z up
+		glm::vec3 rotation(mesh == 2 ? -TWO_PI * 0.25f : 0.f, nextFloat(random, 0.f, TWO_PI), 0.f);
+		float scale = size / radii[mesh];
+
+		graphicObject object(position, rotation, glm::vec3(scale), meshes[mesh], indexCounts[mesh]);
+		object.setBoundingRadius(radii[mesh]);
+		object.setIsShadowCaster(true);
+		object.setIsShadowReceiver(true);
+		object.setMaterialShininess(nextFloat(random, 16.f, 255.f));
+		switch (pickWeighted(random, materialWeights, 3))
+		{
+		case 0:
+			object.setTextureMap(scene.boxTexture);
+			object.setSpecularMap(scene.boxSpecular);
+			break;
+		case 1:
+			object.setTextureMap(scene.groundTexture);
+			object.setSpecularMap(scene.groundSpecular);
+			break;
+		default:
+			object.setTextureMap(state.colorTextures[random() % COLOR_COUNT]);
+			object.setSpecularMap(state.colorTextures[COLOR_COUNT]);
+			break;
+		}
+
+		if (nextFloat(random) < d.movingShare)
+		{
+			object.setIsStatic(false);
+			stressScenePath path;
+			path.index = (unsigned int)objects.size();
+			path.base = position;
+			path.rotation = rotation;
+			path.radius = nextFloat(random, 0.25f, 1.f) * d.spacing;
+			path.phase = nextFloat(random, 0.f, TWO_PI);
+			path.angularSpeed = nextFloat(random, 0.25f, 1.f) * d.speed;
+			state.objectPaths.push_back(path);
+		}
+		objects.push_back(object);
+	}
+
+	// lights ride higher than the tallest object; every one gets a gizmo,
+	// only the first MAX_SHADER_LIGHTS get a slot in the light block
+	scene.pointLightContainer.clear();
+	scene.pointLightParameters.clear();
+	scene.pointLightContainer.reserve(d.pointLightCount);
+	scene.pointLightParameters.reserve(d.pointLightCount);
+	for (int i = 0; i < d.pointLightCount; ++i)
+	{
+		glm::vec3 position(nextFloat(random, -half, half), nextFloat(random, 1.f, 2.f) * d.spacing, nextFloat(random, -half, half));
+		glm::vec3 color = hueColor(nextFloat(random));
+
+		pointLightParam param;
+		param.pointLightPosition = position;
+		param.pointLightDiffuse = color;
+		param.pointLightSpecular = color;
+		param.pointLightAttenuationDistance = 160.f;
+		param.pointLightAttenuationConstanst = 1.f;
+		param.pointLightAttenuationLinear = 0.027f;
+		param.pointLightAttenuationQuadratic = 0.0028f;
+
+		pointLight light(position, scene.boxVAO, scene.boxCount, color, color);
+		light.setLightIndex(i < MAX_SHADER_LIGHTS ? i : -1);
+		light.setAttenuationParameters(param.pointLightAttenuationDistance, param.pointLightAttenuationConstanst,
+									   param.pointLightAttenuationLinear, param.pointLightAttenuationQuadratic);
+		scene.pointLightContainer.push_back(light);
+		scene.pointLightParameters.push_back(param);
+
+		stressScenePath path;
+		path.index = (unsigned int)i;
+		path.base = position;
+		path.rotation = glm::vec3();
+		path.radius = nextFloat(random, 0.5f, 2.f) * d.spacing;
+		path.phase = nextFloat(random, 0.f, TWO_PI);
+		path.angularSpeed = nextFloat(random, 0.25f, 1.f) * d.speed;
+		state.lightPaths.push_back(path);
+	}
+	scene.mLightManager = lightManager(scene.pointLightContainer, scene.directionalLightContainer);
+
+	// look at the middle of the field from far enough to see most of it
+	scene.gEditorCamera.initialize(glm::vec3(0.f, half * 0.5f + 50.f, -half - 100.f), glm::vec3(0.f));
+}
+
+////////////////////////////////////////////////////////////////////////
+// Objects circle their start position while bobbing up and down and
+// turning to follow the path; lights circle theirs.  Only depends on
+// the time, never on the previous frame.
+void getStressObjectPose(const stressScenePath &path, float seconds, glm::vec3 &position, glm::vec3 &rotation)
+{
+	float angle = path.phase + path.angularSpeed * seconds;
+	position = path.base + glm::vec3(glm::cos(angle) * path.radius,
+									 glm::abs(glm::sin(angle * 2.f)) * path.radius * 0.25f,
+									 glm::sin(angle) * path.radius);
+	rotation = path.rotation + glm::vec3(0.f, angle, 0.f);
+}
+
+glm::vec3 getStressLightPosition(const stressScenePath &path, float seconds)
+{
+	float angle = path.phase + path.angularSpeed * seconds;
+	return path.base + glm::vec3(glm::cos(angle) * path.radius, 0.f, glm::sin(angle) * path.radius);
+}
+
+void animateStressScene(Scene &scene, float seconds)
+{
+	stressSceneState &state = scene.stressScene;
+	if (!state.active)
+		return;
+	PROFILE_ZONE("animateStressScene");
+
+	for (const stressScenePath &path : state.objectPaths)
+	{
+		glm::vec3 position, rotation;
+		getStressObjectPose(path, seconds, position, rotation);
+		graphicObject &object = scene.graphicsObjectContainer[path.index];
+		object.setPosition(position);
+		object.setRotation(rotation);
+	}
+
+	for (const stressScenePath &path : state.lightPaths)
+		scene.pointLightParameters[path.index].pointLightPosition = getStressLightPosition(path, seconds);
+}
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////
+// Builds large, reproducible scenes for scaling measurements: up to a
+// million boxes, spheres and teapots over a ground plane that grows
+// with them, and up to ten thousand point lights floating above.
+// Every choice comes from a seeded Mersenne Twister, so a description
+// and seed give the same scene on every machine and compiler.
+//
+// Objects use the crate or ground material or a flat color in any
+// mix.  A share of the objects and every light move along scripted
+// paths that only depend on the time passed in, so replays at a fixed
+// step are identical.  Only the first MAX_SHADER_LIGHTS point lights
+// reach the lighting shaders; the rest still cost their CPU update
+// and gizmo draw.
+//
+// The generated scene replaces the default objects and point lights,
+// so build it before anything keeps pointers into those containers
+// (the tweak bars do).
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "glm/glm.hpp"
+#include <vector>
+
+class Scene;
+
+struct stressSceneDesc
+{
+	static const int MAX_OBJECTS = 1000000;
+	static const int MAX_POINT_LIGHTS = 10000;
+	unsigned int seed = 1;
+	int objectCount = 1000;
+	int pointLightCount = 32;
+	// relative weights of the meshes and materials, zero leaves one out
+	float boxWeight = 1.f;
+	float sphereWeight = 1.f;
+	float teapotWeight = 1.f;
+	float crateWeight = 1.f;
+	float groundWeight = 1.f;
+	float colorWeight = 1.f;
+	float spacing = 12.f;           // average distance between neighbours
+	float movingShare = 0.25f;      // of the objects; lights always move
+	float speed = 1.f;              // scales every path
+};
+
+struct stressScenePath
+{
+	unsigned int index;             // object or light
+	glm::vec3 base;
+	glm::vec3 rotation;
+	float radius;
+	float phase;
+	float angularSpeed;             // radians per second
+};
+
+struct stressSceneState
+{
+	bool active = false;
+	stressSceneDesc desc;
+	std::vector<stressScenePath> objectPaths;
+	std::vector<stressScenePath> lightPaths;
+	std::vector<unsigned int> colorTextures;   // flat colors, last one is the specular map
+};
+
+void buildStressScene(Scene &scene, const stressSceneDesc &desc);
+void animateStressScene(Scene &scene, float seconds);
+// Where a path puts its object or light at the given time; also used
+// by the simulation thread (simulationThread.h).
+void getStressObjectPose(const stressScenePath &path, float seconds, glm::vec3 &position, glm::vec3 &rotation);
+glm::vec3 getStressLightPosition(const stressScenePath &path, float seconds);
+void releaseStressScene(Scene &scene);
@@ -3,8 +3,7 @@
 namespace global
 {
 	float timer::mDt;
-	float timer::mPreviousTime;
-	float timer::mFPS;
+	std::chrono::steady_clock::time_point timer::mPreviousTime;
 
 	timer::timer()
 	{
@@ -14,19 +13,16 @@ namespace global
 	{
 	}
 
-	void timer::initializeTimer(float t)
+	void timer::initializeTimer()
 	{
 		mDt = 0.0;
-		mPreviousTime = t;
-		mFPS = 0.0;
+		mPreviousTime = std::chrono::steady_clock::now();
 	}
 
-	void timer::updateTimer(float t)
+	void timer::updateTimer()
 	{
-		float currentTIme = t;
-		mDt = currentTIme - mPreviousTime;
-		mFPS = 1.f / mDt;
-		mPreviousTime = currentTIme;
+		std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+		mDt = std::chrono::duration<float>(currentTime - mPreviousTime).count();
+		mPreviousTime = currentTime;
 	}
 }
-
@@ -1,18 +1,21 @@
 #pragma once
 
+#include <chrono>
+
 namespace global
 {
+	// Seconds between the last two updates, on steady_clock; scales the
+	// mouse input.  Frame statistics are in frameTiming.
 	class timer
 	{
 	public:
-		static void initializeTimer(float t);
-		static void updateTimer(float t);
+		static void initializeTimer();
+		static void updateTimer();
 		static float mDt;
-		static float mFPS;
 	private:
 		timer();
 		~timer();	
-		static float mPreviousTime;
+		static std::chrono::steady_clock::time_point mPreviousTime;
 		
 	};
 }
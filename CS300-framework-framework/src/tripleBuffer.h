@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////
+// Lock-free hand-over of a value from one producer thread to one
+// consumer thread.  Of the three slots, the producer owns the back one
+// and the consumer the front one; the middle one holds the latest
+// published value.  publish swaps the back slot with the middle one,
+// acquire swaps the middle slot with the front one if something was
+// published since.  Neither side ever waits or copies, the producer
+// never writes what the consumer reads, and values the consumer was
+// too slow for are overwritten.
+//
+// The slots are reused, so a value with vectors inside stops
+// allocating once their capacities have settled.
+////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+
+template <class T>
+class tripleBuffer
+{
+public:
+	tripleBuffer() : middle(1), front(0), back(2)
+	{
+
+	}
+
+	// producer
+	T& getBack()
+	{
+		return slots[back];
+	}
+
+	void publish()
+	{
+		back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// consumer; false when nothing was published since the last call
+	bool acquire()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & FRESH))
+			return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	const T& getFront()
+	{
+		return slots[front];
+	}
+
+private:
+	static const unsigned int INDEX = 3;
+	static const unsigned int FRESH = 4;    // the middle slot was not acquired yet
+	T slots[3];
+	std::atomic<unsigned int> middle;
+	unsigned int front;
+	unsigned int back;
+};